@@ -0,0 +1,84 @@
+// arena.cpp
+#include "arena.h"
+#include <cstdint>
+#include <cstdlib>
+
+using namespace std;
+
+// Los bloques crecen al doble hasta este tamaño
+static const size_t kMaxChunk = 1024 * 1024;
+
+Arena::Arena(size_t firstChunk) : nextChunk_(firstChunk) {}
+
+Arena::~Arena() {
+  // 1) destructores pendientes, en orden inverso de creación
+  for (Finalizer *f = finalizers_; f; f = f->next)
+    f->destroy(f->obj);
+  // 2) liberar los bloques
+  while (head_) {
+    Chunk *next = head_->next;
+    free(head_);
+    head_ = next;
+  }
+}
+
+void Arena::reset() {
+  for (Finalizer *f = finalizers_; f; f = f->next)
+    f->destroy(f->obj);
+  finalizers_ = nullptr;
+  // Se queda el bloque más grande, que no siempre es el último: un pedido
+  // que no entra en el bloque que toca crea uno a su medida
+  Chunk *keep = head_;
+  for (Chunk *c = head_; c; c = c->next)
+    if (c->size > keep->size)
+      keep = c;
+  while (head_) {
+    Chunk *next = head_->next;
+    if (head_ != keep)
+      free(head_);
+    head_ = next;
+  }
+  head_ = keep;
+  if (head_)
+    head_->next = nullptr;
+  cur_ = head_ ? reinterpret_cast<char *>(head_ + 1) : nullptr;
+  end_ = head_ ? cur_ + head_->size : nullptr;
+  objects_ = used_ = 0;
+  reserved_ = head_ ? head_->size : 0;
+  chunks_ = head_ ? 1 : 0;
+}
+
+void Arena::newChunk(size_t minSize) {
+  size_t size = nextChunk_;
+  while (size < minSize)
+    size *= 2;
+  if (nextChunk_ < kMaxChunk)
+    nextChunk_ *= 2;
+
+  Chunk *c = static_cast<Chunk *>(malloc(sizeof(Chunk) + size));
+  if (!c)
+    throw bad_alloc();
+  c->next = head_;
+  c->size = size;
+  head_ = c;
+  cur_ = reinterpret_cast<char *>(c + 1);
+  end_ = cur_ + size;
+  reserved_ += size;
+  chunks_++;
+}
+
+void *Arena::allocate(size_t size, size_t align) {
+  uintptr_t p = (reinterpret_cast<uintptr_t>(cur_) + align - 1) & ~(align - 1);
+  if (!cur_ || p + size > reinterpret_cast<uintptr_t>(end_)) {
+    newChunk(size + align);
+    p = (reinterpret_cast<uintptr_t>(cur_) + align - 1) & ~(align - 1);
+  }
+  used_ += size;
+  cur_ = reinterpret_cast<char *>(p + size);
+  return reinterpret_cast<void *>(p);
+}
+
+void Arena::addFinalizer(void *obj, void (*destroy)(void *)) {
+  void *mem = allocate(sizeof(Finalizer), alignof(Finalizer));
+  finalizers_ = new (mem) Finalizer{finalizers_, destroy, obj};
+}
@@ -0,0 +1,86 @@
+// arena.h
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+// Arena por compilación para el AST: reserva bloques grandes y asigna los
+// nodos avanzando un puntero (bump allocator). Nada se libera nodo a nodo;
+// al destruir la arena se liberan todos los bloques de una vez.
+//
+// Los objetos con destructor no trivial (p.ej. los que tienen std::string o
+// std::vector) quedan registrados en una lista dentro de la propia arena y se
+// destruyen al final, sin recorrer el árbol.
+//
+// Un tipo cuyo destructor no es trivial sólo porque es virtual, pero que no
+// libera nada, puede especializar NoFinalizer para ahorrarse ese registro.
+template <typename T> struct NoFinalizer : std::false_type {};
+
+class Arena {
+public:
+  explicit Arena(size_t firstChunk = 16 * 1024);
+  ~Arena();
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  void *allocate(size_t size, size_t align);
+
+  // Si no es nullptr, se llama en cada make<T> de este hilo con el tipo y
+  // el tamaño del nodo (ver MemReport)
+  static inline thread_local void (*onMake)(const std::type_info &,
+                                            size_t) = nullptr;
+
+  // Destruye todo lo creado y deja la arena vacía, pero se queda con el
+  // bloque más grande para la próxima compilación (ver CompileServer): una
+  // arena que se reusa no vuelve a pedir memoria a malloc
+  void reset();
+
+  template <typename T, typename... Args> T *make(Args &&...args) {
+    void *mem = allocate(sizeof(T), alignof(T));
+    T *obj = new (mem) T(std::forward<Args>(args)...);
+    objects_++;
+    if (onMake)
+      onMake(typeid(T), sizeof(T));
+    if constexpr (!std::is_trivially_destructible_v<T> &&
+                  !NoFinalizer<T>::value)
+      addFinalizer(obj, [](void *p) { static_cast<T *>(p)->~T(); });
+    return obj;
+  }
+
+  // Estadísticas
+  size_t objectCount() const { return objects_; }
+  size_t bytesUsed() const { return used_; }
+  size_t bytesReserved() const { return reserved_; }
+  size_t chunkCount() const { return chunks_; }
+
+private:
+  struct Chunk {
+    Chunk *next;
+    size_t size; // bytes útiles tras la cabecera
+  };
+  struct Finalizer {
+    Finalizer *next;
+    void (*destroy)(void *);
+    void *obj;
+  };
+
+  void addFinalizer(void *obj, void (*destroy)(void *));
+  void newChunk(size_t minSize);
+
+  Chunk *head_ = nullptr;
+  char *cur_ = nullptr;
+  char *end_ = nullptr;
+  size_t nextChunk_;
+  Finalizer *finalizers_ = nullptr;
+
+  size_t objects_ = 0;
+  size_t used_ = 0;
+  size_t reserved_ = 0;
+  size_t chunks_ = 0;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,101 @@
+// asm_cache.cpp
+#include "asm_cache.h"
+#include "ast_cache.h"
+#include "source.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char kMagic[8] = {'K', 'T', 'A', 'S', 'M', '\0', '\0', '\0'};
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t pad;
+  uint64_t key;
+  uint64_t size;
+};
+
+// Huella del ejecutable (tamaño, fecha de modificación e inodo), calculada
+// una vez por proceso: recompilar el compilador la cambia. Leer el binario
+// entero para hashearlo costaría más que compilar un archivo chico. Si no
+// se puede consultar queda en 0 y sólo cuenta kVersion
+uint64_t compilerHash() {
+  static const uint64_t h = [] {
+    struct stat st;
+    if (stat("/proc/self/exe", &st) != 0)
+      return uint64_t(0);
+    uint64_t parts[4] = {uint64_t(st.st_size), uint64_t(st.st_mtim.tv_sec),
+                         uint64_t(st.st_mtim.tv_nsec), uint64_t(st.st_ino)};
+    return AstCache::hash(string_view((const char *)parts, sizeof(parts)));
+  }();
+  return h;
+}
+
+} // namespace
+
+AsmCache::AsmCache(string dir) : dir(move(dir)) {}
+
+uint64_t AsmCache::key(string_view source, string_view options) {
+  uint64_t h = AstCache::hash(source);
+  for (uint64_t part : {compilerHash(), AstCache::hash(options),
+                        uint64_t(kVersion)})
+    h = (h ^ part) * 0x100000001b3ull, h ^= h >> 32;
+  return h;
+}
+
+string AsmCache::pathFor(uint64_t key) const {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.s", (unsigned long long)key);
+  return dir + "/" + name;
+}
+
+bool AsmCache::store(uint64_t key, string_view text) const {
+  Header h;
+  memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kVersion;
+  h.pad = 0;
+  h.key = key;
+  h.size = text.size();
+
+  mkdir(dir.c_str(), 0755);
+  string path = pathFor(key);
+  // Temporal propio de este proceso y esta escritura (ver AstCache::store)
+  static atomic<unsigned> writes{0};
+  string tmp = path + ".tmp" + to_string(getpid()) + "." +
+               to_string(writes.fetch_add(1));
+  {
+    ofstream out(tmp, ios::binary);
+    if (!out)
+      return false;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    out.write(text.data(), text.size());
+    if (!out)
+      return false;
+  }
+  return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool AsmCache::load(uint64_t key, string &out) const {
+  SourceFile file;
+  if (!file.open(pathFor(key)))
+    return false;
+  string_view data = file.text();
+
+  Header h;
+  if (data.size() < sizeof(h))
+    return false;
+  memcpy(&h, data.data(), sizeof(h));
+  if (memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion ||
+      h.key != key || sizeof(h) + h.size != data.size())
+    return false;
+  out.assign(data.data() + sizeof(h), h.size);
+  return true;
+}
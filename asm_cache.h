@@ -0,0 +1,40 @@
+// asm_cache.h
+#ifndef ASM_CACHE_H
+#define ASM_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Caché en disco del assembly ya generado. La clave es un hash del fuente,
+// de la versión del compilador y de las opciones que cambian la salida: si
+// nada de eso cambió, el driver reusa el .s guardado sin correr Scanner,
+// Parser, Resolver, TypeChecker ni GenCodeVisitor. Sirve porque la salida
+// de GenCodeVisitor es determinista (la misma entrada da los mismos bytes).
+//
+// La "versión del compilador" es una huella del ejecutable que está
+// corriendo (tamaño, fecha e inodo), así que recompilar el compilador
+// invalida todas las entradas sin que haya que acordarse de subir kVersion.
+//
+// Formato: Header (magic, versión, clave, largo) y el texto del .s.
+class AsmCache {
+public:
+  // Subir cada vez que cambie el formato del archivo
+  static const uint32_t kVersion = 1;
+
+  explicit AsmCache(std::string dir = ".asmcache");
+
+  // 'options' describe las opciones que afectan al assembly (p. ej. "O2")
+  static uint64_t key(std::string_view source, std::string_view options);
+  std::string pathFor(uint64_t key) const;
+
+  // false si no hay entrada, es de otra versión o está incompleta
+  bool load(uint64_t key, std::string &out) const;
+  // Escribe a un temporal y lo renombra, como AstCache::store
+  bool store(uint64_t key, std::string_view text) const;
+
+private:
+  std::string dir;
+};
+
+#endif // ASM_CACHE_H
@@ -0,0 +1,249 @@
+// ast_cache.cpp
+#include "ast_cache.h"
+#include "source.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+const char kMagic[8] = {'K', 'T', 'A', 'S', 'T', '\0', '\0', '\0'};
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t root;
+  uint64_t key;
+  uint32_t nodes, extra, numbers, params;
+  uint32_t strings, symbols;
+  uint64_t strBytes, symBytes;
+};
+
+size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+
+// Tamaño de cada sección en el orden en que se escriben. En 64 bits: los
+// contadores de la cabecera son de 32 y vienen de un archivo, así que
+// (strings + 1) * 4 o nodes * 4 no pueden dar la vuelta. strBytes y
+// symBytes el que llama ya los acotó al tamaño del archivo
+uint64_t payloadSize(const Header &h) {
+  return align8(h.nodes) * 2 + align8(uint64_t(h.nodes) * 4) * 3 +
+         align8(uint64_t(h.extra) * 4) + align8(uint64_t(h.numbers) * 8) +
+         align8(uint64_t(h.params) * sizeof(FlatAst::ParamEntry)) +
+         align8((uint64_t(h.strings) + 1) * 4) + align8(h.strBytes) +
+         align8((uint64_t(h.symbols) + 1) * 4) + align8(h.symBytes);
+}
+
+class Writer {
+public:
+  explicit Writer(ofstream &out) : out(out) {}
+  void put(const void *p, size_t n) {
+    out.write(static_cast<const char *>(p), n);
+    static const char zeros[8] = {};
+    out.write(zeros, align8(n) - n);
+  }
+  template <typename T> void put(const vector<T> &v) {
+    put(v.data(), v.size() * sizeof(T));
+  }
+
+private:
+  ofstream &out;
+};
+
+class Reader {
+public:
+  explicit Reader(const char *p) : p(p) {}
+  template <typename T> void get(vector<T> &v, size_t n) {
+    v.resize(n);
+    if (n) // un vector vacío puede tener data() nulo
+      memcpy(v.data(), p, n * sizeof(T));
+    p += align8(n * sizeof(T));
+  }
+  const char *take(size_t n) {
+    const char *at = p;
+    p += align8(n);
+    return at;
+  }
+
+private:
+  const char *p;
+};
+
+// Tabla de textos como offsets + bytes contiguos
+void putStrings(Writer &w, const vector<string> &strs) {
+  vector<uint32_t> offsets;
+  string bytes;
+  for (auto &s : strs) {
+    offsets.push_back(bytes.size());
+    bytes += s;
+  }
+  offsets.push_back(bytes.size());
+  w.put(offsets);
+  w.put(bytes.data(), bytes.size());
+}
+
+} // namespace
+
+AstCache::AstCache(string dir) : dir(move(dir)) {}
+
+// Hash de 64 bits (no criptográfico) del texto del fuente, de a 8 bytes:
+// estilo FNV-1a pero por palabras, con una mezcla extra por vuelta
+uint64_t AstCache::hash(string_view source) {
+  const uint64_t prime = 0x100000001b3ull;
+  uint64_t h = 0xcbf29ce484222325ull ^ source.size();
+  const char *p = source.data(), *end = p + source.size();
+  for (; end - p >= 8; p += 8) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    h = (h ^ w) * prime;
+    h ^= h >> 32;
+  }
+  for (; p < end; p++)
+    h = (h ^ (unsigned char)*p) * prime;
+  return h ^ (h >> 29);
+}
+
+string AstCache::pathFor(uint64_t key) const {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.ast", (unsigned long long)key);
+  return dir + "/" + name;
+}
+
+bool AstCache::store(uint64_t key, const FlatAst &ast) const {
+  // 1) ids de Symbol -> índices en la tabla de símbolos del archivo
+  FlatAst f = ast;
+  unordered_map<uint32_t, uint32_t> local;
+  vector<string> symbols;
+  f.forEachSymbol([&](uint32_t &id) {
+    auto it = local.find(id);
+    if (it == local.end()) {
+      it = local.emplace(id, symbols.size()).first;
+      symbols.push_back(Symbol(id).str());
+    }
+    id = it->second;
+  });
+
+  Header h;
+  memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kVersion;
+  h.root = f.root;
+  h.key = key;
+  h.nodes = f.size();
+  h.extra = f.extra.size();
+  h.numbers = f.numbers.size();
+  h.params = f.params.size();
+  h.strings = f.strings.size();
+  h.symbols = symbols.size();
+  h.strBytes = h.symBytes = 0;
+  for (auto &s : f.strings)
+    h.strBytes += s.size();
+  for (auto &s : symbols)
+    h.symBytes += s.size();
+
+  // 2) escribir a un temporal y renombrar
+  mkdir(dir.c_str(), 0755);
+  string path = pathFor(key);
+  // Temporal propio de este proceso y esta escritura: dos hilos pueden
+  // guardar a la vez el mismo fuente
+  static atomic<unsigned> writes{0};
+  string tmp = path + ".tmp" + to_string(getpid()) + "." +
+               to_string(writes.fetch_add(1));
+  {
+    ofstream out(tmp, ios::binary);
+    if (!out)
+      return false;
+    Writer w(out);
+    w.put(&h, sizeof(h));
+    w.put(f.kind);
+    w.put(f.flag);
+    w.put(f.a);
+    w.put(f.b);
+    w.put(f.c);
+    w.put(f.extra);
+    w.put(f.numbers);
+    w.put(f.params);
+    putStrings(w, f.strings);
+    putStrings(w, symbols);
+    if (!out)
+      return false;
+  }
+  return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool AstCache::load(uint64_t key, FlatAst &out) const {
+  SourceFile file;
+  if (!file.open(pathFor(key)))
+    return false;
+  string_view data = file.text();
+
+  // 1) validar cabecera y tamaño antes de tocar las secciones
+  Header h;
+  if (data.size() < align8(sizeof(h)))
+    return false;
+  memcpy(&h, data.data(), sizeof(h));
+  if (memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion ||
+      h.key != key || h.strBytes > data.size() ||
+      h.symBytes > data.size() ||
+      align8(sizeof(h)) + payloadSize(h) != data.size())
+    return false;
+
+  // 2) copiar los arreglos en bloque desde el mapeo
+  FlatAst f;
+  Reader r(data.data() + align8(sizeof(h)));
+  r.get(f.kind, h.nodes);
+  r.get(f.flag, h.nodes);
+  r.get(f.a, h.nodes);
+  r.get(f.b, h.nodes);
+  r.get(f.c, h.nodes);
+  r.get(f.extra, h.extra);
+  r.get(f.numbers, h.numbers);
+  r.get(f.params, h.params);
+
+  auto getStrings = [&](uint64_t n, uint64_t bytes, auto &&add) {
+    vector<uint32_t> offsets;
+    r.get(offsets, n + 1);
+    if (offsets.size() != n + 1)
+      return false;
+    const char *base = r.take(bytes);
+    for (uint64_t i = 0; i < n; i++) {
+      if (offsets[i] > offsets[i + 1] || offsets[i + 1] > bytes)
+        return false;
+      add(string_view(base + offsets[i], offsets[i + 1] - offsets[i]));
+    }
+    return true;
+  };
+  if (!getStrings(h.strings, h.strBytes,
+                  [&](string_view s) { f.strings.emplace_back(s); }))
+    return false;
+
+  // 3) los índices del archivo no son de confianza: un nodo o un rango
+  // fuera de lugar haría fallar a toProgram(). Se valida antes de
+  // forEachSymbol, que ya recorre 'extra'
+  f.root = h.root;
+  if (!f.wellFormed())
+    return false;
+
+  // 4) la tabla de símbolos del archivo se interna en este proceso
+  vector<uint32_t> symbols;
+  if (!getStrings(h.symbols, h.symBytes, [&](string_view s) {
+        symbols.push_back(Symbol::intern(s).id());
+      }))
+    return false;
+  bool ok = true;
+  f.forEachSymbol([&](uint32_t &id) {
+    if (id < symbols.size())
+      id = symbols[id];
+    else
+      ok = false;
+  });
+  if (!ok)
+    return false;
+
+  out = move(f);
+  return true;
+}
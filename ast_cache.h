@@ -0,0 +1,45 @@
+// ast_cache.h
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include "flat_ast.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Caché en disco del AST ya parseado. Cada archivo guarda el FlatAst de un
+// fuente en un formato binario versionado y se nombra con el hash del
+// contenido del fuente: si el texto no cambió, el driver carga el AST con
+// unas pocas copias en bloque en vez de volver a correr Scanner y Parser.
+//
+// Formato (little-endian, secciones alineadas a 8 bytes):
+//   Header
+//   kind[n] flag[n] a[n] b[n] c[n]          arreglos por nodo
+//   extra[] numbers[] params[]              arreglos laterales
+//   strOffsets[nStrings+1] strBytes          textos (tipos, literales)
+//   symOffsets[nSymbols+1] symBytes          nombres de los símbolos
+// Los ids de Symbol dependen del proceso, así que en el archivo se guardan
+// como índices a la tabla de símbolos propia y se re-internan al cargar.
+class AstCache {
+public:
+  // Subir cada vez que cambie el formato o la codificación de FlatAst
+  static const uint32_t kVersion = 1;
+
+  explicit AstCache(std::string dir = ".astcache");
+
+  static uint64_t hash(std::string_view source);
+  std::string pathFor(uint64_t key) const;
+
+  // false si no hay entrada, es de otra versión, está incompleta o sus
+  // índices no forman un árbol válido (FlatAst::wellFormed): entonces se
+  // vuelve a parsear
+  bool load(uint64_t key, FlatAst &out) const;
+  // Escribe a un temporal y lo renombra: un lector nunca ve un archivo a
+  // medio escribir
+  bool store(uint64_t key, const FlatAst &ast) const;
+
+private:
+  std::string dir;
+};
+
+#endif // AST_CACHE_H
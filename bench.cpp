@@ -0,0 +1,961 @@
+// bench.cpp
+// Microbenchmarks del compilador. Uso: ./kotlin_bench <caso> [archivo]
+//   scanner   tokeniza la entrada con cada nivel SIMD y reporta MB/s
+//   eval      interpreta un programa con EVALVisitor y compara la
+//             clasificación de nodos con dynamic_cast y con 'kind'
+//   flat      recorre el AST de punteros y el plano (tiempo, cache misses)
+//   cache     compara scanner+parser contra cargar el AST de .astcache/
+//   visitor   costo de recorrer el AST con un visitor (VisitorBase, CRTP)
+//   expr      scanner+parser sobre un fuente con muchas expresiones
+//   parser    scanner+parser sobre un programa de 100k líneas con todas las
+//             sentencias y factores del lenguaje
+//   stream    memoria y tiempo de compilar un programa grande entero contra
+//             compilarlo función por función (streaming.h)
+//   codegen   GenCodeVisitor sobre miles de funciones con 1, 2, 4 y 8 hilos:
+//             tiempo, aceleración y que la salida sea idéntica
+//   stress    una expresión de un millón de términos por todas las fases y
+//             100k bloques anidados por el parser: falla si algo no termina
+//   server    latencia de un pedido al servidor de compilación (server.h)
+//             contra arrancar el compilador para cada archivo; el tercer
+//             argumento es el compilador (por defecto ./kotlin)
+// Sin archivo se genera un programa sintético grande.
+#include "arena.h"
+#include "ast_cache.h"
+#include "exp.h"
+#include "flat_ast.h"
+#include "parallel.h"
+#include "parser.h"
+#include "resolver.h"
+#include "scanner.h"
+#include "server.h"
+#include "simd_lexer.h"
+#include "streaming.h"
+#include "token.h"
+#include "typecheck.h"
+#include "visitor.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <linux/perf_event.h>
+#include <spawn.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Programa grande con mucha indentación, como los generados automáticamente
+static string syntheticSource(int functions) {
+  stringstream ss;
+  ss << "val greeting: String = \"hola mundo desde un literal largo\"\n";
+  for (int f = 0; f < functions; f++) {
+    ss << "fun function_number_" << f << "(parameter_value: Int): Int {\n";
+    ss << "        var accumulated_result: Int = 0\n";
+    ss << "        for (index_variable in 0..parameter_value) {\n";
+    ss << "                accumulated_result = accumulated_result + "
+          "index_variable * "
+       << f << "\n";
+    ss << "                println(\"iteracion de la funcion numero " << f
+       << "\")\n";
+    ss << "        }\n";
+    ss << "        return accumulated_result\n";
+    ss << "}\n\n";
+  }
+  return ss.str();
+}
+
+// Bucle caliente para el intérprete: asignaciones, llamadas, índices y println
+static string evalSource(int iterations) {
+  stringstream ss;
+  ss << "fun advance(x: Int): Int {\n"
+        "    return x * 3 + 1\n"
+        "}\n"
+        "fun main() {\n"
+        "    var i: Int = 0\n"
+        "    var acc: Int = 0\n"
+        "    val arr = intArrayOf(1, 2, 3, 4)\n"
+        "    while (i < "
+     << iterations
+     << ") {\n"
+        "        acc = acc + advance(i)\n"
+        "        arr[1] = acc\n"
+        "        if (acc > 1000) {\n"
+        "            acc = acc - 1000\n"
+        "        }\n"
+        "        for (j in 0..3) {\n"
+        "            acc = acc + arr[j]\n"
+        "        }\n"
+        "        println(acc)\n"
+        "        i = i + 1\n"
+        "    }\n"
+        "}\n";
+  return ss.str();
+}
+
+// Fuente cargado de aritmética: casi todo el tiempo de parseo se va en
+// expresiones con varios niveles de precedencia
+static string exprSource(int lines) {
+  stringstream ss;
+  for (int i = 0; i < lines; i += 100) {
+    ss << "fun arith_" << i << "(a: Int, b: Int, c: Int, d: Int): Int {\n"
+       << "    var acc: Int = 0\n"
+       << "    var ok: Boolean = false\n";
+    for (int j = 0; j < 100; j++) {
+      if (j % 4 == 3)
+        ss << "    ok = acc * 2 + " << j << " >= a - b * c / (d + 1)\n";
+      else
+        ss << "    acc = (a + b * " << j << " - c / 2) * (d - 4) + a * b * c"
+           << " - 7 / (b + " << j << ") + acc\n";
+    }
+    ss << "    return acc\n}\n";
+  }
+  return ss.str();
+}
+
+// Programa de 'lines' líneas que pasa por todas las reglas de sentencia y
+// de factor, en bloques de 21 líneas por función
+static string parserSource(int lines) {
+  stringstream ss;
+  ss << "class Point {\n    var x: Int = 0\n    var y: Int = 0\n"
+     << "    var tag: Int = 0\n}\n";
+  for (int i = 0; 21 * i < lines; i++) {
+    ss << "fun block_" << i << "(n: Int, p: Point): Int {\n"
+       << "    var total: Int = 0\n"
+       << "    val xs = intArrayOf(1, 2, 3, " << i << ")\n"
+       << "    val ys = mutableListOf(n, n + 1)\n"
+       << "    val zs = IntArray(n) { it * 2 }\n"
+       << "    val bs = listOf(true, false, true)\n"
+       << "    for (k in 0..n step 2) {\n"
+       << "        total = total + xs[k] * " << i << "\n"
+       << "    }\n"
+       << "    while (total > 100) {\n"
+       << "        total = total - if (n > 3) p.x else p.y\n"
+       << "    }\n"
+       << "    if (total == " << i << ") {\n"
+       << "        println(\"igual\")\n"
+       << "    } else {\n"
+       << "        xs[0] = (total + n) / 2\n"
+       << "    }\n"
+       << "    p.tag = bs[0]\n"
+       << "    print(zs[1])\n"
+       << "    return total + ys[0]\n"
+       << "}\n";
+  }
+  return ss.str();
+}
+
+// main con una sola expresión de 'terms' términos: 0 + 1 + 1 + ...
+static string longExprSource(int terms) {
+  string src = "fun main() {\n    var x: Int = 0";
+  src.reserve(src.size() + 4 * size_t(terms) + 32);
+  for (int i = 1; i < terms; i++)
+    src += " + 1";
+  src += "\n    println(x)\n}\n";
+  return src;
+}
+
+// 'depth' bloques if/while/for anidados (con llaves) y después una cadena de
+// 'depth' if sin llaves: if (n > 0) if (n > 0) ... n = 1
+static string nestedSource(int depth) {
+  stringstream ss;
+  ss << "fun main() {\n    var n: Int = 1\n";
+  for (int i = 0; i < depth; i++) {
+    if (i % 3 == 0)
+      ss << "if (n > 0) {\n";
+    else if (i % 3 == 1)
+      ss << "while (n < 0) {\n";
+    else
+      ss << "for (k in 0..1) {\n";
+  }
+  ss << "n = n + 1\n";
+  for (int i = depth; i-- > 0;)
+    ss << (i % 3 == 0 ? "} else n = 0\n" : "}\n");
+  for (int i = 0; i < depth; i++)
+    ss << "if (n > 0) ";
+  ss << "n = 1\n}\n";
+  return ss.str();
+}
+
+// 'functions' funciones medianas, cada una llama a la siguiente (declarada
+// más abajo)
+static string streamSource(int functions) {
+  stringstream ss;
+  ss << "var g: Int = 3\nfun main() {\n    println(f_0(g))\n}\n";
+  for (int i = 0; i < functions; i++) {
+    ss << "fun f_" << i << "(n: Int): Int {\n"
+       << "    var t: Int = " << i << "\n"
+       << "    for (k in 0..n) {\n"
+       << "        t = t + k * " << i % 7 << " - (n + k) / 3\n"
+       << "    }\n"
+       << "    while (t > 1000) {\n"
+       << "        t = t - 17\n"
+       << "    }\n"
+       << "    if (t == 5) {\n"
+       << "        t = t + 1\n"
+       << "    } else {\n"
+       << "        t = t * 2\n"
+       << "    }\n";
+    if (i + 1 < functions)
+      ss << "    return t + f_" << i + 1 << "(n - 1)\n";
+    else
+      ss << "    return t\n";
+    ss << "}\n";
+  }
+  return ss.str();
+}
+
+static string readFile(const string &path) {
+  ifstream in(path, ios::binary);
+  stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+// Salida descartada
+struct NullBuf : streambuf {
+  int overflow(int c) override { return c; }
+};
+
+// Pico de memoria residente del proceso hasta ahora
+static long peakRssKB() {
+  rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+template <typename F> static double bestOf(int reps, F &&f) {
+  double best = 1e100;
+  for (int r = 0; r < reps; r++) {
+    auto t0 = chrono::steady_clock::now();
+    f();
+    auto t1 = chrono::steady_clock::now();
+    best = min(best, chrono::duration<double>(t1 - t0).count());
+  }
+  return best;
+}
+
+static int benchScanner(const string &src) {
+  double mb = src.size() / (1024.0 * 1024.0);
+  cout << "scanner: " << mb << " MB" << endl;
+  for (int l = simdlex::SCALAR; l <= simdlex::detect(); l++) {
+    simdlex::setLevel((simdlex::Level)l);
+    long tokens = 0;
+    Scanner scanner(src);
+    double secs = bestOf(9, [&]() {
+      scanner.reset();
+      tokens = 0;
+      while (scanner.nextToken().type != Token::END)
+        tokens++;
+    });
+    cout << "  " << simdlex::levelName((simdlex::Level)l) << ": " << tokens
+         << " tokens, " << mb / secs << " MB/s" << endl;
+  }
+  simdlex::setLevel(simdlex::detect());
+  return 0;
+}
+
+// La clasificación que hacían los visitors antes de tener 'kind'
+static int classifyRtti(Exp *e) {
+  if (dynamic_cast<IdentifierExp *>(e))
+    return 1;
+  if (dynamic_cast<IndexExp *>(e))
+    return 2;
+  if (dynamic_cast<DotExp *>(e))
+    return 3;
+  if (dynamic_cast<StringExp *>(e))
+    return 4;
+  return 0;
+}
+
+static int classifyKind(Exp *e) {
+  return match(e, Overload{[](IdentifierExp *) { return 1; },
+                           [](IndexExp *) { return 2; },
+                           [](DotExp *) { return 3; },
+                           [](StringExp *) { return 4; },
+                           [](Exp *) { return 0; }});
+}
+
+static int benchEval(const string &src) {
+  Scanner scanner(src);
+  Parser parser(&scanner, true);
+  unique_ptr<Program> prog(parser.parseProgram());
+  Resolver().resolve(prog.get());
+  TypeChecker().check(prog.get());
+
+  // 1) intérprete completo, con la salida descartada
+  NullBuf null;
+  streambuf *saved = cout.rdbuf(&null);
+  double secs = bestOf(5, [&]() {
+    EVALVisitor eval;
+    eval.ejecutar(prog.get());
+  });
+  cout.rdbuf(saved);
+  cout << "eval: " << secs * 1e3 << " ms por ejecución" << endl;
+
+  // 2) clasificación de nodos sueltos (mezcla de tipos, como los LHS y
+  //    argumentos de print)
+  Arena arena;
+  vector<Exp *> nodes;
+  for (int i = 0; i < 1000000; i++) {
+    switch (i % 5) {
+    case 0:
+      nodes.push_back(arena.make<IdentifierExp>(Symbol()));
+      break;
+    case 1:
+      nodes.push_back(arena.make<IndexExp>(Symbol(), nullptr));
+      break;
+    case 2:
+      nodes.push_back(arena.make<NumberExp>(i));
+      break;
+    case 3:
+      nodes.push_back(arena.make<BinaryExp>(nullptr, nullptr, PLUS_OP));
+      break;
+    default:
+      nodes.push_back(arena.make<StringExp>("s"));
+    }
+  }
+  long sum = 0;
+  auto run = [&](int (*classify)(Exp *)) {
+    return bestOf(9, [&]() {
+      for (Exp *e : nodes)
+        sum += classify(e);
+    });
+  };
+  double rtti = run(classifyRtti);
+  double kind = run(classifyKind);
+  cout << "clasificación (" << nodes.size() << " nodos, check " << sum
+       << "):" << endl
+       << "  dynamic_cast: " << rtti * 1e9 / nodes.size() << " ns/nodo"
+       << endl
+       << "  kind:         " << kind * 1e9 / nodes.size() << " ns/nodo"
+       << endl;
+  return 0;
+}
+
+// Contador de cache misses del hardware. Si el kernel no lo permite (VM,
+// contenedor, perf_event_paranoid) queda deshabilitado y se informa "n/d".
+class CacheMisses {
+public:
+  CacheMisses() {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+  ~CacheMisses() {
+    if (fd >= 0)
+      close(fd);
+  }
+  bool available() const { return fd >= 0; }
+
+  template <typename F> long long measure(F &&f) {
+    if (fd < 0) {
+      f();
+      return -1;
+    }
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    f();
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    long long count = 0;
+    if (read(fd, &count, sizeof(count)) != sizeof(count))
+      return -1;
+    return count;
+  }
+
+private:
+  int fd;
+};
+
+// Recorrido completo del AST de punteros (lo que hace cualquier visitor)
+static long walkTree(Exp *e);
+static long walkTree(Body *b);
+
+static long walkTree(VarDecList *l) {
+  long n = 1;
+  for (auto *d : l->vars) {
+    n++;
+    for (auto *init : d->inits)
+      n += init ? walkTree(init) : 0;
+  }
+  return n;
+}
+
+static long walkTree(Exp *e) {
+  if (!e)
+    return 0;
+  return 1 + match(e, Overload{
+                          [](BinaryExp *x) {
+                            return walkTree(x->left) + walkTree(x->right);
+                          },
+                          [](IFExp *x) {
+                            return walkTree(x->cond) + walkTree(x->left) +
+                                   walkTree(x->right);
+                          },
+                          [](FCallExp *x) {
+                            long n = 0;
+                            for (auto *a : x->args)
+                              n += walkTree(a);
+                            return n;
+                          },
+                          [](ListExp *x) {
+                            long n = 0;
+                            for (auto *a : x->elements)
+                              n += walkTree(a);
+                            return n;
+                          },
+                          [](IndexExp *x) { return walkTree(x->index); },
+                          [](LoopExp *x) {
+                            return walkTree(x->start) + walkTree(x->end) +
+                                   walkTree(x->step);
+                          },
+                          [](ArrayInitExp *x) {
+                            return walkTree(x->size) + walkTree(x->body);
+                          },
+                          [](Exp *) { return 0L; }});
+}
+
+static long walkTree(Stm *s) {
+  return 1 + match(s, Overload{
+                          [](AssignStatement *x) {
+                            return walkTree(x->target) + walkTree(x->expr);
+                          },
+                          [](PrintStatement *x) { return walkTree(x->expr); },
+                          [](ReturnStatement *x) { return walkTree(x->expr); },
+                          [](IfStatement *x) {
+                            return walkTree(x->cond) +
+                                   walkTree(x->thenBranch) +
+                                   walkTree(x->elseBranch);
+                          },
+                          [](WhileStatement *x) {
+                            return walkTree(x->cond) + walkTree(x->body);
+                          },
+                          [](ForStatement *x) {
+                            return walkTree(x->iterable) + walkTree(x->body);
+                          }});
+}
+
+static long walkTree(Body *b) {
+  if (!b)
+    return 0;
+  long n = 2 + walkTree(b->vardecs);
+  for (auto *s : b->stmts->statements)
+    n += walkTree(s);
+  return n;
+}
+
+static long walkTree(Program *p) {
+  long n = 1 + walkTree(p->vardecs);
+  n++; // ClassDecList
+  for (auto *cd : p->classDecs->classes)
+    n += 1 + walkTree(cd->members);
+  n++; // FunDecList
+  for (auto *fd : p->funDecs->functions)
+    n += 1 + walkTree(fd->body);
+  return n;
+}
+
+static long walkFlat(const FlatAst &f, uint32_t id) {
+  long n = 1;
+  f.forEachChild(id, [&](uint32_t child) { n += walkFlat(f, child); });
+  return n;
+}
+
+static int benchFlat(const string &src) {
+  Scanner scanner(src);
+  Parser parser(&scanner, true);
+  unique_ptr<Program> prog(parser.parseProgram());
+  FlatAst flat = FlatAst::build(prog.get());
+  unique_ptr<Program> rebuilt(flat.toProgram());
+
+  cout << "flat: " << flat.size() << " nodos" << endl
+       << "  arena (punteros): " << prog->arena->bytesUsed() / 1024
+       << " KB en " << prog->arena->objectCount() << " objetos" << endl
+       << "  plano:            " << flat.bytes() / 1024 << " KB" << endl;
+
+  CacheMisses misses;
+  long nodes = 0;
+  auto report = [&](const char *name, auto &&walk) {
+    double secs = bestOf(9, [&]() { nodes = walk(); });
+    long long m = misses.measure([&]() { nodes = walk(); });
+    cout << "  " << name << secs * 1e3 << " ms, " << nodes << " nodos, "
+         << secs * 1e9 / nodes << " ns/nodo, cache misses: ";
+    if (m < 0)
+      cout << "n/d";
+    else
+      cout << m;
+    cout << endl;
+  };
+  report("punteros (parser):      ", [&]() { return walkTree(prog.get()); });
+  report("punteros (preorden):    ",
+         [&]() { return walkTree(rebuilt.get()); });
+  report("plano:                  ",
+         [&]() { return walkFlat(flat, flat.root); });
+  return 0;
+}
+
+static int benchCache(const string &src) {
+  AstCache cache;
+  uint64_t key = 0;
+  double hashSecs = bestOf(5, [&]() { key = AstCache::hash(src); });
+
+  // 1) camino sin caché
+  unique_ptr<Program> parsed;
+  double parseSecs = bestOf(5, [&]() {
+    Scanner scanner(src);
+    Parser parser(&scanner, true);
+    parsed.reset(parser.parseProgram());
+  });
+  FlatAst flat = FlatAst::build(parsed.get());
+  if (!cache.store(key, flat)) {
+    cerr << "No se pudo escribir " << cache.pathFor(key) << endl;
+    return 1;
+  }
+
+  // 2) camino con caché: sólo el FlatAst y luego el adaptador a punteros
+  FlatAst loaded;
+  double loadSecs = bestOf(5, [&]() { cache.load(key, loaded); });
+  double loadProgSecs = bestOf(5, [&]() {
+    FlatAst f;
+    cache.load(key, f);
+    unique_ptr<Program> prog(f.toProgram());
+  });
+
+  // 3) una cabecera corrupta no se carga. Los contadores de textos y de
+  // símbolos se llevan a 0xFFFFFFFF: (n + 1) * 4 en 32 bits daría 0, y el
+  // tamaño de textos crece lo mismo para que el total siga cuadrando
+  string good = readFile(cache.pathFor(key));
+  auto align8 = [](uint64_t n) { return (n + 7) & ~uint64_t(7); };
+  bool rejected = true;
+  // Desplazamientos en Header: strings/strBytes y symbols/symBytes
+  for (auto [count, size] : {pair<size_t, size_t>{40, 48}, {44, 56}}) {
+    string bad = good;
+    uint32_t n;
+    uint64_t bytes;
+    memcpy(&n, &bad[count], 4);
+    memcpy(&bytes, &bad[size], 8);
+    bytes = align8(bytes) + align8((uint64_t(n) + 1) * 4);
+    n = 0xFFFFFFFF;
+    memcpy(&bad[count], &n, 4);
+    memcpy(&bad[size], &bytes, 8);
+    ofstream(cache.pathFor(key), ios::binary) << bad;
+    FlatAst f;
+    rejected = rejected && !cache.load(key, f);
+  }
+  ofstream(cache.pathFor(key), ios::binary) << good;
+  if (!rejected) {
+    cerr << "cache: se cargó un archivo con la cabecera corrupta" << endl;
+    return 1;
+  }
+
+  double mb = src.size() / (1024.0 * 1024.0);
+  cout << "cache: " << mb << " MB de fuente, " << flat.size() << " nodos ("
+       << cache.pathFor(key) << ")" << endl
+       << "  hash del fuente:          " << hashSecs * 1e3 << " ms" << endl
+       << "  scanner + parser:         " << parseSecs * 1e3 << " ms" << endl
+       << "  cargar FlatAst:           " << loadSecs * 1e3 << " ms" << endl
+       << "  cargar + toProgram:       " << loadProgSecs * 1e3 << " ms"
+       << endl;
+  return 0;
+}
+
+// Visitor mínimo que cuenta nodos: mide sólo el costo del despacho
+class NodeCounter : public VisitorBase<NodeCounter, long, long> {
+public:
+  long visit(BinaryExp *e) { return 1 + accept(e->left) + accept(e->right); }
+  long visit(IFExp *e) {
+    return 1 + accept(e->cond) + accept(e->left) + accept(e->right);
+  }
+  long visit(StringExp *) { return 1; }
+  long visit(NumberExp *) { return 1; }
+  long visit(BoolExp *) { return 1; }
+  long visit(IdentifierExp *) { return 1; }
+  long visit(FCallExp *e) { return 1 + all(e->args); }
+  long visit(ListExp *e) { return 1 + all(e->elements); }
+  long visit(IndexExp *e) { return 1 + accept(e->index); }
+  long visit(DotExp *) { return 1; }
+  long visit(LoopExp *e) {
+    return 1 + accept(e->start) + accept(e->end) +
+           (e->step ? accept(e->step) : 0);
+  }
+  long visit(ArrayInitExp *e) { return 1 + accept(e->size) + accept(e->body); }
+
+  long visit(AssignStatement *s) {
+    return 1 + accept(s->target) + accept(s->expr);
+  }
+  long visit(PrintStatement *s) { return 1 + accept(s->expr); }
+  long visit(ReturnStatement *s) {
+    return 1 + (s->expr ? accept(s->expr) : 0);
+  }
+  long visit(IfStatement *s) {
+    return 1 + accept(s->cond) + accept(s->thenBranch) +
+           (s->elseBranch ? accept(s->elseBranch) : 0);
+  }
+  long visit(WhileStatement *s) {
+    return 1 + accept(s->cond) + accept(s->body);
+  }
+  long visit(ForStatement *s) {
+    return 1 + accept(s->iterable) + accept(s->body);
+  }
+
+  long visit(VarDec *d) {
+    long n = 1;
+    for (auto *init : d->inits)
+      n += init ? accept(init) : 0;
+    return n;
+  }
+  long visit(VarDecList *l) { return 1 + all(l->vars); }
+  long visit(ClassDec *c) { return 1 + accept(c->members); }
+  long visit(ClassDecList *l) { return 1 + all(l->classes); }
+  long visit(FunDec *f) { return 1 + accept(f->body); }
+  long visit(FunDecList *l) { return 1 + all(l->functions); }
+  long visit(StatementList *l) { return 1 + all(l->statements); }
+  long visit(Body *b) { return 1 + accept(b->vardecs) + accept(b->stmts); }
+  long visit(Program *p) {
+    return 1 + accept(p->vardecs) + accept(p->classDecs) +
+           accept(p->funDecs);
+  }
+
+private:
+  template <typename N> long all(const vector<N *> &nodes) {
+    long n = 0;
+    for (auto *node : nodes)
+      n += accept(node);
+    return n;
+  }
+};
+
+static int benchVisitor(const string &src) {
+  Scanner scanner(src);
+  Parser parser(&scanner, true);
+  unique_ptr<Program> prog(parser.parseProgram());
+
+  long nodes = 0;
+  double secs = bestOf(9, [&]() {
+    NodeCounter counter;
+    nodes = counter.accept(prog.get());
+  });
+  cout << "visitor: " << nodes << " nodos, " << secs * 1e3 << " ms, "
+       << secs * 1e9 / nodes << " ns/nodo" << endl;
+  return 0;
+}
+
+// Los Program se liberan fuera de la medición: sólo cuenta el parseo
+static int benchExpr(const string &src) {
+  vector<unique_ptr<Program>> progs;
+  double secs = bestOf(5, [&]() {
+    Scanner scanner(src);
+    Parser parser(&scanner, true);
+    progs.emplace_back(parser.parseProgram());
+  });
+  long nodes = NodeCounter().accept(progs.back().get());
+  double mb = src.size() / (1024.0 * 1024.0);
+  cout << "expr: " << mb << " MB, " << nodes << " nodos, " << secs * 1e3
+       << " ms, " << mb / secs << " MB/s, " << secs * 1e9 / nodes
+       << " ns/nodo" << endl;
+  return 0;
+}
+
+static int benchParser(const string &src) {
+  vector<unique_ptr<Program>> progs;
+  double secs = bestOf(5, [&]() {
+    Scanner scanner(src);
+    Parser parser(&scanner, true);
+    progs.emplace_back(parser.parseProgram());
+  });
+  long lines = count(src.begin(), src.end(), '\n');
+  double mb = src.size() / (1024.0 * 1024.0);
+  cout << "parser: " << lines << " líneas, " << mb << " MB, " << secs * 1e3
+       << " ms, " << lines / secs / 1e6 << " M líneas/s, " << mb / secs
+       << " MB/s" << endl;
+  return 0;
+}
+
+// La salida con N hilos tiene que ser byte a byte la de un hilo
+static int benchCodegen(const string &src) {
+  Scanner scanner(src);
+  Parser parser(&scanner, true);
+  unique_ptr<Program> prog(parser.parseProgram());
+  Resolver().resolve(prog.get());
+  TypeChecker().check(prog.get());
+
+  cout << "codegen: " << prog->funDecs->functions.size() << " funciones, "
+       << defaultJobs() << " hilos de hardware" << endl;
+  string reference;
+  double single = 0;
+  for (unsigned jobs : {1u, 2u, 4u, 8u}) {
+    string out;
+    double secs = bestOf(5, [&]() {
+      stringstream ss;
+      GenCodeVisitor<stringstream> gen(ss);
+      gen.setJobs(jobs);
+      gen.generate(prog.get());
+      out = ss.str();
+    });
+    if (jobs == 1) {
+      reference = out;
+      single = secs;
+    } else if (out != reference) {
+      cerr << "codegen: la salida con " << jobs << " hilos no es la misma"
+           << endl;
+      return 1;
+    }
+    cout << "  " << jobs << " hilos: " << secs * 1e3 << " ms, x"
+         << single / secs << endl;
+  }
+  return 0;
+}
+
+// El pico de RSS sólo sube, así que primero va la compilación por partes
+static int benchStream(const string &src) {
+  NullBuf null;
+  ostream sink(&null);
+  double mb = src.size() / (1024.0 * 1024.0);
+  long start = peakRssKB();
+
+  auto t0 = chrono::steady_clock::now();
+  StreamStats st = compileStreaming(src, sink);
+  double streamSecs =
+      chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+  long streamPeak = peakRssKB();
+
+  t0 = chrono::steady_clock::now();
+  size_t arenaBytes = 0;
+  {
+    Scanner scanner(src);
+    Parser parser(&scanner, true);
+    unique_ptr<Program> prog(parser.parseProgram());
+    Resolver().resolve(prog.get());
+    TypeChecker().check(prog.get());
+    GenCodeVisitor<ostream>(sink).generate(prog.get());
+    arenaBytes = prog->arena->bytesUsed();
+  }
+  double batchSecs =
+      chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+  long batchPeak = peakRssKB();
+
+  cout << "stream: " << mb << " MB de fuente, " << st.functions
+       << " funciones" << endl
+       << "  por partes: " << streamSecs * 1e3 << " ms, arena "
+       << (st.headerBytes + st.maxFunctionBytes) / 1024
+       << " KB (encabezado + función más grande), pico RSS +"
+       << (streamPeak - start) / 1024 << " MB" << endl
+       << "  entero:     " << batchSecs * 1e3 << " ms, arena "
+       << arenaBytes / 1024 << " KB, pico RSS +" << (batchPeak - start) / 1024
+       << " MB" << endl;
+  return 0;
+}
+
+// Profundidad siguiendo la primera sentencia de cada cuerpo
+static long nestingDepth(Body *b) {
+  long depth = 0;
+  while (b && !b->stmts->statements.empty()) {
+    Stm *s = b->stmts->statements.front();
+    if (auto *i = node_cast<IfStatement>(s))
+      b = i->thenBranch;
+    else if (auto *w = node_cast<WhileStatement>(s))
+      b = w->body;
+    else if (auto *f = node_cast<ForStatement>(s))
+      b = f->body;
+    else
+      break;
+    depth++;
+  }
+  return depth;
+}
+
+// Entradas generadas que con recursión desbordarían la pila: cada fase tiene
+// que terminar y dar el resultado esperado
+static int benchStress(int terms, int depth) {
+  using clock = chrono::steady_clock;
+  auto ms = [](clock::time_point t0) {
+    return chrono::duration<double, milli>(clock::now() - t0).count();
+  };
+  auto eval = [](Program *prog) {
+    stringstream out;
+    streambuf *saved = cout.rdbuf(out.rdbuf());
+    EVALVisitor().ejecutar(prog);
+    cout.rdbuf(saved);
+    return out.str();
+  };
+
+  string src = longExprSource(terms);
+  auto t0 = clock::now();
+  Scanner scanner(src);
+  Parser parser(&scanner, true);
+  unique_ptr<Program> prog(parser.parseProgram());
+  cout << "stress: expresión de " << terms << " términos" << endl
+       << "  parser:      " << ms(t0) << " ms" << endl;
+  t0 = clock::now();
+  Resolver().resolve(prog.get());
+  TypeChecker().check(prog.get());
+  cout << "  resolver + tipos: " << ms(t0) << " ms" << endl;
+  t0 = clock::now();
+  string value = eval(prog.get());
+  cout << "  eval:        " << ms(t0) << " ms -> " << value;
+  t0 = clock::now();
+  stringstream asmOut;
+  GenCodeVisitor<stringstream>(asmOut).generate(prog.get());
+  cout << "  gencode:     " << ms(t0) << " ms, " << asmOut.str().size() / 1024
+       << " KB" << endl;
+  t0 = clock::now();
+  FlatAst flat = FlatAst::build(prog.get());
+  unique_ptr<Program> rebuilt(flat.toProgram());
+  Resolver().resolve(rebuilt.get());
+  TypeChecker().check(rebuilt.get());
+  string again = eval(rebuilt.get());
+  cout << "  plano ida y vuelta + eval: " << ms(t0) << " ms" << endl;
+  if (value != to_string(terms - 1) + "\n" || again != value) {
+    cerr << "stress: resultado incorrecto" << endl;
+    return 1;
+  }
+
+  src = nestedSource(depth);
+  t0 = clock::now();
+  Scanner nestedScanner(src);
+  Parser nestedParser(&nestedScanner, true);
+  unique_ptr<Program> nested(nestedParser.parseProgram());
+  Body *body = nested->funDecs->functions[0]->body;
+  long blocks = nestingDepth(body);
+  long chain = nestingDepth(
+      node_cast<IfStatement>(body->stmts->statements.back())->thenBranch);
+  cout << "stress: " << depth << " bloques anidados y " << depth
+       << " if sin llaves" << endl
+       << "  parser:      " << ms(t0) << " ms, profundidad " << blocks
+       << " y " << chain + 1 << endl;
+  if (blocks != depth || chain + 1 != depth) {
+    cerr << "stress: anidamiento incorrecto" << endl;
+    return 1;
+  }
+  return 0;
+}
+
+// Mediana y p99 de 'n' corridas de f, en ms
+template <typename F> static void latency(const char *what, int n, F &&f) {
+  vector<double> ms;
+  for (int i = 0; i < n; i++) {
+    auto t0 = chrono::steady_clock::now();
+    if (!f(i))
+      return;
+    ms.push_back(
+        chrono::duration<double, milli>(chrono::steady_clock::now() - t0)
+            .count());
+  }
+  sort(ms.begin(), ms.end());
+  cout << "  " << what << ": mediana " << ms[ms.size() / 2] << " ms, p99 "
+       << ms[ms.size() * 99 / 100] << " ms" << endl;
+}
+
+// El servidor corre en un hilo de este proceso y se le habla por el socket,
+// como lo haría un editor; en frío se lanza el compilador con el fuente en
+// un archivo. Los espacios agregados al final cambian la clave de la caché
+// sin cambiar el programa
+static int benchServer(const string &src, const string &compiler) {
+  string sock = "/tmp/kotlin_bench." + to_string(getpid()) + ".sock";
+  CompileServer server(sock);
+  string error;
+  if (!server.listen(error)) {
+    cerr << "server: " << error << endl;
+    return 1;
+  }
+  thread serving([&]() { server.serve(); });
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, sock.c_str(), sock.size() + 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+    cerr << "server: no se pudo conectar" << endl;
+    server.stop();
+    serving.join();
+    return 1;
+  }
+  auto request = [&](const string &text) {
+    uint8_t tag;
+    string reply;
+    if (!sendMessage(fd, kCompile, text) || !recvMessage(fd, tag, reply) ||
+        tag != kOk) {
+      cerr << "server: el pedido falló: " << reply << endl;
+      return false;
+    }
+    return true;
+  };
+
+  cout << "server: " << src.size() << " bytes por pedido" << endl;
+  request(src); // primer pedido: arena y tablas todavía frías
+  latency("servidor", 200,
+          [&](int i) { return request(src + string(i + 1, ' ')); });
+  latency("servidor, misma entrada (caché)", 200,
+          [&](int) { return request(src); });
+  close(fd);
+  server.stop();
+  serving.join();
+
+  string path = "/tmp/kotlin_bench." + to_string(getpid()) + ".txt";
+  ofstream(path, ios::binary) << src;
+  latency(("en frío (" + compiler + ")").c_str(), 20, [&](int) {
+    const char *args[] = {compiler.c_str(), "--no-cache", path.c_str(),
+                          "-o", "/dev/null", nullptr};
+    pid_t pid;
+    int status;
+    if (posix_spawn(&pid, compiler.c_str(), nullptr, nullptr,
+                    (char **)args, environ) != 0 ||
+        waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+      cerr << "  no se pudo correr " << compiler << "; sin medición en frío"
+           << endl;
+      return false;
+    }
+    return true;
+  });
+  unlink(path.c_str());
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  string what = argc > 1 ? argv[1] : "scanner";
+
+  if (what == "scanner")
+    return benchScanner(argc > 2 ? readFile(argv[2])
+                                 : syntheticSource(100000));
+  if (what == "eval")
+    return benchEval(argc > 2 ? readFile(argv[2]) : evalSource(100000));
+  if (what == "flat")
+    return benchFlat(argc > 2 ? readFile(argv[2]) : syntheticSource(100000));
+  if (what == "cache")
+    return benchCache(argc > 2 ? readFile(argv[2]) : syntheticSource(100000));
+  if (what == "visitor")
+    return benchVisitor(argc > 2 ? readFile(argv[2])
+                                 : syntheticSource(100000));
+
+  if (what == "expr")
+    return benchExpr(argc > 2 ? readFile(argv[2]) : exprSource(100000));
+  if (what == "parser")
+    return benchParser(argc > 2 ? readFile(argv[2]) : parserSource(100000));
+  if (what == "codegen")
+    return benchCodegen(argc > 2 ? readFile(argv[2]) : streamSource(5000));
+  if (what == "stream")
+    return benchStream(argc > 2 ? readFile(argv[2]) : streamSource(20000));
+  if (what == "stress")
+    return benchStress(1000000, 100000);
+  if (what == "server")
+    return benchServer(argc > 2 ? readFile(argv[2]) : streamSource(10),
+                       argc > 3 ? argv[3] : "./kotlin");
+
+  cerr << "Caso de benchmark desconocido: " << what << endl;
+  return 1;
+}
@@ -0,0 +1,83 @@
+// client.cpp
+// Cliente mínimo del servidor de compilación (ver server.h):
+//   kotlin_client SOCKET [-o salida.s] [archivo|-]
+// Manda el fuente (stdin si es "-" o si no hay archivo) y escribe el
+// assembly en stdout o en -o. No enlaza nada del compilador, así que
+// arranca en lo que tarda un proceso chico.
+// Sale con 0 si compiló, 1 si el fuente tiene errores y 2 por un error de
+// uso, de entrada/salida o de conexión.
+#include "server.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/un.h>
+
+using namespace std;
+
+int main(int argc, char **argv) {
+  string socketPath, input = "-", output = "-";
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "-o" && i + 1 < argc)
+      output = argv[++i];
+    else if (socketPath.empty())
+      socketPath = arg;
+    else
+      input = arg;
+  }
+  if (socketPath.empty()) {
+    cerr << "Uso: " << argv[0] << " SOCKET [-o salida.s] [archivo|-]" << endl;
+    return 2;
+  }
+
+  stringstream source;
+  if (input == "-") {
+    source << cin.rdbuf();
+  } else {
+    ifstream in(input, ios::binary);
+    if (!in) {
+      cerr << input << ": no se pudo leer el archivo" << endl;
+      return 2;
+    }
+    source << in.rdbuf();
+  }
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(addr.sun_path)) {
+    cerr << "ruta de socket demasiado larga: " << socketPath << endl;
+    return 2;
+  }
+  memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+    cerr << socketPath << ": no hay servidor escuchando" << endl;
+    return 2;
+  }
+
+  uint8_t tag;
+  string reply;
+  if (!sendMessage(fd, kCompile, source.str()) ||
+      !recvMessage(fd, tag, reply)) {
+    cerr << socketPath << ": se cortó la conexión" << endl;
+    return 2;
+  }
+  close(fd);
+
+  if (tag != kOk) {
+    cerr << (input == "-" ? "<stdin>" : input) << ": " << reply << endl;
+    return 1;
+  }
+  if (output == "-") {
+    cout << reply;
+    return cout.flush() ? 0 : 2;
+  }
+  ofstream out(output, ios::binary);
+  out << reply;
+  out.close();
+  if (!out) {
+    cerr << output << ": no se pudo escribir" << endl;
+    return 2;
+  }
+  return 0;
+}
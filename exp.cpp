@@ -1,55 +1,48 @@
 // exp.cpp
 #include "exp.h"
+#include "arena.h"
 #include "visitor.h"
 
 using namespace std;
 
 Program::Program(Body *b)
-    : vardecs(nullptr), classDecs(nullptr), funDecs(nullptr), body(b) {}
+    : vardecs(nullptr), classDecs(nullptr), funDecs(nullptr), body(b),
+      arena(nullptr) {}
 
-Program::~Program() {
-  delete vardecs;
-  delete classDecs;
-  delete funDecs;
-}
+Program::~Program() { delete arena; }
 
 // VarDecList
 VarDecList::VarDecList() {}
-VarDecList::~VarDecList() {
-  for (auto v : vars)
-    delete v;
-}
 void VarDecList::add(VarDec *var) { vars.push_back(var); }
 
 // ClassDecList
 ClassDecList::ClassDecList() {}
-ClassDecList::~ClassDecList() {
-  for (auto c : classes)
-    delete c;
-}
 void ClassDecList::add(ClassDec *cls) { classes.push_back(cls); }
 
 // FunDecList
 FunDecList::FunDecList() {}
-FunDecList::~FunDecList() {
-  for (auto f : functions)
-    delete f;
-}
 void FunDecList::add(FunDec *fn) { functions.push_back(fn); }
 
 // VarDec
-VarDec::VarDec(bool isMutable_, const vector<string> &names_,
-               const string typeName_, vector<Exp *> &inits_)
-    : isMutable(isMutable_), names(names_), typeName(typeName_), inits(inits_) {
+VarDec::VarDec(bool isMutable_, const vector<Symbol> &names_,
+               const Type *type_, vector<Exp *> &inits_)
+    : isMutable(isMutable_), names(names_), type(type_), inits(inits_) {
 }
 
 // ClassDec
-ClassDec::ClassDec(const string &name, const vector<Argument> &args,
+ClassDec::ClassDec(Symbol name, const vector<Argument> &args,
                    VarDecList *members)
     : name(name), args(args), members(members) {}
 
+const Field *ClassDec::field(Symbol name) const {
+  for (auto &f : layout)
+    if (f.name == name)
+      return &f;
+  return nullptr;
+}
+
 // FunDec
-FunDec::FunDec(const string &name, const string &retType,
+FunDec::FunDec(Symbol name, const Type *retType,
                const vector<Param> &params, Body *body)
     : name(name), retType(retType), params(params), body(body) {}
 
@@ -59,10 +52,6 @@ Body::Body(VarDecList *vardecs, StatementList *stmts)
 
 // StatementList
 StatementList::StatementList() {}
-StatementList::~StatementList() {
-  for (auto s : statements)
-    delete s;
-}
 void StatementList::add(Stm *stmt) { statements.push_back(stmt); }
 
 // Stm base
@@ -70,66 +59,73 @@ Stm::~Stm() {}
 
 // AssignStatement
 AssignStatement::AssignStatement(Exp *target, Exp *expr)
-    : target(target), expr(expr) {}
+    : Stm(Kind), target(target), expr(expr) {}
 
-AssignStatement::~AssignStatement() {
-  delete target;
-  delete expr;
-}
 // PrintStatement
-PrintStatement::PrintStatement(Exp *expr) : expr(expr) {}
+PrintStatement::PrintStatement(Exp *expr) : Stm(Kind), expr(expr) {}
 
 // ReturnStatement
-ReturnStatement::ReturnStatement(Exp *expr) : expr(expr) {}
+ReturnStatement::ReturnStatement(Exp *expr) : Stm(Kind), expr(expr) {}
 
 // IfStatement
 IfStatement::IfStatement(Exp *cond, Body *thenBranch, Body *elseBranch)
-    : cond(cond), thenBranch(thenBranch), elseBranch(elseBranch) {}
+    : Stm(Kind), cond(cond), thenBranch(thenBranch), elseBranch(elseBranch) {}
 
 // WhileStatement
 WhileStatement::WhileStatement(Exp *cond, Body *body)
-    : cond(cond), body(body) {}
+    : Stm(Kind), cond(cond), body(body) {}
 
 // ForStatement
-ForStatement::ForStatement(const string &varName, Exp *iterable, Body *body)
-    : varName(varName), iterable(iterable), body(body) {}
+ForStatement::ForStatement(Symbol varName, Exp *iterable, Body *body)
+    : Stm(Kind), varName(varName), iterable(iterable), body(body) {}
 
 // BinaryExp
 BinaryExp::BinaryExp(Exp *left, Exp *right, BinaryOp op)
-    : left(left), right(right), op(op) {}
+    : Exp(Kind), left(left), right(right), op(op) {}
 
 // IFExp
 IFExp::IFExp(Exp *cond, Exp *left, Exp *right)
-    : cond(cond), left(left), right(right) {}
+    : Exp(Kind), cond(cond), left(left), right(right) {}
 // NumberExp
-NumberExp::NumberExp(long long value) : value(value) {}
+NumberExp::NumberExp(long long value) : Exp(Kind), value(value) {}
 
 // BoolExp
-BoolExp::BoolExp(bool value) : value(value) {}
+BoolExp::BoolExp(bool value) : Exp(Kind), value(value) {}
 
 // IdentifierExp
-IdentifierExp::IdentifierExp(const string &name) : name(name) {}
+IdentifierExp::IdentifierExp(Symbol name) : Exp(Kind), name(name) {}
 
 // FCallExp
-FCallExp::FCallExp(const string &name) : name(name) {}
+FCallExp::FCallExp(Symbol name) : Exp(Kind), name(name) {}
 void FCallExp::add(Exp *arg) { args.push_back(arg); }
 
 // ListExp
-ListExp::ListExp(bool isMutable) : isMutable(isMutable) {}
+ListExp::ListExp(bool isMutable) : Exp(Kind), isMutable(isMutable) {}
 void ListExp::add(Exp *elem) { elements.push_back(elem); }
 
 // IndexExp
-IndexExp::IndexExp(const string &name, Exp *index) : name(name), index(index) {}
+IndexExp::IndexExp(Symbol name, Exp *index)
+    : Exp(Kind), name(name), index(index) {}
 
 // DotExp
-DotExp::DotExp(string i, const std::string &member)
-  : id(i), member(member) {}
+DotExp::DotExp(Symbol i, Symbol member)
+    : Exp(Kind), id(i), member(member) {}
 
 // LoopExp
 LoopExp::LoopExp(Exp *start, Exp *end, Exp *step, bool downTo)
-    : start(start), end(end), step(step), downTo(downTo) {}
+    : Exp(Kind), start(start), end(end), step(step), downTo(downTo) {}
+
+// ArrayInitExp
+ArrayInitExp::ArrayInitExp(const Type *elemType, Exp *size, Exp *body)
+    : Exp(Kind), elemType(elemType), size(size), body(body) {}
 
-int StringExp::accept(Visitor *v) { return v->visit(this); }
+bool ArrayInitExp::isZeroFill() const {
+  if (auto *n = node_cast<NumberExp>(body))
+    return n->value == 0;
+  if (auto *b = node_cast<BoolExp>(body))
+    return !b->value;
+  return false;
+}
 
 // Exp base
 Exp::~Exp() {}
@@ -148,74 +144,13 @@ std::string Exp::binopToChar(int op) {
     return "<";
   case GT_OP:
     return ">";
+  case LE_OP:
+    return "<=";
+  case GE_OP:
+    return ">=";
+  case EQ_OP:
+    return "==";
   default:
     return "?";
   }
 }
-
-// Expressions
-IFExp::~IFExp() {
-  delete cond;
-  delete left;
-  delete right;
-}
-BinaryExp::~BinaryExp() {
-  delete left;
-  delete right;
-}
-NumberExp::~NumberExp() {}
-BoolExp::~BoolExp() {}
-IdentifierExp::~IdentifierExp() {}
-FCallExp::~FCallExp() {
-  for (auto a : args)
-    delete a;
-}
-ListExp::~ListExp() {
-  for (auto e : elements)
-    delete e;
-}
-IndexExp::~IndexExp() { delete index; }
-DotExp::~DotExp() {
-}
-LoopExp::~LoopExp() {
-  delete start;
-  delete end;
-  if (step)
-    delete step;
-}
-
-// Statements
-PrintStatement::~PrintStatement() { delete expr; }
-ReturnStatement::~ReturnStatement() {
-  if (expr)
-    delete expr;
-}
-IfStatement::~IfStatement() {
-  delete cond;
-  delete thenBranch;
-  if (elseBranch)
-    delete elseBranch;
-}
-WhileStatement::~WhileStatement() {
-  delete cond;
-  delete body;
-}
-ForStatement::~ForStatement() {
-  delete iterable;
-  delete body;
-}
-
-// Declarations
-VarDec::~VarDec() {
-  if (inits.size() > 0) {
-    for (int i = 0; i < inits.size(); i++) {
-      delete inits[i];
-    }
-  }
-}
-ClassDec::~ClassDec() { delete members; }
-FunDec::~FunDec() { delete body; }
-Body::~Body() {
-  delete vardecs;
-  delete stmts;
-}
@@ -2,20 +2,64 @@
 #ifndef EXP_H
 #define EXP_H
 
+#include "arena.h"
+#include "symbol.h"
+#include "types.h"
+#include <cstdint>
 #include <string>
 #include <vector>
 
+
 using namespace std;
 
-// Forward-declaration del Visitor
-class Visitor;
+// Tipo concreto de cada nodo, fijado al construirlo. Sirve para clasificar
+// nodos con una carga y un salto (ver node_cast y match al final del
+// archivo) en lugar de encadenar dynamic_cast.
+enum class ExpKind : uint8_t {
+  Binary,
+  If,
+  String,
+  Number,
+  Bool,
+  Identifier,
+  FCall,
+  List,
+  Index,
+  Dot,
+  Loop,
+  ArrayInit
+};
+
+enum class StmKind : uint8_t { Assign, Print, Return, If, While, For };
+
+class FunDec;
+class ClassDec;
+struct Field;
+
+// Dónde vive una variable, lo fija el resolver (resolver.h) después de
+// parsear. 'depth' es 0 para el frame de la función actual y 1 para las
+// globales (no hay funciones anidadas); 'slot' es el índice en ese frame.
+// Así EVALVisitor usa arreglos planos y GenCodeVisitor offsets fijos en vez
+// de buscar el nombre scope por scope.
+struct Binding {
+  static constexpr uint8_t kLocal = 0;
+  static constexpr uint8_t kGlobal = 1;
+  static constexpr uint8_t kUnresolved = UINT8_MAX;
+  uint8_t depth = kUnresolved;
+  uint32_t slot = 0;
+  bool resolved() const { return depth != kUnresolved; }
+  bool isLocal() const { return depth == kLocal; }
+};
 
 // -----------------------------------------------------------------------------
 // Nodo base de expresiones
 // -----------------------------------------------------------------------------
 class Exp {
 public:
-  virtual int accept(Visitor *v) = 0;
+  const ExpKind kind;
+  const Type *type = nullptr; // tipo resuelto por TypeChecker (typecheck.h);
+                              // nullptr si no se pudo determinar
+  explicit Exp(ExpKind kind) : kind(kind) {}
   virtual ~Exp();
   static std::string binopToChar(int op);
 };
@@ -34,191 +78,209 @@ enum BinaryOp {
 
 class IFExp : public Exp {
 public:
+  static constexpr ExpKind Kind = ExpKind::If;
   Exp *cond;
   Exp *left;
   Exp *right;
   IFExp(Exp *cond, Exp *left, Exp *right);
-  int accept(Visitor *v) override;
-  ~IFExp();
 };
 
 class BinaryExp : public Exp {
 public:
+  static constexpr ExpKind Kind = ExpKind::Binary;
   Exp *left;
   Exp *right;
   BinaryOp op;
   BinaryExp(Exp *left, Exp *right, BinaryOp op);
-  int accept(Visitor *v) override;
-  ~BinaryExp();
 };
 
 class StringExp : public Exp {
 public:
+  static constexpr ExpKind Kind = ExpKind::String;
   std::string value;
-  StringExp(const std::string &value) : value(value) {}
-  int accept(Visitor *v) override;
-  ~StringExp() override {}
+  StringExp(const std::string &value) : Exp(Kind), value(value) {}
 };
 
 class NumberExp : public Exp {
 public:
+  static constexpr ExpKind Kind = ExpKind::Number;
   long long value;
   NumberExp(long long value);
-  int accept(Visitor *v) override;
-  ~NumberExp();
 };
 
 class BoolExp : public Exp {
 public:
+  static constexpr ExpKind Kind = ExpKind::Bool;
   bool value;
   BoolExp(bool value);
-  int accept(Visitor *v) override;
-  ~BoolExp();
 };
 
 class IdentifierExp : public Exp {
 public:
-  std::string name;
-  IdentifierExp(const std::string &name);
-  int accept(Visitor *v) override;
-  ~IdentifierExp();
+  static constexpr ExpKind Kind = ExpKind::Identifier;
+  Symbol name;
+  Binding bind;
+  IdentifierExp(Symbol name);
 };
 
 class FCallExp : public Exp {
 public:
-  std::string name;
+  static constexpr ExpKind Kind = ExpKind::FCall;
+  Symbol name;
   std::vector<Exp *> args;
-  FCallExp(const std::string &name);
+  FunDec *fn = nullptr;    // función de usuario; nullptr si es builtin o clase
+  ClassDec *cls = nullptr; // clase si la llamada es un constructor
+  FCallExp(Symbol name);
   void add(Exp *arg);
-  int accept(Visitor *v) override;
-  ~FCallExp();
 };
 
 class ListExp : public Exp {
 public:
+  static constexpr ExpKind Kind = ExpKind::List;
   bool isMutable;
   std::vector<Exp *> elements;
   ListExp(bool isMutable);
   void add(Exp *elem);
-  int accept(Visitor *v) override;
-  ~ListExp();
 };
 
 class IndexExp : public Exp {
 public:
-  std::string name;
+  static constexpr ExpKind Kind = ExpKind::Index;
+  Symbol name;
   Exp *index;
-  IndexExp(const std::string &name, Exp *index);
-  int accept(Visitor *v) override;
-  ~IndexExp();
+  Binding bind; // del arreglo
+  IndexExp(Symbol name, Exp *index);
 };
 
 class DotExp : public Exp {
 public:
-  string id;
-  std::string member;
-  DotExp(string i, const std::string &member);
-  int accept(Visitor *v) override;
-  ~DotExp();
+  static constexpr ExpKind Kind = ExpKind::Dot;
+  Symbol id;
+  Symbol member;
+  Binding bind;                // del objeto 'id'
+  const Field *field = nullptr; // campo accedido (TypeChecker)
+  DotExp(Symbol i, Symbol member);
 };
 
 class LoopExp : public Exp {
 public:
+  static constexpr ExpKind Kind = ExpKind::Loop;
   Exp *start;
   Exp *end;
   Exp *step; // puede ser nullptr
   bool downTo;
   LoopExp(Exp *start, Exp *end, Exp *step, bool downTo);
-  int accept(Visitor *v) override;
-  ~LoopExp();
 };
 
+// IntArray(n) { ... }, DoubleArray(n) { ... }, Array<T>(n) { ... }
+// Se guarda una sola copia del lambda; 'it' es el índice del elemento.
+class ArrayInitExp : public Exp {
+public:
+  static constexpr ExpKind Kind = ExpKind::ArrayInit;
+  const Type *elemType; // Int, Double o el T de Array<T> (nullptr si falta)
+  Exp *size;            // cualquier expresión, no sólo literales
+  Exp *body;
+  Binding it; // slot de 'it' mientras se evalúa el lambda
+  ArrayInitExp(const Type *elemType, Exp *size, Exp *body);
+  // true si el lambda es la constante 0/false (se puede usar calloc)
+  bool isZeroFill() const;
+};
+
+// Los nodos de expresión que sólo guardan punteros y valores no necesitan
+// destructor en la arena (ver NoFinalizer en arena.h): son la mayoría de los
+// nodos de un programa
+template <> struct NoFinalizer<BinaryExp> : std::true_type {};
+template <> struct NoFinalizer<IFExp> : std::true_type {};
+template <> struct NoFinalizer<NumberExp> : std::true_type {};
+template <> struct NoFinalizer<BoolExp> : std::true_type {};
+template <> struct NoFinalizer<IdentifierExp> : std::true_type {};
+template <> struct NoFinalizer<IndexExp> : std::true_type {};
+template <> struct NoFinalizer<DotExp> : std::true_type {};
+template <> struct NoFinalizer<LoopExp> : std::true_type {};
+template <> struct NoFinalizer<ArrayInitExp> : std::true_type {};
+
 // -----------------------------------------------------------------------------
 // Nodo base de sentencias
 // -----------------------------------------------------------------------------
 class Stm {
 public:
-  virtual int accept(Visitor *v) = 0;
+  const StmKind kind;
+  explicit Stm(StmKind kind) : kind(kind) {}
   virtual ~Stm();
 };
 
 class AssignStatement : public Stm {
 public:
+  static constexpr StmKind Kind = StmKind::Assign;
   Exp *target;
   Exp *expr;
   AssignStatement(Exp *target, Exp *expr);
-  int accept(Visitor *v) override;
-  ~AssignStatement();
 };
 
 class PrintStatement : public Stm {
 public:
+  static constexpr StmKind Kind = StmKind::Print;
   Exp *expr;
   PrintStatement(Exp *expr);
-  int accept(Visitor *v) override;
-  ~PrintStatement();
 };
 
 class ReturnStatement : public Stm {
 public:
+  static constexpr StmKind Kind = StmKind::Return;
   Exp *expr; // puede ser nullptr
   ReturnStatement(Exp *expr);
-  int accept(Visitor *v) override;
-  ~ReturnStatement();
 };
 
 class IfStatement : public Stm {
 public:
+  static constexpr StmKind Kind = StmKind::If;
   Exp *cond;
   class Body *thenBranch;
   class Body *elseBranch; // puede ser nullptr
   IfStatement(Exp *condition, Body *thenBranch, Body *elseBranch);
-  int accept(Visitor *v) override;
-  ~IfStatement();
 };
 
 class WhileStatement : public Stm {
 public:
+  static constexpr StmKind Kind = StmKind::While;
   Exp *cond;
   class Body *body;
   WhileStatement(Exp *condition, Body *body);
-  int accept(Visitor *v) override;
-  ~WhileStatement();
 };
 
 class ForStatement : public Stm {
 public:
-  std::string varName;
+  static constexpr StmKind Kind = StmKind::For;
+  Symbol varName;
   Exp *iterable;
   class Body *body;
-  ForStatement(const std::string &varName, Exp *iterable, Body *body);
-  int accept(Visitor *v) override;
-  ~ForStatement();
+  Binding bind; // variable del bucle; el slot siguiente guarda el índice
+                // cuando se recorre una lista
+  ForStatement(Symbol varName, Exp *iterable, Body *body);
 };
 
 // -----------------------------------------------------------------------------
 // Declaraciones y listas de declaraciones
 // -----------------------------------------------------------------------------
 struct Param {
-  std::string name;
-  std::string type;
+  Symbol name;
+  const Type *type;
 };
 
 struct Argument {
-  std::string name;
-  std::string type;
+  Symbol name;
+  const Type *type;
 };
 
 class VarDec {
 public:
   bool isMutable;
-  vector<string> names;
-  string typeName;
+  vector<Symbol> names;
+  const Type *type; // nullptr si no se escribió
   vector<Exp *> inits;
-  VarDec(bool isMutable_, const vector<string> &names_, const string typeNames_,
+  Binding bind; // del primer nombre; los demás van en los slots siguientes
+  VarDec(bool isMutable_, const vector<Symbol> &names_, const Type *type_,
          vector<Exp *> &inits_);
-  int accept(Visitor *v);
-  ~VarDec();
 };
 
 class VarDecList {
@@ -226,19 +288,30 @@ public:
   std::vector<VarDec *> vars;
   VarDecList();
   void add(VarDec *var);
-  int accept(Visitor *v);
-  ~VarDecList();
+};
+
+// Campo de un objeto: offset en bytes desde el inicio del objeto e 'init'
+// para los miembros con valor por defecto (nullptr para args del constructor)
+struct Field {
+  Symbol name;
+  const Type *type;
+  uint32_t offset;
+  Exp *init;
 };
 
 class ClassDec {
 public:
-  std::string name;
+  Symbol name;
   std::vector<Argument> args;
   VarDecList *members;
-  ClassDec(const std::string &name, const std::vector<Argument> &args,
+  // Layout del objeto, lo arma TypeChecker una sola vez por clase: primero
+  // los args del constructor y luego los miembros, cada uno de type->size
+  // bytes. GenCodeVisitor y EVALVisitor lo usan tal cual.
+  std::vector<Field> layout;
+  uint32_t bytes = 0;
+  ClassDec(Symbol name, const std::vector<Argument> &args,
            VarDecList *members);
-  int accept(Visitor *v);
-  ~ClassDec();
+  const Field *field(Symbol name) const; // nullptr si no existe
 };
 
 class ClassDecList {
@@ -246,20 +319,17 @@ public:
   std::vector<ClassDec *> classes;
   ClassDecList();
   void add(ClassDec *cls);
-  int accept(Visitor *v);
-  ~ClassDecList();
 };
 
 class FunDec {
 public:
-  std::string name;
-  std::string retType;
+  Symbol name;
+  const Type *retType; // nullptr si no se escribió
   std::vector<Param> params;
   class Body *body;
-  FunDec(const std::string &name, const std::string &retType,
+  uint32_t frameSize = 0; // slots del frame: primero params, luego locales
+  FunDec(Symbol name, const Type *retType,
          const std::vector<Param> &params, Body *body);
-  int accept(Visitor *v);
-  ~FunDec();
 };
 
 class FunDecList {
@@ -267,8 +337,6 @@ public:
   std::vector<FunDec *> functions;
   FunDecList();
   void add(FunDec *fn);
-  int accept(Visitor *v);
-  ~FunDecList();
 };
 
 class StatementList {
@@ -276,8 +344,6 @@ public:
   std::vector<Stm *> statements;
   StatementList();
   void add(Stm *stmt);
-  int accept(Visitor *v);
-  ~StatementList();
 };
 
 // -----------------------------------------------------------------------------
@@ -288,20 +354,105 @@ public:
   VarDecList *vardecs;
   StatementList *stmts;
   Body(VarDecList *vardecs, StatementList *stmts);
-  int accept(Visitor *v);
-  ~Body();
 };
 
+// Todos los nodos viven en 'arena' (ver Parser): borrar el Program libera el
+// AST completo de una vez, sin recorrerlo.
 class Program {
 public:
   VarDecList *vardecs;
   ClassDecList *classDecs;
   FunDecList *funDecs;
   Body *body;
+  Arena *arena; // dueño del AST
+  uint32_t globalSlots = 0;
   Program(Body *body);
   Program();
-  int accept(Visitor *v);
   ~Program();
 };
 
+// -----------------------------------------------------------------------------
+// Clasificación de nodos por 'kind'
+// -----------------------------------------------------------------------------
+
+// Como dynamic_cast<T *>(n) pero comparando el kind: nullptr si n es nulo o de
+// otro tipo.
+template <typename T, typename N> T *node_cast(N *n) {
+  return n && n->kind == T::Kind ? static_cast<T *>(n) : nullptr;
+}
+
+// Cadenas de BinaryExp: los operadores asocian a la izquierda, así que
+// a + b + c + ... queda como ((a + b) + c) + ..., un árbol tan profundo como
+// términos tenga. Quien lo recorra con recursión desborda la pila con
+// entradas generadas (un millón de términos), así que los visitors siguen la
+// espina izquierda con un bucle: pushLeftSpine apila en 'spine' los
+// BinaryExp desde e hacia adentro y devuelve el primer operando (el que ya
+// no es BinaryExp). Después se desapilan del más interno al más externo,
+// visitando cada 'right'. 'spine' se comparte entre llamadas anidadas: cada
+// una recuerda su tamaño al empezar y desapila hasta ahí.
+inline Exp *pushLeftSpine(BinaryExp *e, std::vector<BinaryExp *> &spine) {
+  Exp *cur = e;
+  while (auto *b = node_cast<BinaryExp>(cur)) {
+    spine.push_back(b);
+    cur = b->left;
+  }
+  return cur;
+}
+
+// Para armar un visitante con varias lambdas:
+//   match(e, Overload{[](NumberExp *n) {...}, [](auto *) {...}})
+template <typename... Fs> struct Overload : Fs... {
+  using Fs::operator()...;
+};
+template <typename... Fs> Overload(Fs...) -> Overload<Fs...>;
+
+// Llama a f con el tipo concreto de e (un solo switch sobre e->kind).
+template <typename F> decltype(auto) match(Exp *e, F &&f) {
+  switch (e->kind) {
+  case ExpKind::Binary:
+    return f(static_cast<BinaryExp *>(e));
+  case ExpKind::If:
+    return f(static_cast<IFExp *>(e));
+  case ExpKind::String:
+    return f(static_cast<StringExp *>(e));
+  case ExpKind::Number:
+    return f(static_cast<NumberExp *>(e));
+  case ExpKind::Bool:
+    return f(static_cast<BoolExp *>(e));
+  case ExpKind::Identifier:
+    return f(static_cast<IdentifierExp *>(e));
+  case ExpKind::FCall:
+    return f(static_cast<FCallExp *>(e));
+  case ExpKind::List:
+    return f(static_cast<ListExp *>(e));
+  case ExpKind::Index:
+    return f(static_cast<IndexExp *>(e));
+  case ExpKind::Dot:
+    return f(static_cast<DotExp *>(e));
+  case ExpKind::Loop:
+    return f(static_cast<LoopExp *>(e));
+  case ExpKind::ArrayInit:
+    break;
+  }
+  return f(static_cast<ArrayInitExp *>(e));
+}
+
+template <typename F> decltype(auto) match(Stm *s, F &&f) {
+  switch (s->kind) {
+  case StmKind::Assign:
+    return f(static_cast<AssignStatement *>(s));
+  case StmKind::Print:
+    return f(static_cast<PrintStatement *>(s));
+  case StmKind::Return:
+    return f(static_cast<ReturnStatement *>(s));
+  case StmKind::If:
+    return f(static_cast<IfStatement *>(s));
+  case StmKind::While:
+    return f(static_cast<WhileStatement *>(s));
+  case StmKind::For:
+    break;
+  }
+  return f(static_cast<ForStatement *>(s));
+}
+
 #endif // EXP_H
@@ -0,0 +1,725 @@
+// flat_ast.cpp
+#include "flat_ast.h"
+#include "arena.h"
+#include <unordered_map>
+
+using namespace std;
+
+using K = FlatAst::Kind;
+static const uint32_t kNone = FlatAst::kNone;
+
+size_t FlatAst::bytes() const {
+  return kind.size() * (sizeof(Kind) + sizeof(uint8_t) + 3 * sizeof(uint32_t)) +
+         extra.size() * sizeof(uint32_t) + numbers.size() * sizeof(long long) +
+         strings.size() * sizeof(string) + params.size() * sizeof(ParamEntry);
+}
+
+// -----------------------------------------------------------------------------
+// AST de punteros -> plano
+// -----------------------------------------------------------------------------
+namespace {
+
+class Flattener {
+public:
+  explicit Flattener(FlatAst &f) : f(f) {}
+
+  // Cada nodo recibe su id antes que sus hijos (preorden). Los campos se
+  // asignan después de construir los hijos: los vectores pueden crecer.
+  uint32_t node(K k, uint8_t flag = 0) {
+    uint32_t id = f.kind.size();
+    f.kind.push_back(k);
+    f.flag.push_back(flag);
+    f.a.push_back(kNone);
+    f.b.push_back(kNone);
+    f.c.push_back(kNone);
+    return id;
+  }
+
+  // Reserva n huecos contiguos en 'extra'
+  uint32_t reserve(size_t n) {
+    uint32_t at = f.extra.size();
+    f.extra.resize(at + n, kNone);
+    return at;
+  }
+
+  // Los textos se repiten mucho (tipos, literales): se guardan una vez
+  uint32_t str(const string &s) {
+    auto it = strIds.find(s);
+    if (it != strIds.end())
+      return it->second;
+    uint32_t id = f.strings.size();
+    f.strings.push_back(s);
+    strIds.emplace(s, id);
+    return id;
+  }
+
+  // Los tipos se guardan por su texto (Type::str()); "" si no hay tipo
+  uint32_t str(const Type *t) { return str(t ? t->str() : string()); }
+
+  // Hijos en 'extra': b = inicio, c = cantidad
+  template <typename T, typename F>
+  void children(uint32_t id, const vector<T *> &items, F &&one) {
+    uint32_t at = reserve(items.size());
+    f.b[id] = at;
+    f.c[id] = items.size();
+    for (size_t i = 0; i < items.size(); i++) {
+      uint32_t child = one(items[i]);
+      f.extra[at + i] = child;
+    }
+  }
+
+  uint32_t exp(Exp *e) {
+    if (!e)
+      return kNone;
+    return match(
+        e,
+        Overload{
+            [&](BinaryExp *x) {
+              // Espina izquierda con un bucle (ver pushLeftSpine). Sigue
+              // en preorden: los BinaryExp de afuera hacia adentro (ids
+              // consecutivos), el primer operando y cada 'right' de
+              // adentro hacia afuera.
+              size_t base = spine.size();
+              Exp *first = pushLeftSpine(x, spine);
+              size_t end = spine.size();
+              uint32_t id = f.kind.size();
+              for (size_t i = base; i < end; i++)
+                node(K::Binary, spine[i]->op);
+              uint32_t l = exp(first);
+              for (size_t i = end; i-- > base;) {
+                uint32_t at = id + (i - base);
+                uint32_t r = exp(spine[i]->right);
+                f.a[at] = i + 1 < end ? at + 1 : l;
+                f.b[at] = r;
+              }
+              spine.resize(base);
+              return id;
+            },
+            [&](IFExp *x) {
+              uint32_t id = node(K::IfExp);
+              uint32_t cond = exp(x->cond);
+              uint32_t l = exp(x->left);
+              uint32_t r = exp(x->right);
+              f.a[id] = cond;
+              f.b[id] = l;
+              f.c[id] = r;
+              return id;
+            },
+            [&](StringExp *x) {
+              uint32_t id = node(K::String);
+              f.a[id] = str(x->value);
+              return id;
+            },
+            [&](NumberExp *x) {
+              uint32_t id = node(K::Number);
+              f.a[id] = f.numbers.size();
+              f.numbers.push_back(x->value);
+              return id;
+            },
+            [&](BoolExp *x) { return node(K::Bool, x->value); },
+            [&](IdentifierExp *x) {
+              uint32_t id = node(K::Identifier);
+              f.a[id] = x->name.id();
+              return id;
+            },
+            [&](FCallExp *x) {
+              uint32_t id = node(K::FCall);
+              f.a[id] = x->name.id();
+              children(id, x->args, [&](Exp *arg) { return exp(arg); });
+              return id;
+            },
+            [&](ListExp *x) {
+              uint32_t id = node(K::List, x->isMutable);
+              children(id, x->elements, [&](Exp *el) { return exp(el); });
+              return id;
+            },
+            [&](IndexExp *x) {
+              uint32_t id = node(K::Index);
+              uint32_t idx = exp(x->index);
+              f.a[id] = x->name.id();
+              f.b[id] = idx;
+              return id;
+            },
+            [&](DotExp *x) {
+              uint32_t id = node(K::Dot);
+              f.a[id] = x->id.id();
+              f.b[id] = x->member.id();
+              return id;
+            },
+            [&](LoopExp *x) {
+              uint32_t id = node(K::Loop, x->downTo);
+              uint32_t start = exp(x->start);
+              uint32_t end = exp(x->end);
+              uint32_t step = exp(x->step);
+              f.a[id] = start;
+              f.b[id] = end;
+              f.c[id] = step;
+              return id;
+            },
+            [&](ArrayInitExp *x) {
+              uint32_t id = node(K::ArrayInit);
+              uint32_t size = exp(x->size);
+              uint32_t body = exp(x->body);
+              f.a[id] = str(x->elemType);
+              f.b[id] = size;
+              f.c[id] = body;
+              return id;
+            }});
+  }
+
+  uint32_t stm(Stm *s) {
+    return match(
+        s, Overload{
+               [&](AssignStatement *x) {
+                 uint32_t id = node(K::Assign);
+                 uint32_t target = exp(x->target);
+                 uint32_t e = exp(x->expr);
+                 f.a[id] = target;
+                 f.b[id] = e;
+                 return id;
+               },
+               [&](PrintStatement *x) {
+                 uint32_t id = node(K::Print);
+                 uint32_t e = exp(x->expr);
+                 f.a[id] = e;
+                 return id;
+               },
+               [&](ReturnStatement *x) {
+                 uint32_t id = node(K::Return);
+                 uint32_t e = exp(x->expr);
+                 f.a[id] = e;
+                 return id;
+               },
+               [&](IfStatement *x) {
+                 uint32_t id = node(K::IfStm);
+                 uint32_t cond = exp(x->cond);
+                 uint32_t thenB = body(x->thenBranch);
+                 uint32_t elseB = body(x->elseBranch);
+                 f.a[id] = cond;
+                 f.b[id] = thenB;
+                 f.c[id] = elseB;
+                 return id;
+               },
+               [&](WhileStatement *x) {
+                 uint32_t id = node(K::While);
+                 uint32_t cond = exp(x->cond);
+                 uint32_t b = body(x->body);
+                 f.a[id] = cond;
+                 f.b[id] = b;
+                 return id;
+               },
+               [&](ForStatement *x) {
+                 uint32_t id = node(K::For);
+                 uint32_t it = exp(x->iterable);
+                 uint32_t b = body(x->body);
+                 f.a[id] = x->varName.id();
+                 f.b[id] = it;
+                 f.c[id] = b;
+                 return id;
+               }});
+  }
+
+  uint32_t varDec(VarDec *d) {
+    uint32_t id = node(K::VarDec, d->isMutable);
+    size_t n = d->names.size(), m = d->inits.size();
+    uint32_t at = reserve(n + m + 2);
+    f.a[id] = str(d->type);
+    f.b[id] = at;
+    f.extra[at] = n;
+    for (size_t i = 0; i < n; i++)
+      f.extra[at + 1 + i] = d->names[i].id();
+    f.extra[at + 1 + n] = m;
+    for (size_t i = 0; i < m; i++) {
+      uint32_t init = exp(d->inits[i]);
+      f.extra[at + 2 + n + i] = init;
+    }
+    return id;
+  }
+
+  uint32_t varDecList(VarDecList *l) {
+    if (!l)
+      return kNone;
+    uint32_t id = node(K::VarDecList);
+    children(id, l->vars, [&](VarDec *d) { return varDec(d); });
+    return id;
+  }
+
+  uint32_t stmList(StatementList *l) {
+    if (!l)
+      return kNone;
+    uint32_t id = node(K::StatementList);
+    children(id, l->statements, [&](Stm *s) { return stm(s); });
+    return id;
+  }
+
+  uint32_t body(Body *b) {
+    if (!b)
+      return kNone;
+    uint32_t id = node(K::Body);
+    uint32_t vars = varDecList(b->vardecs);
+    uint32_t stmts = stmList(b->stmts);
+    f.a[id] = vars;
+    f.b[id] = stmts;
+    return id;
+  }
+
+  template <typename P> uint32_t paramList(const vector<P> &ps) {
+    uint32_t at = f.params.size();
+    for (auto &p : ps)
+      f.params.push_back({p.name.id(), str(p.type)});
+    return at;
+  }
+
+  uint32_t classDec(ClassDec *cd) {
+    uint32_t id = node(K::ClassDec);
+    uint32_t at = reserve(cd->args.size() + 1);
+    f.extra[at] = cd->args.size();
+    uint32_t first = paramList(cd->args);
+    for (size_t i = 0; i < cd->args.size(); i++)
+      f.extra[at + 1 + i] = first + i;
+    uint32_t members = varDecList(cd->members);
+    f.a[id] = cd->name.id();
+    f.b[id] = members;
+    f.c[id] = at;
+    return id;
+  }
+
+  uint32_t funDec(FunDec *fd) {
+    uint32_t id = node(K::FunDec);
+    uint32_t at = reserve(fd->params.size() + 2);
+    f.extra[at] = str(fd->retType);
+    f.extra[at + 1] = fd->params.size();
+    uint32_t first = paramList(fd->params);
+    for (size_t i = 0; i < fd->params.size(); i++)
+      f.extra[at + 2 + i] = first + i;
+    uint32_t b = body(fd->body);
+    f.a[id] = fd->name.id();
+    f.b[id] = b;
+    f.c[id] = at;
+    return id;
+  }
+
+  uint32_t program(const Program *p) {
+    uint32_t id = node(K::Program);
+    uint32_t vars = varDecList(p->vardecs);
+    uint32_t classes = kNone, funs = kNone;
+    if (p->classDecs) {
+      classes = node(K::ClassDecList);
+      children(classes, p->classDecs->classes,
+               [&](ClassDec *cd) { return classDec(cd); });
+    }
+    if (p->funDecs) {
+      funs = node(K::FunDecList);
+      children(funs, p->funDecs->functions,
+               [&](FunDec *fd) { return funDec(fd); });
+    }
+    f.a[id] = vars;
+    f.b[id] = classes;
+    f.c[id] = funs;
+    return id;
+  }
+
+private:
+  FlatAst &f;
+  unordered_map<string, uint32_t> strIds;
+  vector<BinaryExp *> spine; // ver exp(BinaryExp*)
+};
+
+// -----------------------------------------------------------------------------
+// Plano -> AST de punteros (adaptador para los visitors)
+// -----------------------------------------------------------------------------
+class Expander {
+public:
+  Expander(const FlatAst &f, Arena &arena) : f(f), arena(arena) {}
+
+  // Vuelve a internar el tipo: mismo texto, mismo puntero
+  const Type *type(uint32_t s) { return Type::parse(f.strings[s]); }
+
+  // Se crea el padre antes que los hijos para que la arena quede en el
+  // mismo orden que los arreglos planos.
+  Exp *exp(uint32_t id) {
+    if (id == kNone)
+      return nullptr;
+    switch (f.kind[id]) {
+    case K::Binary: {
+      // La espina izquierda con un bucle, en el mismo orden que Flattener
+      size_t base = spine.size();
+      uint32_t cur = id;
+      while (cur != kNone && f.kind[cur] == K::Binary) {
+        auto *x =
+            arena.make<BinaryExp>(nullptr, nullptr, (BinaryOp)f.flag[cur]);
+        if (spine.size() > base)
+          spine.back().first->left = x;
+        spine.emplace_back(x, cur);
+        cur = f.a[cur];
+      }
+      BinaryExp *top = spine[base].first;
+      spine.back().first->left = exp(cur);
+      while (spine.size() > base) {
+        auto [x, at] = spine.back();
+        spine.pop_back();
+        x->right = exp(f.b[at]);
+      }
+      return top;
+    }
+    case K::IfExp: {
+      auto *x = arena.make<IFExp>(nullptr, nullptr, nullptr);
+      x->cond = exp(f.a[id]);
+      x->left = exp(f.b[id]);
+      x->right = exp(f.c[id]);
+      return x;
+    }
+    case K::String:
+      return arena.make<StringExp>(f.strings[f.a[id]]);
+    case K::Number:
+      return arena.make<NumberExp>(f.numbers[f.a[id]]);
+    case K::Bool:
+      return arena.make<BoolExp>(f.flag[id] != 0);
+    case K::Identifier:
+      return arena.make<IdentifierExp>(Symbol(f.a[id]));
+    case K::FCall: {
+      auto *x = arena.make<FCallExp>(Symbol(f.a[id]));
+      for (auto *p = f.childBegin(id); p != f.childEnd(id); ++p)
+        x->add(exp(*p));
+      return x;
+    }
+    case K::List: {
+      auto *x = arena.make<ListExp>(f.flag[id] != 0);
+      for (auto *p = f.childBegin(id); p != f.childEnd(id); ++p)
+        x->add(exp(*p));
+      return x;
+    }
+    case K::Index: {
+      auto *x = arena.make<IndexExp>(Symbol(f.a[id]), nullptr);
+      x->index = exp(f.b[id]);
+      return x;
+    }
+    case K::Dot:
+      return arena.make<DotExp>(Symbol(f.a[id]), Symbol(f.b[id]));
+    case K::Loop: {
+      auto *x = arena.make<LoopExp>(nullptr, nullptr, nullptr, f.flag[id]);
+      x->start = exp(f.a[id]);
+      x->end = exp(f.b[id]);
+      x->step = exp(f.c[id]);
+      return x;
+    }
+    case K::ArrayInit: {
+      auto *x = arena.make<ArrayInitExp>(type(f.a[id]), nullptr, nullptr);
+      x->size = exp(f.b[id]);
+      x->body = exp(f.c[id]);
+      return x;
+    }
+    default:
+      return nullptr;
+    }
+  }
+
+  Stm *stm(uint32_t id) {
+    switch (f.kind[id]) {
+    case K::Assign: {
+      auto *x = arena.make<AssignStatement>(nullptr, nullptr);
+      x->target = exp(f.a[id]);
+      x->expr = exp(f.b[id]);
+      return x;
+    }
+    case K::Print: {
+      auto *x = arena.make<PrintStatement>(nullptr);
+      x->expr = exp(f.a[id]);
+      return x;
+    }
+    case K::Return: {
+      auto *x = arena.make<ReturnStatement>(nullptr);
+      x->expr = exp(f.a[id]);
+      return x;
+    }
+    case K::IfStm: {
+      auto *x = arena.make<IfStatement>(nullptr, nullptr, nullptr);
+      x->cond = exp(f.a[id]);
+      x->thenBranch = body(f.b[id]);
+      x->elseBranch = body(f.c[id]);
+      return x;
+    }
+    case K::While: {
+      auto *x = arena.make<WhileStatement>(nullptr, nullptr);
+      x->cond = exp(f.a[id]);
+      x->body = body(f.b[id]);
+      return x;
+    }
+    case K::For: {
+      auto *x = arena.make<ForStatement>(Symbol(f.a[id]), nullptr, nullptr);
+      x->iterable = exp(f.b[id]);
+      x->body = body(f.c[id]);
+      return x;
+    }
+    default:
+      return nullptr;
+    }
+  }
+
+  VarDec *varDec(uint32_t id) {
+    const uint32_t *e = f.extra.data() + f.b[id];
+    uint32_t n = e[0], m = e[n + 1];
+    vector<Symbol> names;
+    for (uint32_t i = 0; i < n; i++)
+      names.emplace_back(e[1 + i]);
+    vector<Exp *> inits;
+    auto *d = arena.make<VarDec>(f.flag[id] != 0, names, type(f.a[id]), inits);
+    for (uint32_t i = 0; i < m; i++)
+      d->inits.push_back(exp(e[n + 2 + i]));
+    return d;
+  }
+
+  VarDecList *varDecList(uint32_t id) {
+    if (id == kNone)
+      return nullptr;
+    auto *l = arena.make<VarDecList>();
+    for (auto *p = f.childBegin(id); p != f.childEnd(id); ++p)
+      l->add(varDec(*p));
+    return l;
+  }
+
+  Body *body(uint32_t id) {
+    if (id == kNone)
+      return nullptr;
+    auto *b = arena.make<Body>(nullptr, nullptr);
+    b->vardecs = varDecList(f.a[id]);
+    if (f.b[id] != kNone) {
+      b->stmts = arena.make<StatementList>();
+      for (auto *p = f.childBegin(f.b[id]); p != f.childEnd(f.b[id]); ++p)
+        b->stmts->add(stm(*p));
+    }
+    return b;
+  }
+
+  template <typename P> vector<P> paramList(const uint32_t *e, uint32_t n) {
+    vector<P> ps;
+    for (uint32_t i = 0; i < n; i++) {
+      const FlatAst::ParamEntry &pe = f.params[e[i]];
+      ps.push_back({Symbol(pe.name), type(pe.type)});
+    }
+    return ps;
+  }
+
+  ClassDec *classDec(uint32_t id) {
+    const uint32_t *e = f.extra.data() + f.c[id];
+    auto args = paramList<Argument>(e + 1, e[0]);
+    auto *cd = arena.make<ClassDec>(Symbol(f.a[id]), args, nullptr);
+    cd->members = varDecList(f.b[id]);
+    return cd;
+  }
+
+  FunDec *funDec(uint32_t id) {
+    const uint32_t *e = f.extra.data() + f.c[id];
+    auto params = paramList<Param>(e + 2, e[1]);
+    auto *fd = arena.make<FunDec>(Symbol(f.a[id]), type(e[0]), params, nullptr);
+    fd->body = body(f.b[id]);
+    return fd;
+  }
+
+  void program(Program *prog, uint32_t id) {
+    prog->vardecs = varDecList(f.a[id]);
+    if (f.b[id] != kNone) {
+      prog->classDecs = arena.make<ClassDecList>();
+      for (auto *p = f.childBegin(f.b[id]); p != f.childEnd(f.b[id]); ++p)
+        prog->classDecs->add(classDec(*p));
+    }
+    if (f.c[id] != kNone) {
+      prog->funDecs = arena.make<FunDecList>();
+      for (auto *p = f.childBegin(f.c[id]); p != f.childEnd(f.c[id]); ++p)
+        prog->funDecs->add(funDec(*p));
+      // el body del programa es el de main, como en el Parser
+      for (auto *fd : prog->funDecs->functions) {
+        if (fd->name == sym::main) {
+          prog->body = fd->body;
+          break;
+        }
+      }
+    }
+  }
+
+private:
+  const FlatAst &f;
+  Arena &arena;
+  vector<pair<BinaryExp *, uint32_t>> spine; // ver exp(K::Binary)
+};
+
+// -----------------------------------------------------------------------------
+// Validación (ver FlatAst::wellFormed)
+// -----------------------------------------------------------------------------
+class Checker {
+public:
+  explicit Checker(const FlatAst &f) : f(f), seen(f.size(), false) {}
+
+  bool tree() {
+    size_t n = f.size();
+    if (f.flag.size() != n || f.a.size() != n || f.b.size() != n ||
+        f.c.size() != n)
+      return false;
+    for (uint32_t id = 0; id < n; id++)
+      if (f.kind[id] > K::Program)
+        return false;
+    for (auto &p : f.params)
+      if (!str(p.type))
+        return false;
+    if (f.root == kNone)
+      return true;
+    if (f.root >= n || f.kind[f.root] != K::Program)
+      return false;
+    seen[f.root] = true;
+    // Un recorrido lineal alcanza: los hijos tienen id mayor que el padre
+    for (uint32_t id = 0; id < n; id++)
+      if (!node(id))
+        return false;
+    return true;
+  }
+
+private:
+  bool node(uint32_t id) {
+    uint32_t a = f.a[id], b = f.b[id], c = f.c[id];
+    switch (f.kind[id]) {
+    case K::Binary:
+      return f.flag[id] <= EQ_OP && exp(id, a) && exp(id, b);
+    case K::IfExp:
+      return exp(id, a) && exp(id, b) && exp(id, c);
+    case K::String:
+      return str(a);
+    case K::Number:
+      return a < f.numbers.size();
+    case K::Bool:
+    case K::Identifier:
+    case K::Dot:
+      return true;
+    case K::FCall:
+    case K::List:
+      return items(id, [&](uint32_t x) { return exp(id, x); });
+    case K::Index:
+      return exp(id, b);
+    case K::Loop:
+      return exp(id, a) && exp(id, b) && exp(id, c, true);
+    case K::ArrayInit:
+      return str(a) && exp(id, b) && exp(id, c);
+    case K::Assign:
+      return exp(id, a) && exp(id, b);
+    case K::Print:
+      return exp(id, a);
+    case K::Return:
+      return exp(id, a, true);
+    case K::IfStm:
+      return exp(id, a) && is(id, b, K::Body, false) && is(id, c, K::Body);
+    case K::While:
+      return exp(id, a) && is(id, b, K::Body, false);
+    case K::For:
+      return exp(id, b) && is(id, c, K::Body, false);
+    case K::VarDec: {
+      if (!str(a) || !range(b, 1))
+        return false;
+      uint64_t n = f.extra[b];
+      if (!range(b, n + 2))
+        return false;
+      uint64_t m = f.extra[b + n + 1];
+      if (!range(b, n + 2 + m))
+        return false;
+      for (uint64_t i = 0; i < m; i++)
+        if (!exp(id, f.extra[b + n + 2 + i], true))
+          return false;
+      return true;
+    }
+    case K::VarDecList:
+      return items(id, [&](uint32_t x) { return is(id, x, K::VarDec, false); });
+    case K::ClassDec:
+      return is(id, b, K::VarDecList) && params(c, 1);
+    case K::ClassDecList:
+      return items(id,
+                   [&](uint32_t x) { return is(id, x, K::ClassDec, false); });
+    case K::FunDec:
+      return is(id, b, K::Body) && range(c, 1) && str(f.extra[c]) &&
+             params(c, 2);
+    case K::FunDecList:
+      return items(id, [&](uint32_t x) { return is(id, x, K::FunDec, false); });
+    case K::StatementList:
+      return items(id, [&](uint32_t x) { return link(id, x) && f.isStm(x); });
+    case K::Body:
+      return is(id, a, K::VarDecList) && is(id, b, K::StatementList);
+    case K::Program:
+      return is(id, a, K::VarDecList) && is(id, b, K::ClassDecList) &&
+             is(id, c, K::FunDecList);
+    }
+    return false;
+  }
+
+  // Un hijo va después del padre (preorden) y tiene un solo padre: así
+  // toProgram() no entra en ciclos ni expande un nodo dos veces
+  bool link(uint32_t parent, uint32_t x) {
+    if (x >= f.size() || x <= parent || seen[x])
+      return false;
+    seen[x] = true;
+    return true;
+  }
+
+  bool exp(uint32_t parent, uint32_t x, bool optional = false) {
+    if (x == kNone)
+      return optional;
+    return link(parent, x) && f.isExp(x);
+  }
+
+  bool is(uint32_t parent, uint32_t x, K k, bool optional = true) {
+    if (x == kNone)
+      return optional;
+    return link(parent, x) && f.kind[x] == k;
+  }
+
+  bool str(uint32_t s) { return s < f.strings.size(); }
+
+  // [at, at + count) cabe en 'extra'
+  bool range(uint64_t at, uint64_t count) {
+    return at <= f.extra.size() && count <= f.extra.size() - at;
+  }
+
+  // Hijos en extra[b, b + c) de un nodo lista / FCall / List
+  template <typename F> bool items(uint32_t id, F &&each) {
+    if (!range(f.b[id], f.c[id]))
+      return false;
+    for (auto *p = f.childBegin(id); p != f.childEnd(id); ++p)
+      if (!each(*p))
+        return false;
+    return true;
+  }
+
+  // extra[at + skip - 1] = n seguido de n índices en 'params' (ClassDec y
+  // FunDec)
+  bool params(uint32_t at, uint64_t skip) {
+    if (!range(at, skip))
+      return false;
+    uint64_t n = f.extra[at + skip - 1];
+    if (!range(at, skip + n))
+      return false;
+    for (uint64_t i = 0; i < n; i++)
+      if (f.extra[at + skip + i] >= f.params.size())
+        return false;
+    return true;
+  }
+
+  const FlatAst &f;
+  vector<bool> seen;
+};
+
+} // namespace
+
+FlatAst FlatAst::build(const Program *prog) {
+  FlatAst f;
+  Flattener flat(f);
+  f.root = flat.program(prog);
+  return f;
+}
+
+Program *FlatAst::toProgram() const {
+  Program *prog = new Program(nullptr);
+  prog->arena = new Arena();
+  if (root != kNone) {
+    Expander expand(*this, *prog->arena);
+    expand.program(prog, root);
+  }
+  return prog;
+}
+
+bool FlatAst::wellFormed() const { return Checker(*this).tree(); }
@@ -0,0 +1,221 @@
+// flat_ast.h
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "exp.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// AST plano (struct-of-arrays): cada nodo es un índice de 32 bits y sus datos
+// viven en arreglos contiguos, uno por campo. Los hijos de longitud variable
+// (argumentos, elementos, sentencias, ...) van en el arreglo lateral 'extra'.
+// Recorrer un cuerpo de bucle toca unos pocos arreglos densos en vez de
+// saltar entre objetos sueltos del heap.
+//
+// Codificación por tipo de nodo (a, b, c; 'flag' es un byte):
+//   Binary      a=izq  b=der  flag=BinaryOp
+//   IfExp       a=cond b=then c=else
+//   String      a=string
+//   Number      a=índice en 'numbers'
+//   Bool        flag=valor
+//   Identifier  a=símbolo
+//   FCall       a=símbolo       b,c=rango de args en extra
+//   List        flag=mutable    b,c=rango de elementos en extra
+//   Index       a=símbolo b=índice
+//   Dot         a=símbolo b=miembro (símbolo)
+//   Loop        a=inicio b=fin c=step (o kNone) flag=downTo
+//   ArrayInit   a=string (tipo) b=tamaño c=lambda
+//   Assign      a=destino b=expr
+//   Print       a=expr
+//   Return      a=expr (o kNone)
+//   IfStm       a=cond b=Body c=Body else (o kNone)
+//   While       a=cond b=Body
+//   For         a=símbolo b=iterable c=Body
+//   VarDec      a=string (tipo) b=inicio en extra flag=mutable
+//               extra[b]=n, n símbolos, extra[b+n+1]=m, m inits (o kNone)
+//   ClassDec    a=símbolo b=VarDecList c=inicio en extra
+//               extra[c]=n, n índices en 'params'
+//   FunDec      a=símbolo b=Body c=inicio en extra
+//               extra[c]=string (tipo de retorno), extra[c+1]=n, n params
+//   *List       b,c=rango de hijos en extra
+//   Body        a=VarDecList b=StatementList
+//   Program     a=VarDecList b=ClassDecList c=FunDecList
+// Donde dice "string" es un índice en 'strings'; "símbolo" es Symbol::id().
+// Los tipos se guardan como el string de Type::str() ("" si no hay tipo).
+class FlatAst {
+public:
+  enum class Kind : uint8_t {
+    // expresiones
+    Binary,
+    IfExp,
+    String,
+    Number,
+    Bool,
+    Identifier,
+    FCall,
+    List,
+    Index,
+    Dot,
+    Loop,
+    ArrayInit,
+    // sentencias
+    Assign,
+    Print,
+    Return,
+    IfStm,
+    While,
+    For,
+    // declaraciones
+    VarDec,
+    VarDecList,
+    ClassDec,
+    ClassDecList,
+    FunDec,
+    FunDecList,
+    StatementList,
+    Body,
+    Program
+  };
+
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  struct ParamEntry {
+    uint32_t name; // símbolo
+    uint32_t type; // string
+  };
+
+  // Arreglos por nodo (todos del mismo largo)
+  std::vector<Kind> kind;
+  std::vector<uint8_t> flag;
+  std::vector<uint32_t> a, b, c;
+
+  // Arreglos laterales
+  std::vector<uint32_t> extra;
+  std::vector<long long> numbers;
+  std::vector<std::string> strings;
+  std::vector<ParamEntry> params;
+
+  uint32_t root = kNone; // nodo Program
+
+  size_t size() const { return kind.size(); }
+  bool isExp(uint32_t id) const { return kind[id] <= Kind::ArrayInit; }
+  bool isStm(uint32_t id) const {
+    return kind[id] >= Kind::Assign && kind[id] <= Kind::For;
+  }
+
+  // Rango [first, first+count) de hijos de un nodo lista / FCall / List
+  const uint32_t *childBegin(uint32_t id) const {
+    return extra.data() + b[id];
+  }
+  const uint32_t *childEnd(uint32_t id) const {
+    return extra.data() + b[id] + c[id];
+  }
+
+  // Llama a fn(hijo) por cada nodo hijo de id, en orden
+  template <typename F> void forEachChild(uint32_t id, F &&fn) const;
+
+  // Llama a fn(ref) por cada campo que guarda un Symbol::id(), para poder
+  // traducirlos (p.ej. al guardar o cargar la caché de AST)
+  template <typename F> void forEachSymbol(F &&fn);
+
+  // Bytes ocupados por todos los arreglos (sin contar el texto de strings)
+  size_t bytes() const;
+
+  // Pasa un AST de punteros a la forma plana, en preorden
+  static FlatAst build(const Program *prog);
+
+  // Adaptador para los visitors existentes (PrintVisitor, EVALVisitor,
+  // GenCodeVisitor): reconstruye un AST de punteros en una arena nueva, con
+  // los nodos en el mismo orden (preorden) que los arreglos planos.
+  Program *toProgram() const;
+
+  // true si los arreglos forman un árbol que toProgram() puede recorrer:
+  // tipos de nodo válidos, cada hijo del tipo que espera su campo, después
+  // del padre y con un solo padre, y los índices en 'extra', 'strings',
+  // 'numbers' y 'params' dentro de rango. No mira los símbolos. Hace falta
+  // antes de confiar en un FlatAst leído de disco
+  bool wellFormed() const;
+};
+
+template <typename F>
+void FlatAst::forEachChild(uint32_t id, F &&fn) const {
+  auto opt = [&](uint32_t child) {
+    if (child != kNone)
+      fn(child);
+  };
+  switch (kind[id]) {
+  case Kind::String:
+  case Kind::Number:
+  case Kind::Bool:
+  case Kind::Identifier:
+  case Kind::Dot:
+    break;
+  case Kind::Index:
+    fn(b[id]);
+    break;
+  case Kind::ArrayInit:
+    fn(b[id]);
+    fn(c[id]);
+    break;
+  case Kind::FCall:
+  case Kind::List:
+  case Kind::VarDecList:
+  case Kind::ClassDecList:
+  case Kind::FunDecList:
+  case Kind::StatementList:
+    for (const uint32_t *p = childBegin(id); p != childEnd(id); ++p)
+      fn(*p);
+    break;
+  case Kind::VarDec: {
+    const uint32_t *e = extra.data() + b[id];
+    uint32_t n = e[0], m = e[n + 1];
+    for (uint32_t i = 0; i < m; i++)
+      opt(e[n + 2 + i]);
+    break;
+  }
+  case Kind::ClassDec:
+  case Kind::FunDec:
+    opt(b[id]);
+    break;
+  case Kind::For:
+    fn(b[id]);
+    fn(c[id]);
+    break;
+  default: // hijos en a, b, c
+    opt(a[id]);
+    opt(b[id]);
+    opt(c[id]);
+  }
+}
+
+template <typename F> void FlatAst::forEachSymbol(F &&fn) {
+  for (uint32_t id = 0; id < size(); id++) {
+    switch (kind[id]) {
+    case Kind::Identifier:
+    case Kind::FCall:
+    case Kind::Index:
+    case Kind::For:
+    case Kind::ClassDec:
+    case Kind::FunDec:
+      fn(a[id]);
+      break;
+    case Kind::Dot:
+      fn(a[id]);
+      fn(b[id]);
+      break;
+    case Kind::VarDec: {
+      uint32_t *e = extra.data() + b[id];
+      for (uint32_t i = 0; i < e[0]; i++)
+        fn(e[1 + i]);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  for (auto &p : params)
+    fn(p.name);
+}
+
+#endif // FLAT_AST_H
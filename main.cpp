@@ -1,11 +1,27 @@
+#include "arena.h"
+#include "asm_cache.h"
+#include "ast_cache.h"
+#include "parallel.h"
+#include "mem_report.h"
 #include "parser.h"
+#include "resolver.h"
 #include "scanner.h"
+#include "server.h"
+#include "source.h"
+#include "streaming.h"
+#include "timing.h"
+#include "typecheck.h"
 #include "visitor.h"
 #include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
 #include <dirent.h>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace std;
@@ -24,17 +40,297 @@ string get_before_dot(string input) {
   }
 }
 
-int main() {
+// Salida por defecto de un archivo de la línea de comandos: la extensión
+// del nombre (no la de un directorio, como en d.v1/x.txt) cambia a .s; sin
+// extensión se agrega
+static string assemblyPath(const string &path) {
+  size_t slash = path.rfind('/');
+  size_t name = slash == string::npos ? 0 : slash + 1;
+  size_t dot = path.rfind('.');
+  if (dot == string::npos || dot <= name) // sin punto, o ".oculto"
+    return path + ".s";
+  return path.substr(0, dot) + ".s";
+}
+
+struct Options {
+  bool useCache = true, rebuildCache = false, stream = false;
+  unsigned jobs = defaultJobs();
+  // -O0/-O1/-O2: se aceptan para que los sistemas de build puedan pasarlos,
+  // pero hoy no hay pasadas de optimización y el .s es el mismo
+  int optLevel = 0;
+  string output;         // -o; "-" es stdout
+  string serve;          // --serve: socket del servidor de compilación
+  bool timeReport = false; // -ftime-report
+  bool memReport = false;  // --mem-report
+  string trace;            // --trace: archivo JSON de trace_event
+  vector<string> inputs; // archivos de la línea de comandos; "-" es stdin
+};
+
+const string prefix_input = "tests/";
+const string prefix_output = "outputs/";
+
+struct Caches {
+  AstCache ast;
+  AsmCache assembly;
+};
+
+// Escribe 'text' en 'path' salvo que el archivo ya tenga exactamente eso: un
+// .s que no cambió conserva su fecha y no dispara nada en quien dependa de él
+static bool writeIfChanged(const string &path, string_view text) {
+  {
+    SourceFile old;
+    if (old.open(path) && old.text() == text)
+      return true;
+  }
+  ofstream file(path, ios::binary);
+  file << text;
+  file.close();
+  return bool(file);
+}
+
+// Lo que se mide de un archivo: tiempos (-ftime-report) y memoria
+// (--mem-report); nullptr si no se pidió
+struct Reports {
+  TimeReport *time = nullptr;
+  MemReport *mem = nullptr;
+};
 
-  string prefix_input = "tests/";
-  string prefix_output = "outputs/";
+// Una fase de la compilación: su tramo de tiempo (y de la traza) y lo que
+// pide de memoria
+struct Phase {
+  Span span;
+  MemScope mem;
+  Phase(const char *name, const Reports &r)
+      : span(name, "fase", r.time), mem(name, r.mem) {}
+  PhaseTime end() {
+    mem.end();
+    return span.end();
+  }
+};
+
+// Compila 'text' y escribe el assembly en 'out'. Lanza con el primer error
+// (de parseo, de tipos o de generación); 'log' recibe el detalle de cada
+// paso. Es seguro llamarla desde varios hilos a la vez; 'batch' dice si se
+// compilan otros archivos al mismo tiempo. true si el assembly salió entero
+// de la caché. Suma a 'reports' el tiempo y la memoria de cada fase.
+static bool compileSource(string_view text, const Options &opt, bool batch,
+                          const Caches &caches, ostream &out, ostream &log,
+                          const Reports &reports = Reports()) {
+  if (opt.stream) {
+    Phase phase("stream", reports);
+    StreamStats st = compileStreaming(text, out);
+    log << "Compilado por funciones: " << st.functions
+        << " funciones, encabezado " << st.headerBytes
+        << " bytes, función más grande " << st.maxFunctionBytes
+        << " bytes en arena\n";
+    return false;
+  }
+
+  // Mismo fuente, mismo compilador y mismas opciones: mismo .s
+  uint64_t asmKey = AsmCache::key(text, "O" + to_string(opt.optLevel));
+  string cached;
+  Phase lookup("caché", reports);
+  if (opt.useCache && !opt.rebuildCache &&
+      caches.assembly.load(asmKey, cached)) {
+    out << cached;
+    log << "Assembly cargado de caché (" << caches.assembly.pathFor(asmKey)
+        << ")\n";
+    return true;
+  }
+
+  // Si el fuente no cambió desde la última vez, el AST sale de la caché
+  const AstCache &cache = caches.ast;
+  Program *program = nullptr;
+  uint64_t key = AstCache::hash(text);
+  FlatAst flat;
+  if (opt.useCache && !opt.rebuildCache && cache.load(key, flat)) {
+    program = flat.toProgram();
+    lookup.end();
+    log << "AST cargado de caché (" << cache.pathFor(key) << ")\n";
+  } else {
+    lookup.end();
+    Scanner scanner(text);
+    log << "Scanner exitoso\n";
+    log << "\n";
+    log << "Iniciando parsing:\n";
+    PhaseTime parse;
+    {
+      Phase phase("parser", reports);
+      Parser parser(&scanner, false);
+      program = parser.parseProgram();
+      parse = phase.end();
+    }
+    // El parser pide los tokens de a uno y medir cada pedido costaría más
+    // que el token: el scanner se mide después, en una pasada aparte sobre
+    // el texto ya leído, y se descuenta de la fila del parser
+    if (reports.time || reports.mem || Trace::active()) {
+      Phase phase("scanner", reports);
+      Scanner lexer(text);
+      size_t tokens = 0;
+      for (Token t = lexer.nextToken();
+           t.type != Token::END && t.type != Token::ERR; t = lexer.nextToken())
+        tokens++;
+      PhaseTime scan = phase.end();
+      if (reports.time)
+        reports.time->add("parser", -min(scan.wall, parse.wall),
+                          -min(scan.cpu, parse.cpu));
+      // Los tokens van por valor y no se guardan: esto es lo que ocuparían
+      if (reports.mem)
+        reports.mem->note("tokens", tokens, tokens * sizeof(Token));
+    }
+    log << "Parsing exitoso\n";
+    Phase store("caché", reports);
+    if (opt.useCache && !cache.store(key, FlatAst::build(program)))
+      log << "No se pudo guardar la caché de AST\n";
+  }
+  unique_ptr<Program> owner(program);
+  if (reports.mem)
+    reports.mem->note("arena del AST", program->arena->chunkCount(),
+                      program->arena->bytesReserved());
+  log << "AST: " << program->arena->objectCount() << " nodos, "
+      << program->arena->bytesUsed() << " bytes en arena ("
+      << program->arena->chunkCount() << " bloques)\n"
+      << "\n";
+  // Nombres -> slots de frame / FunDec*, y después tipos: si hay
+  // errores de tipo se reportan acá y no se genera código
+  {
+    Phase phase("resolver", reports);
+    Resolver().resolve(program);
+  }
+  {
+    Phase phase("tipos", reports);
+    TypeChecker().check(program);
+  }
+  log << "Iniciando Visitor:\n";
+  // PrintVisitor printVisitor;
+  // cout << "IMPRIMIR:" << endl;
+  // printVisitor.imprimir(program);
+  // cout << endl;
+  // EVALVisitor evalVisitor;
+  // cout << "EJECUTAR:" << endl;
+  // evalVisitor.ejecutar(program);
+  // cout << "Ejecución exitosa" << endl;
+  // cout << endl;
+  log << "Generando código assembly:\n";
+  stringstream code;
+  {
+    // Adentro, un Span por función (GenCodeVisitor::genFunction)
+    Phase phase("codegen", reports);
+    GenCodeVisitor<ostream> genVisitor(code);
+    // Con varios archivos a la vez los hilos ya están ocupados; con
+    // --mem-report todo tiene que pedirse en este hilo para contarse
+    if ((batch && opt.jobs > 1) || reports.mem)
+      genVisitor.setJobs(1);
+    genVisitor.generate(program);
+    phase.end();
+    if (reports.mem)
+      genVisitor.forEachStructure(
+          [&](const char *name, size_t entries, size_t bytes) {
+            reports.mem->note(name, entries, bytes);
+          });
+  }
+  string assembly = code.str();
+  {
+    Phase store("caché", reports);
+    if (opt.useCache && !caches.assembly.store(asmKey, assembly))
+      log << "No se pudo guardar la caché de assembly\n";
+  }
+  out << assembly;
+  return false;
+}
+
+// Compila tests/<path> a outputs/<path sin extensión>.s. Corre en cualquier
+// hilo del pool: todo lo que informa va a 'log' (el driver lo imprime al
+// final, en orden) y nada sale con exit ni con una excepción. false si el
+// archivo no se pudo compilar; 'cached' dice si el .s salió de la caché.
+static bool compileFile(const string &path, const Options &opt,
+                        const Caches &caches, ostream &log, bool &cached) {
+  log << "---------------------------------------------------\n";
+  log << "path: " << path << "\n";
+  TimeReport times;
+  MemReport memory;
+  Reports reports;
+  if (opt.timeReport)
+    reports.time = &times;
+  if (opt.memReport) {
+    reports.mem = &memory;
+    memory.begin();
+  }
+  Span file(path, "archivo");
+  // Los reportes van al final del log, con lo que se haya llegado a medir
+  struct PrintReports {
+    const Reports &reports;
+    const string &path;
+    ostream &log;
+    ~PrintReports() {
+      if (reports.time)
+        reports.time->print(log, path);
+      if (reports.mem)
+        reports.mem->print(log, path);
+    }
+  } printReports{reports, path, log};
+
+  // El archivo se mapea y el Scanner lo recorre sin copiarlo
+  SourceFile source;
+  if (!source.open(prefix_input + path)) {
+    log << "No se pudo abrir el archivo: " << path << "\n";
+    return false;
+  }
+
+  try {
+    string target = prefix_output + get_before_dot(path) + ".s";
+    if (opt.stream) {
+      // Directo al archivo: no se arma el .s entero en memoria. Va a un
+      // temporal que se renombra al final, así un error en una función de
+      // más abajo no deja un .s a medias que parezca bueno
+      string tmp = target + ".tmp";
+      ofstream outfile(tmp, ios::binary);
+      try {
+        if (outfile)
+          compileSource(source.text(), opt, true, caches, outfile, log,
+                        reports);
+        outfile.close();
+      } catch (...) {
+        remove(tmp.c_str());
+        throw;
+      }
+      if (!outfile || rename(tmp.c_str(), target.c_str()) != 0) {
+        remove(tmp.c_str());
+        log << "No se pudo escribir " << target << "\n";
+        return false;
+      }
+      log << "\n";
+      log << "Ejecución finalizada con éxito.\n";
+      return true;
+    }
+    stringstream out;
+    cached =
+        compileSource(source.text(), opt, true, caches, out, log, reports);
+    Phase write("escritura", reports);
+    if (!writeIfChanged(target, out.str())) {
+      log << "No se pudo escribir " << target << "\n";
+      return false;
+    }
+    log << "\n";
+    log << "Ejecución finalizada con éxito.\n";
+    return true;
+  } catch (const exception &e) {
+    log << "Error durante la ejecución: " << e.what() << "\n";
+    log << "Pasando a siguiente archivo\n";
+    return false;
+  }
+}
+
+// Modo por defecto (sin archivos en la línea de comandos): tests/*.txt ->
+// outputs/*.s
+static int compileTests(const Options &opt, const Caches &caches) {
   vector<string> paths;
 
   // --- Listar archivos .txt en tests/ usando dirent.h ---
   DIR *dp = opendir(prefix_input.c_str());
   if (!dp) {
     cerr << "No pude abrir el directorio tests/\n";
-    return 1;
+    return 2;
   }
   struct dirent *entry;
   while ((entry = readdir(dp)) != nullptr) {
@@ -47,58 +343,271 @@ int main() {
 
   sort(paths.begin(), paths.end());
 
-  for (auto path : paths) {
-    ifstream infile(prefix_input + path);
-    if (!infile.is_open()) {
-      cout << "No se pudo abrir el archivo: " << path << endl;
-      exit(1);
-    }
+  // Cada archivo es una tarea independiente (su Scanner, Parser y
+  // GenCodeVisitor); los logs se guardan y se imprimen en el orden de paths
+  auto start = chrono::steady_clock::now();
+  vector<string> logs(paths.size());
+  vector<char> ok(paths.size()), cached(paths.size());
+  workStealingFor(paths.size(), opt.jobs, [&](size_t i) {
+    stringstream log;
+    bool hit = false;
+    ok[i] = compileFile(paths[i], opt, caches, log, hit);
+    cached[i] = hit;
+    logs[i] = log.str();
+  });
+  double secs =
+      chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    string input;
-    string line;
-    while (getline(infile, line)) {
-      input += line + '\n';
+  for (auto &log : logs)
+    cout << log;
+  size_t failed = count(ok.begin(), ok.end(), 0);
+  cout << "---------------------------------------------------\n"
+       << paths.size() << " archivos en " << secs << " s ("
+       << (secs > 0 ? paths.size() / secs : 0) << " archivos/s, "
+       << min<size_t>(opt.jobs, max<size_t>(paths.size(), 1)) << " hilos), "
+       << failed << " con errores, "
+       << count(cached.begin(), cached.end(), 1) << " de caché" << endl;
+
+  return failed ? 1 : 0;
+}
+
+// Deja en 'text' el contenido de 'path' ("-" es stdin). Los archivos se
+// mapean en 'source'; stdin se copia entero a 'buffer' porque puede ser un
+// pipe
+static bool readInput(const string &path, SourceFile &source, string &buffer,
+                      string_view &text) {
+  if (path == "-") {
+    stringstream ss;
+    ss << cin.rdbuf();
+    buffer = ss.str();
+    text = buffer;
+    return !cin.bad();
+  }
+  if (!source.open(path))
+    return false;
+  text = source.text();
+  return true;
+}
+
+// Modo línea de comandos: compila exactamente opt.inputs. Cada entrada va a
+// -o si se dio (sólo con una entrada), a stdout si es stdin, y si no a
+// <entrada sin extensión>.s al lado del fuente. El .s se escribe sólo si la
+// compilación terminó bien, así un error no deja un archivo a medias.
+// Los errores van a stderr como "<entrada>: <mensaje>".
+static int compileInputs(const Options &opt, const Caches &caches) {
+  vector<int> status(opt.inputs.size());
+  vector<string> results(opt.inputs.size()), errors(opt.inputs.size());
+  workStealingFor(opt.inputs.size(), opt.jobs, [&](size_t i) {
+    const string &path = opt.inputs[i];
+    TimeReport times;
+    MemReport memory;
+    Reports reports;
+    if (opt.timeReport)
+      reports.time = &times;
+    if (opt.memReport) {
+      reports.mem = &memory;
+      memory.begin();
     }
-    infile.close();
-
-    Scanner scanner(input.c_str());
-
-    string input_copy = input;
-    Scanner scanner_test(input_copy.c_str());
-    // test_scanner(&scanner_test);
-    cout << "---------------------------------------------------" << endl;
-    cout << "path: " << path << endl;
-    // test_scanner(&scanner_test);
-    cout << "Scanner exitoso" << endl;
-    cout << endl;
-    cout << "Iniciando parsing:" << endl;
-    Parser parser(&scanner, true);
+    Span file(path, "archivo");
+    SourceFile source;
+    string buffer;
+    string_view text;
+    if (!readInput(path, source, buffer, text)) {
+      errors[i] = path + ": no se pudo leer el archivo\n";
+      status[i] = 2;
+      return;
+    }
+    stringstream out, log;
     try {
-      Program *program = parser.parseProgram();
-      cout << "Parsing exitoso" << endl << endl;
-      cout << "Iniciando Visitor:" << endl;
-      // PrintVisitor printVisitor;
-      // cout << "IMPRIMIR:" << endl;
-      // printVisitor.imprimir(program);
-      // cout << endl;
-      // EVALVisitor evalVisitor;
-      // cout << "EJECUTAR:" << endl;
-      // evalVisitor.ejecutar(program);
-      // cout << "Ejecución exitosa" << endl;
-      // cout << endl;
-      cout << "Generando código assembly:" << endl;
-      ofstream outfile(prefix_output + get_before_dot(path) + ".s");
-      GenCodeVisitor<ofstream> genVisitor(outfile);
-      genVisitor.generate(program);
-      cout << endl;
-      cout << "Ejecución finalizada con éxito." << endl;
-      outfile.close();
-      delete program;
+      compileSource(text, opt, opt.inputs.size() > 1, caches, out, log,
+                    reports);
+      results[i] = out.str();
     } catch (const exception &e) {
-      cout << "Error durante la ejecución: " << e.what() << endl;
-      cout << "Pasando a siguiente archivo" << endl;
+      errors[i] = (path == "-" ? "<stdin>" : path) + ": " + e.what() + "\n";
+      status[i] = 1;
+    }
+    // Los reportes van a stderr, como los errores
+    stringstream ss;
+    string name = path == "-" ? "<stdin>" : path;
+    if (reports.time)
+      times.print(ss, name);
+    if (reports.mem)
+      memory.print(ss, name);
+    errors[i] += ss.str();
+  });
+
+  int rc = 0;
+  for (size_t i = 0; i < opt.inputs.size(); i++) {
+    cerr << errors[i];
+    if (status[i]) {
+      rc = max(rc, status[i]);
+      continue;
+    }
+    const string &path = opt.inputs[i];
+    string target = !opt.output.empty() ? opt.output
+                    : path == "-"       ? "-"
+                                        : assemblyPath(path);
+    if (target == "-") {
+      cout << results[i];
+      cout.flush();
+      if (!cout) {
+        cerr << "no se pudo escribir en stdout\n";
+        rc = 2;
+      }
+      continue;
+    }
+    if (!writeIfChanged(target, results[i])) {
+      cerr << target << ": no se pudo escribir\n";
+      rc = 2;
     }
   }
+  return rc;
+}
+
+// --serve: atiende pedidos hasta SIGINT/SIGTERM, que borran el socket
+static CompileServer *serving = nullptr;
 
+static int runServer(const Options &opt) {
+  CompileServer server(opt.serve);
+  string error;
+  if (!server.listen(error)) {
+    cerr << error << endl;
+    return 2;
+  }
+  serving = &server;
+  struct sigaction sa {};
+  sa.sa_handler = [](int) { serving->stop(); };
+  sigaction(SIGINT, &sa, nullptr);
+  sigaction(SIGTERM, &sa, nullptr);
+  cerr << "Escuchando en " << opt.serve << endl;
+  server.serve();
+  cerr << server.requests() << " pedidos, " << server.cacheHits()
+       << " de caché" << endl;
+  serving = nullptr;
   return 0;
 }
+
+static void usage(const char *argv0) {
+  cerr << "Uso: " << argv0
+       << " [-O0|-O1|-O2] [-o salida.s] [--rebuild-cache] [--no-cache]"
+          " [--stream] [-j N] [-ftime-report] [--mem-report] [--trace F]"
+          " [archivo...|-]\n"
+          "       "
+       << argv0
+       << " --serve SOCKET\n"
+          "Sin archivos compila tests/*.txt a outputs/*.s.\n"
+          "Sale con 0 si todo compiló, 1 si algún fuente tiene errores y 2"
+          " por un error de uso o de entrada/salida."
+       << endl;
+}
+
+int main(int argc, char **argv) {
+  // --rebuild-cache: ignora lo guardado y vuelve a compilar todo
+  // --no-cache:      no lee ni escribe las cachés de AST y de assembly
+  // --stream:        compila función por función (ver streaming.h); no usa
+  //                  la caché
+  // -j N:            compila hasta N archivos a la vez (por defecto, tantos
+  //                  como hilos tenga la máquina)
+  // -o F:            con un solo archivo de entrada, escribe el .s en F
+  //                  ("-" es stdout)
+  // -O0, -O1, -O2:   nivel de optimización (ver Options::optLevel)
+  // --serve SOCKET:  servidor de compilación en un socket Unix (server.h)
+  // -ftime-report:   tiempo de pared y de CPU de cada fase, por archivo
+  // --mem-report:    memoria por fase, nodos del AST por tipo, tablas del
+  //                  generador y pico de RSS, por archivo (mem_report.h);
+  //                  compila de a un archivo
+  // --trace F:       escribe en F una traza trace_event de Chrome con un
+  //                  tramo por archivo, por fase y por función (timing.h)
+  Options opt;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg == "--rebuild-cache") {
+      opt.rebuildCache = true;
+    } else if (arg == "--no-cache") {
+      opt.useCache = false;
+    } else if (arg == "--stream") {
+      opt.stream = true;
+    } else if (arg == "--serve") {
+      if (i + 1 >= argc) {
+        cerr << "--serve espera la ruta del socket" << endl;
+        return 2;
+      }
+      opt.serve = argv[++i];
+    } else if (arg == "-ftime-report") {
+      opt.timeReport = true;
+    } else if (arg == "--mem-report") {
+      opt.memReport = true;
+    } else if (arg == "--trace") {
+      if (i + 1 >= argc) {
+        cerr << "--trace espera un archivo de salida" << endl;
+        return 2;
+      }
+      opt.trace = argv[++i];
+    } else if (arg == "-O0" || arg == "-O1" || arg == "-O2") {
+      opt.optLevel = arg[2] - '0';
+    } else if (arg.rfind("-o", 0) == 0) {
+      // -o F o -oF
+      string f = arg.substr(2);
+      if (f.empty() && i + 1 < argc)
+        f = argv[++i];
+      if (f.empty()) {
+        cerr << "-o espera un archivo de salida" << endl;
+        return 2;
+      }
+      opt.output = f;
+    } else if (arg.rfind("-j", 0) == 0) {
+      // -j N o -jN
+      string n = arg.substr(2);
+      if (n.empty() && i + 1 < argc)
+        n = argv[++i];
+      int jobs = atoi(n.c_str());
+      if (jobs < 1) {
+        cerr << "-j espera un número de hilos mayor que 0" << endl;
+        return 2;
+      }
+      opt.jobs = jobs;
+    } else if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      return 0;
+    } else if (arg == "-" || arg[0] != '-') {
+      opt.inputs.push_back(arg);
+    } else {
+      cerr << "Opción desconocida: " << arg << endl;
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (!opt.output.empty() && opt.inputs.size() != 1) {
+    cerr << "-o necesita exactamente un archivo de entrada" << endl;
+    return 2;
+  }
+  if (count(opt.inputs.begin(), opt.inputs.end(), "-") > 1) {
+    cerr << "stdin ('-') sólo puede aparecer una vez" << endl;
+    return 2;
+  }
+  // El pico de RSS es del proceso: sólo dice algo de un archivo si se
+  // compila solo
+  if (opt.memReport)
+    opt.jobs = 1;
+  if (!opt.serve.empty() && !opt.inputs.empty()) {
+    cerr << "--serve no lleva archivos de entrada" << endl;
+    return 2;
+  }
+  if (!opt.serve.empty())
+    return runServer(opt);
+  Caches caches;
+  Trace trace;
+  if (!opt.trace.empty())
+    Trace::setActive(&trace);
+
+  int rc = opt.inputs.empty() ? compileTests(opt, caches)
+                              : compileInputs(opt, caches);
+  if (!opt.trace.empty()) {
+    Trace::setActive(nullptr);
+    if (!trace.write(opt.trace)) {
+      cerr << opt.trace << ": no se pudo escribir la traza" << endl;
+      return 2;
+    }
+  }
+  return rc;
+}
@@ -0,0 +1,205 @@
+// mem_report.cpp
+#include "mem_report.h"
+#include "arena.h"
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// Fase activa de este hilo (ver MemScope). Punteros y enteros: se pueden
+// leer desde operator new sin inicialización dinámica
+thread_local MemReport *currentReport = nullptr;
+thread_local size_t currentPhase = 0;
+
+bool peakReset = false; // begin() pudo reiniciar el pico de RSS
+
+// VmHWM de /proc/self/status (pico de RSS desde el último reinicio), en KB
+long peakRssKB() {
+  ifstream status("/proc/self/status");
+  string line;
+  while (getline(status, line))
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return atol(line.c_str() + 6);
+  rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+string demangle(const type_info &type) {
+  int status = 0;
+  char *name = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+  string result = status == 0 && name ? name : type.name();
+  free(name);
+  return result;
+}
+
+// setw cuenta bytes: los nombres con acento se rellenan por caracteres
+string column(string_view name, size_t width) {
+  size_t chars = 0;
+  for (char c : name)
+    chars += ((unsigned char)c & 0xC0) != 0x80;
+  return string(name) + string(width > chars ? width - chars : 0, ' ');
+}
+
+string kb(size_t bytes) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.1f KB", bytes / 1024.0);
+  return buf;
+}
+
+} // namespace
+
+void memRecordAlloc(size_t size) {
+  if (MemReport *r = currentReport) {
+    r->phaseCounts[currentPhase].allocs++;
+    r->phaseCounts[currentPhase].bytes += size;
+  }
+}
+
+void memRecordNode(const type_info &type, size_t size) {
+  MemReport *r = currentReport;
+  if (!r)
+    return;
+  size_t i = 0;
+  while (i < r->nNodeKinds && *r->nodeKinds[i] != type)
+    i++;
+  if (i == r->nNodeKinds) {
+    if (i == MemReport::kMaxNodeKinds)
+      return;
+    r->nodeKinds[r->nNodeKinds++] = &type;
+  }
+  r->nodeCounts[i].allocs++;
+  r->nodeCounts[i].bytes += size;
+}
+
+// ── operator new global: malloc + contar en la fase del hilo ──
+
+void *operator new(size_t size) {
+  memRecordAlloc(size);
+  if (void *p = malloc(size ? size : 1))
+    return p;
+  throw bad_alloc();
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void *operator new(size_t size, const nothrow_t &) noexcept {
+  memRecordAlloc(size);
+  return malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const nothrow_t &tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, const nothrow_t &) noexcept { free(p); }
+void operator delete[](void *p, const nothrow_t &) noexcept { free(p); }
+
+// ── MemReport ──
+
+void MemReport::begin() {
+  int fd = open("/proc/self/clear_refs", O_WRONLY);
+  peakReset = fd >= 0 && write(fd, "5", 1) == 1;
+  if (fd >= 0)
+    close(fd);
+}
+
+void MemReport::note(string_view what, size_t entries, size_t bytes) {
+  if (nNotes == kMaxNotes)
+    return;
+  Note &n = notes[nNotes++];
+  size_t len = min(what.size(), sizeof(n.what) - 1);
+  memcpy(n.what, what.data(), len);
+  n.what[len] = '\0';
+  n.entries = entries;
+  n.bytes = bytes;
+}
+
+void MemReport::print(ostream &out, string_view file) const {
+  // Se copia todo antes de escribir: escribir en 'out' puede pedir memoria
+  // y sumar a la fase que siga activa
+  Count phase[kMaxPhases], node[kMaxNodeKinds];
+  copy(phaseCounts, phaseCounts + nPhases, phase);
+  copy(nodeCounts, nodeCounts + nNodeKinds, node);
+  long peak = peakRssKB();
+
+  out << "Memoria de " << file << ":\n";
+  Count heap;
+  out << "  pedidos a new por fase:\n";
+  for (size_t i = 0; i < nPhases; i++) {
+    out << "    " << column(phases[i], 22) << setw(9) << phase[i].allocs
+        << " pedidos " << setw(12) << kb(phase[i].bytes) << "\n";
+    heap.allocs += phase[i].allocs;
+    heap.bytes += phase[i].bytes;
+  }
+  out << "    " << column("total", 22) << setw(9) << heap.allocs
+      << " pedidos " << setw(12) << kb(heap.bytes) << "\n";
+
+  if (nNodeKinds) {
+    Count ast;
+    out << "  nodos del AST (en la arena):\n";
+    for (size_t i = 0; i < nNodeKinds; i++) {
+      out << "    " << column(demangle(*nodeKinds[i]), 22) << setw(9)
+          << node[i].allocs << " nodos   " << setw(12)
+          << kb(node[i].bytes) << "\n";
+      ast.allocs += node[i].allocs;
+      ast.bytes += node[i].bytes;
+    }
+    out << "    " << column("total", 22) << setw(9) << ast.allocs
+        << " nodos   " << setw(12) << kb(ast.bytes) << "\n";
+  }
+
+  if (nNotes) {
+    out << "  estructuras:\n";
+    for (size_t i = 0; i < nNotes; i++)
+      out << "    " << column(notes[i].what, 22) << setw(9)
+          << notes[i].entries << " entradas" << setw(12)
+          << kb(notes[i].bytes) << "\n";
+  }
+  out << "  pico de RSS: " << peak << " KB"
+      << (peakReset ? "" : " (del proceso entero)") << "\n";
+}
+
+// ── MemScope ──
+
+MemScope::MemScope(const char *phase, MemReport *report)
+    : prevReport(currentReport), prevPhase(currentPhase), active(report) {
+  if (!active)
+    return;
+  size_t i = 0;
+  while (i < report->nPhases && strcmp(report->phases[i], phase) != 0)
+    i++;
+  if (i == report->nPhases) {
+    if (i == MemReport::kMaxPhases)
+      i--; // las que sobran se suman a la última
+    else
+      report->phases[report->nPhases++] = phase;
+  }
+  currentReport = report;
+  currentPhase = i;
+  Arena::onMake = memRecordNode;
+}
+
+void MemScope::end() {
+  if (!active)
+    return;
+  active = false;
+  currentReport = prevReport;
+  currentPhase = prevPhase;
+  if (!prevReport)
+    Arena::onMake = nullptr;
+}
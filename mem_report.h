@@ -0,0 +1,71 @@
+// mem_report.h
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+#include <typeinfo>
+
+// Contabilidad de memoria de una compilación (--mem-report):
+//   - pedidos a operator new y bytes, por fase: el que compila marca la fase
+//     con un MemScope y mem_report.cpp reemplaza el operator new global
+//     para sumar en el MemReport del hilo que pide;
+//   - nodos del AST por tipo (BinaryExp, ListExp, ...), con el hook
+//     Arena::onMake;
+//   - entradas y bytes de estructuras puntuales que el driver anota con
+//     note() (tokens, arena, tablas y buffers de GenCodeVisitor);
+//   - el pico de RSS del proceso mientras se compiló el archivo.
+//
+// Cuenta sólo en el hilo donde está activo el MemScope: con --mem-report
+// el driver compila de a un archivo y genera las funciones en ese hilo.
+class MemReport {
+public:
+  // Reinicia el pico de RSS del proceso (Linux: /proc/self/clear_refs), así
+  // el que se lee en print() es el de este archivo
+  void begin();
+  void note(std::string_view what, size_t entries, size_t bytes);
+  void print(std::ostream &out, std::string_view file) const;
+
+  struct Count {
+    size_t allocs = 0, bytes = 0;
+  };
+
+private:
+  friend class MemScope;
+  friend void memRecordNode(const std::type_info &type, size_t size);
+  friend void memRecordAlloc(size_t size);
+
+  // Arreglos fijos: contar no puede pedir memoria
+  static const size_t kMaxPhases = 16, kMaxNodeKinds = 64, kMaxNotes = 32;
+  const char *phases[kMaxPhases];
+  Count phaseCounts[kMaxPhases];
+  size_t nPhases = 0;
+  const std::type_info *nodeKinds[kMaxNodeKinds];
+  Count nodeCounts[kMaxNodeKinds];
+  size_t nNodeKinds = 0;
+  struct Note {
+    char what[48];
+    size_t entries, bytes;
+  } notes[kMaxNotes];
+  size_t nNotes = 0;
+};
+
+// Mientras vive, lo que pida este hilo con new y los nodos que cree en una
+// Arena se suman a 'phase' en 'report'. Con report nullptr no hace nada.
+// Se pueden anidar: al salir vuelve la fase anterior
+class MemScope {
+public:
+  MemScope(const char *phase, MemReport *report);
+  ~MemScope() { end(); }
+  void end(); // sale antes del destructor
+  MemScope(const MemScope &) = delete;
+  MemScope &operator=(const MemScope &) = delete;
+
+private:
+  MemReport *prevReport;
+  size_t prevPhase;
+  bool active;
+};
+
+#endif // MEM_REPORT_H
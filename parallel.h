@@ -0,0 +1,94 @@
+// parallel.h
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Hilos a usar por defecto: los del hardware (1 si no se sabe)
+inline unsigned defaultJobs() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Corre f(i) para i en [0, n) con hasta 'jobs' hilos. Cada hilo toma el
+// siguiente índice libre de un contador compartido, así que un f lento no
+// deja a los demás esperando. Con jobs <= 1 (o n <= 1) corre todo en el
+// hilo que llama, en orden. f no debe lanzar excepciones.
+template <typename F> void parallelFor(size_t n, unsigned jobs, F &&f) {
+  unsigned threads = unsigned(std::min<size_t>(jobs, n));
+  if (threads <= 1) {
+    for (size_t i = 0; i < n; i++)
+      f(i);
+    return;
+  }
+  std::atomic<size_t> next{0};
+  auto work = [&]() {
+    for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;)
+      f(i);
+  };
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; t++)
+    pool.emplace_back(work);
+  work(); // el hilo que llama también trabaja
+  for (auto &t : pool)
+    t.join();
+}
+
+// Como parallelFor, pero con robo de trabajo: cada hilo arranca con un
+// tramo contiguo de índices en su propia cola y los toma del final; cuando
+// la vacía, le roba el primero pendiente a otro. Conviene cuando el costo de
+// cada f(i) varía mucho (archivos de tamaños muy distintos) y los índices
+// vecinos se parecen: cada hilo sigue con lo suyo y sólo compite por una
+// cola ajena al final. f no debe lanzar excepciones.
+template <typename F> void workStealingFor(size_t n, unsigned jobs, F &&f) {
+  unsigned threads = unsigned(std::min<size_t>(jobs, n));
+  if (threads <= 1) {
+    for (size_t i = 0; i < n; i++)
+      f(i);
+    return;
+  }
+  struct Queue {
+    std::mutex mtx;
+    std::deque<size_t> items;
+  };
+  std::vector<Queue> queues(threads);
+  for (unsigned t = 0; t < threads; t++)
+    for (size_t i = t * n / threads; i < (t + 1) * n / threads; i++)
+      queues[t].items.push_back(i);
+
+  // No se agregan tareas: si todas las colas están vacías, no queda nada
+  auto take = [&](unsigned self, size_t &i) {
+    for (unsigned k = 0; k < threads; k++) {
+      Queue &q = queues[(self + k) % threads];
+      std::lock_guard<std::mutex> lock(q.mtx);
+      if (q.items.empty())
+        continue;
+      if (k == 0) {
+        i = q.items.back();
+        q.items.pop_back();
+      } else {
+        i = q.items.front();
+        q.items.pop_front();
+      }
+      return true;
+    }
+    return false;
+  };
+  auto work = [&](unsigned self) {
+    for (size_t i; take(self, i);)
+      f(i);
+  };
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; t++)
+    pool.emplace_back(work, t);
+  work(0);
+  for (auto &t : pool)
+    t.join();
+}
+
+#endif // PARALLEL_H
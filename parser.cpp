@@ -2,17 +2,20 @@
 #include "parser.h"
 #include "exp.h"
 #include "token.h"
-#include <functional>
+#include <array>
 #include <iostream>
 #include <stdexcept>
 
 using namespace std;
 
 Parser::Parser(Scanner *sc, bool e)
-    : scanner(sc), current(scanner->nextToken()), previous(nullptr),
-      exitError(e) {
-  if (current->type == Token::ERR)
-    throw runtime_error("Error léxico inicial: " + current->text);
+    : Parser(sc, e, unique_ptr<Arena>(new Arena())) {}
+
+Parser::Parser(Scanner *sc, bool e, unique_ptr<Arena> a)
+    : scanner(sc), current(scanner->nextToken()), previous(), exitError(e),
+      arena(move(a)) {
+  if (current.type == Token::ERR)
+    throw runtime_error("Error léxico inicial: " + string(current.text));
 }
 
 Program *Parser::parse() { return parseProgram(); }
@@ -27,38 +30,59 @@ bool Parser::match(Token::Type type) {
   return false;
 }
 
-bool Parser::match(Token::Type type, const string &lexeme) {
-  if (!isAtEnd() && current->type == type && current->text == lexeme) {
-    advance();
-    return true;
-  }
-  return false;
+bool Parser::checkTypeName() const {
+  // IntArray, DoubleArray y Array son tokens propios pero también tipos
+  return check(Token::ID) || check(Token::INTARRAY) ||
+         check(Token::DOUBLEARRAY) || check(Token::ARRAY);
 }
 
 bool Parser::check(Token::Type type) const {
-  return !isAtEnd() && current->type == type;
+  return !isAtEnd() && current.type == type;
 }
 
-Token *Parser::advance() {
+Token Parser::advance() {
   previous = current;
   current = scanner->nextToken();
-  if (current->type == Token::ERR)
-    error("Carácter no reconocido: " + current->text);
+  if (current.type == Token::ERR)
+    error("Carácter no reconocido: " + string(current.text));
   return previous;
 }
 
-Token *Parser::consume(Token::Type type, const string &message) {
+Token Parser::consume(Token::Type type, string_view message) {
   if (check(type))
     return advance();
-  error(message);
-  return nullptr;
+  error(string(message));
+  return Token(Token::ERR);
 }
 
-bool Parser::isAtEnd() const { return current->type == Token::END; }
+Token Parser::consumeTypeName(string_view message) {
+  if (checkTypeName())
+    return advance();
+  error(string(message));
+  return Token(Token::ERR);
+}
 
+// Tipo completo, con genéricos anidados: List<Array<Int>>. Devuelve el Type
+// internado, así que el resto del compilador compara tipos por puntero.
+const Type *Parser::parseType(string_view message) {
+  Token name = consumeTypeName(message);
+  if (!match(Token::LT))
+    return Type::named(name.text);
+  vector<const Type *> args;
+  do {
+    args.push_back(parseType("Se esperaba tipo genérico"));
+  } while (match(Token::COMA));
+  consume(Token::GT, "Se esperaba '>' al final de tipo genérico");
+  return Type::generic(Symbol::intern(name.text), args);
+}
+
+bool Parser::isAtEnd() const { return current.type == Token::END; }
+
+// Sin exitError el mensaje va sólo en la excepción: quien la atrapa decide
+// dónde mostrarlo (el driver compila varios archivos a la vez)
 void Parser::error(const string &msg) {
-  cerr << "[Line ??] Error de sintaxis: " << msg << endl;
   if (exitError) {
+    cerr << "[Line ??] Error de sintaxis: " << msg << endl;
     exit(1);
   } else {
     throw std::runtime_error("Error en el parseo: " + msg);
@@ -76,15 +100,16 @@ Program *Parser::parseProgram() {
   // 3) TODAS las funciones globales (incluido main)
   FunDecList *funcs = parseFunDecList();
 
-  // 4) construir el AST
+  // 4) construir el AST (el Program se queda con la arena)
   Program *prog = new Program(nullptr);
   prog->vardecs = globals;
   prog->classDecs = classes;
   prog->funDecs = funcs;
+  prog->arena = arena.release();
 
   // 5) asignar el body de main
   for (auto f : funcs->functions) {
-    if (f->name == "main") {
+    if (f->name == sym::main) {
       prog->body = f->body;
       break;
     }
@@ -93,33 +118,67 @@ Program *Parser::parseProgram() {
   return prog;
 }
 
+// --- Compilación por partes ---
+Program *Parser::parseHeader() {
+  Program *prog = new Program(nullptr);
+  prog->vardecs = parseVarDecList();
+  prog->classDecs = parseClassDecList();
+  prog->funDecs = node<FunDecList>();
+  prog->arena = takeArena().release();
+  return prog;
+}
+
+FunDec *Parser::parseSignature() {
+  Symbol name;
+  vector<Param> params;
+  const Type *retType = nullptr;
+  if (!parseFunSignature(name, params, retType))
+    return nullptr;
+  skipFunBody();
+  return node<FunDec>(name, retType, params, nullptr);
+}
+
+FunDec *Parser::parseFunction() { return parseFunDec(); }
+
+unique_ptr<Arena> Parser::takeArena() {
+  unique_ptr<Arena> parsed = move(arena);
+  arena.reset(new Arena());
+  return parsed;
+}
+
+Parser::Mark Parser::mark() const { return {*scanner, current, previous}; }
+
+void Parser::reset(const Mark &m) {
+  *scanner = m.scanner;
+  current = m.current;
+  previous = m.previous;
+}
+
+// Mismo análisis, pero el resultado queda en arreglos contiguos. El árbol de
+// punteros sólo vive mientras se aplana.
+FlatAst Parser::parseFlat() {
+  std::unique_ptr<Program> prog(parseProgram());
+  return FlatAst::build(prog.get());
+}
+
 // --- Declaraciones de variables ---
 VarDecList *Parser::parseVarDecList() {
-  auto list = new VarDecList();
+  auto list = node<VarDecList>();
   // mientras venga 'var' o 'val'
   while (match(Token::VAR) || match(Token::VAL)) {
-    bool isMutable = (previous->type == Token::VAR);
+    bool isMutable = (previous.type == Token::VAR);
 
     // 1) uno o varios nombres separados por ','
-    vector<string> names;
-    names.push_back(consume(Token::ID, "Se esperaba identificador")->text);
+    vector<Symbol> names;
+    names.push_back(consume(Token::ID, "Se esperaba identificador").sym);
     while (match(Token::COMA)) {
-      names.push_back(consume(Token::ID, "Se esperaba identificador")->text);
+      names.push_back(consume(Token::ID, "Se esperaba identificador").sym);
     }
 
     // 2) tipo opcional: ':' Type [ '<' Gen (',' Gen)* '>' ]
-    string typeName;
-    if (match(Token::COLON)) {
-      typeName = consume(Token::ID, "Se esperaba nombre de tipo")->text;
-      if (match(Token::LT)) {
-        typeName += "<" + consume(Token::ID, "Se esperaba tipo genérico")->text;
-        while (match(Token::COMA))
-          typeName +=
-              "," + consume(Token::ID, "Se esperaba tipo genérico")->text;
-        consume(Token::GT, "Se esperaba '>' al final de tipo genérico");
-        typeName += ">";
-      }
-    }
+    const Type *type = nullptr;
+    if (match(Token::COLON))
+      type = parseType("Se esperaba nombre de tipo");
 
     // 3) inicializador opcional (solo al primero)
     vector<Exp *> inits(names.size(), nullptr);
@@ -128,7 +187,7 @@ VarDecList *Parser::parseVarDecList() {
     }
 
     // 4) anotar la declaración
-    list->add(new VarDec(isMutable, names, typeName, inits));
+    list->add(node<VarDec>(isMutable, names, type, inits));
   }
   return list;
 }
@@ -136,35 +195,25 @@ VarDecList *Parser::parseVarDecList() {
 VarDec *Parser::parseVarDec() {
   // 0) Mutabilidad
   bool isMutable = false;
-  if (previous->type == Token::VAR) {
+  if (previous.type == Token::VAR) {
     isMutable = true;
-  } else if (previous->type == Token::VAL) {
+  } else if (previous.type == Token::VAL) {
     isMutable = false;
   } else {
     error("Se esperaba 'var' o 'val'");
   }
 
   // 1) Leer uno o varios nombres, separados por coma
-  vector<string> names;
-  names.push_back(consume(Token::ID, "Se esperaba identificador")->text);
+  vector<Symbol> names;
+  names.push_back(consume(Token::ID, "Se esperaba identificador").sym);
   while (match(Token::COMA)) {
-    names.push_back(consume(Token::ID, "Se esperaba identificador")->text);
+    names.push_back(consume(Token::ID, "Se esperaba identificador").sym);
   }
 
   // 2) Tipo opcional: si viene ':', lo consumimos; si no, inferimos
-  string typeName = "";
-  if (match(Token::COLON)) {
-    typeName = consume(Token::ID, "Se esperaba nombre de tipo")->text;
-    // Genéricos List<T>?
-    if (match(Token::LT)) {
-      typeName += "<" + consume(Token::ID, "Se esperaba tipo genérico")->text;
-      while (match(Token::COMA)) {
-        typeName += "," + consume(Token::ID, "Se esperaba tipo genérico")->text;
-      }
-      consume(Token::GT, "Se esperaba '>' al final de tipo genérico");
-      typeName += ">";
-    }
-  }
+  const Type *type = nullptr;
+  if (match(Token::COLON))
+    type = parseType("Se esperaba nombre de tipo");
 
   // 3) Inicializador opcional
   vector<Exp *> inits;
@@ -177,13 +226,13 @@ VarDec *Parser::parseVarDec() {
     }
   }
 
-  return new VarDec(isMutable, names, typeName, inits);
+  return node<VarDec>(isMutable, names, type, inits);
 }
 
 // --- Declaraciones de clase ---
 
 ClassDecList *Parser::parseClassDecList() {
-  auto list = new ClassDecList();
+  auto list = node<ClassDecList>();
   // Mientras veamos la palabra “class”
   while (match(Token::CLASS)) {
     list->add(parseClassDec());
@@ -192,7 +241,7 @@ ClassDecList *Parser::parseClassDecList() {
 }
 
 FunDecList *Parser::parseFunDecList() {
-  auto list = new FunDecList();
+  auto list = node<FunDecList>();
   FunDec *f;
   while ((f = parseFunDec()) != nullptr) {
     list->add(f);
@@ -201,8 +250,8 @@ FunDecList *Parser::parseFunDecList() {
 }
 
 ClassDec *Parser::parseClassDec() {
-  auto name = consume(Token::ID, "Se esperaba nombre de clase")->text;
-  std::vector<Argument> *args = new std::vector<Argument>();
+  Symbol name = consume(Token::ID, "Se esperaba nombre de clase").sym;
+  std::vector<Argument> args;
   if (match(Token::PI)) {
     args = parseArguments();
     consume(Token::PD, "Se esperaba ')' tras argumentos de clase");
@@ -211,7 +260,7 @@ ClassDec *Parser::parseClassDec() {
   consume(Token::LBRACE, "Se esperaba '{' inicio de cuerpo de clase");
 
   // 3.a) Leemos N declaraciones var/val, separadas opcionalmente por ';'
-  VarDecList *members = new VarDecList();
+  VarDecList *members = node<VarDecList>();
   while (check(Token::VAR) || check(Token::VAL)) {
     // parseVarDecList consume todas las declaraciones que encuentre
     VarDecList *partial = parseVarDecList();
@@ -226,29 +275,24 @@ ClassDec *Parser::parseClassDec() {
   // 3.b) Ahora sí el cierre de la clase
   consume(Token::RBRACE, "Se esperaba '}' fin de cuerpo de clase");
 
-  return new ClassDec(name, *args, members);
+  return node<ClassDec>(name, args, members);
 }
 
 // --- Declaraciones de función ---
 FunDec *Parser::parseFunDec() {
-  if (!match(Token::FUN))
+  Symbol name;
+  vector<Param> params;
+  const Type *retType = nullptr;
+  if (!parseFunSignature(name, params, retType))
     return nullptr;
-  auto name = consume(Token::ID, "Se esperaba identificador de función")->text;
-  consume(Token::PI, "Se esperaba '(' tras nombre de función");
-  auto params = parseParamDecList();
-  consume(Token::PD, "Se esperaba ')' tras lista de parámetros");
-  std::string retType;
-  if (match(Token::COLON)) {
-    retType = consume(Token::ID, "Se esperaba tipo de retorno")->text;
-  }
 
   Body *body = nullptr;
   if (match(Token::ASSIGN)) {
     Exp *e = parseCExp();
-    auto *vdl = new VarDecList();
-    auto *sl = new StatementList();
-    sl->add(new ReturnStatement(e));
-    body = new Body(vdl, sl);
+    auto *vdl = node<VarDecList>();
+    auto *sl = node<StatementList>();
+    sl->add(node<ReturnStatement>(e));
+    body = node<Body>(vdl, sl);
   } else if (match(Token::LBRACE)) {
     body = parseBody();
     consume(Token::RBRACE, "Se esperaba '}' fin de cuerpo de función");
@@ -256,17 +300,50 @@ FunDec *Parser::parseFunDec() {
     error("Se esperaba '=' o '{' inicio de cuerpo de función");
   }
 
-  return new FunDec(name, retType, *params, body);
+  return node<FunDec>(name, retType, params, body);
 }
 
-vector<Param> *Parser::parseParamDecList() {
-  auto params = new vector<Param>();
+bool Parser::parseFunSignature(Symbol &name, vector<Param> &params,
+                               const Type *&retType) {
+  if (!match(Token::FUN))
+    return false;
+  name = consume(Token::ID, "Se esperaba identificador de función").sym;
+  consume(Token::PI, "Se esperaba '(' tras nombre de función");
+  params = parseParamDecList();
+  consume(Token::PD, "Se esperaba ')' tras lista de parámetros");
+  if (match(Token::COLON))
+    retType = parseType("Se esperaba tipo de retorno");
+  return true;
+}
+
+// Un cuerpo { ... } termina en su '}'; uno '= CExp', en la siguiente 'fun'
+// (una expresión no puede contenerla)
+void Parser::skipFunBody() {
+  if (match(Token::ASSIGN)) {
+    while (!isAtEnd() && !check(Token::FUN))
+      advance();
+    return;
+  }
+  consume(Token::LBRACE, "Se esperaba '=' o '{' inicio de cuerpo de función");
+  for (int depth = 1; depth > 0;) {
+    if (isAtEnd())
+      error("Se esperaba '}' fin de cuerpo de función");
+    else if (match(Token::LBRACE))
+      depth++;
+    else if (match(Token::RBRACE))
+      depth--;
+    else
+      advance();
+  }
+}
+
+vector<Param> Parser::parseParamDecList() {
+  vector<Param> params;
   if (check(Token::ID)) {
     do {
-      auto pname = advance()->text;
+      Symbol pname = advance().sym;
       consume(Token::COLON, "Se esperaba ':' tras parámetro");
-      auto ptype = consume(Token::ID, "Se esperaba tipo de parámetro")->text;
-      params->push_back({pname, ptype});
+      params.push_back({pname, parseType("Se esperaba tipo de parámetro")});
     } while (match(Token::COMA));
   }
   return params;
@@ -275,27 +352,16 @@ vector<Param> *Parser::parseParamDecList() {
 // —————————————
 // parseArguments: lista de x:Type [, y:Type]*
 // —————————————
-std::vector<Argument> *Parser::parseArguments() {
-  auto args = new std::vector<Argument>();
+std::vector<Argument> Parser::parseArguments() {
+  std::vector<Argument> args;
 
   while (match(Token::VAL) || match(Token::VAR)) {
     // nombre
-    auto aname = consume(Token::ID, "Se esperaba nombre de argumento")->text;
+    Symbol aname = consume(Token::ID, "Se esperaba nombre de argumento").sym;
     // dos puntos y tipo
     consume(Token::COLON, "Se esperaba ':' tras nombre de argumento");
-    auto atype = consume(Token::ID, "Se esperaba tipo de argumento")->text;
-
-    // soportar genéricos List<...>, Point<...>, etc.
-    if (match(Token::LT)) {
-      atype += "<" + consume(Token::ID, "Se esperaba tipo genérico")->text;
-      while (match(Token::COMA)) {
-        atype += "," + consume(Token::ID, "Se esperaba tipo genérico")->text;
-      }
-      consume(Token::GT, "Se esperaba '>' al final de tipo genérico");
-      atype += ">";
-    }
-
-    args->push_back({aname, atype});
+    // soporta genéricos List<...>, Point<...>, etc.
+    args.push_back({aname, parseType("Se esperaba tipo de argumento")});
   }
 
   return args;
@@ -303,387 +369,375 @@ std::vector<Argument> *Parser::parseArguments() {
 
 // --- Cuerpo y sentencias ---
 
+// if/while/for anidados se parsean sin recursión: cada bloque abierto es un
+// Block en 'blocks_' y parseBody es un solo bucle que, según el token, abre
+// un bloque (if/while/for), cierra el de arriba ('}' o, en una rama sin
+// llaves, tras su única sentencia) o agrega una sentencia simple. Así la
+// profundidad del anidamiento la limita la memoria y no la pila.
 Body *Parser::parseBody() {
-  auto vdl = parseVarDecList();
-  auto sl = parseStmtList();
-  return new Body(vdl, sl);
-}
-
-// --- Cuerpo y sentencias ---
+  size_t base = blocks_.size();
+  openBlock(Block::Root, true);
+  for (;;) {
+    Block &top = blocks_.back();
+    bool done = top.braces ? check(Token::RBRACE) || isAtEnd()
+                           : !top.stmts->statements.empty();
+    if (!done) {
+      if (!openStmtBlock())
+        top.stmts->add(parseStmt());
+      continue;
+    }
 
-StatementList *Parser::parseStmtList() {
-  auto sl = new StatementList();
-  while (!check(Token::RBRACE) && !isAtEnd()) {
-    sl->add(parseStmt());
+    Block b = blocks_.back();
+    blocks_.pop_back();
+    if (blocks_.size() == base) // Root: la '}' es de quien llamó
+      return node<Body>(b.vars, b.stmts);
+    static const char *const closeMsg[] = {
+        "", "Se esperaba '}' fin then", "Se esperaba '}' fin else",
+        "Se esperaba '}' fin while", "Se esperaba '}' fin for"};
+    if (b.braces)
+      consume(Token::RBRACE, closeMsg[b.kind]);
+    Body *body = node<Body>(b.vars, b.stmts);
+    Stm *s = nullptr;
+    switch (b.kind) {
+    case Block::Then:
+      if (match(Token::ELSE)) {
+        openBlock(Block::Else, match(Token::LBRACE));
+        blocks_.back().cond = b.cond;
+        blocks_.back().thenB = body;
+        continue;
+      }
+      s = node<IfStatement>(b.cond, body, nullptr);
+      break;
+    case Block::Else:
+      s = node<IfStatement>(b.cond, b.thenB, body);
+      break;
+    case Block::While:
+      s = node<WhileStatement>(b.cond, body);
+      break;
+    default: // For
+      s = node<ForStatement>(b.var, b.iterable, body);
+      break;
+    }
+    blocks_.back().stmts->add(s);
   }
-  return sl;
 }
 
-Stm *Parser::parseStmt() {
-  // -- 1) print / println (son Token::PRINT pero el texto es "print" o
-  // "println")
-  if (match(Token::PRINT)) {
-    bool isLn = (previous->text == "println");
-    consume(Token::PI, "Se esperaba '(' tras print");
-    Exp *e = parseCExp();
-    consume(Token::PD, "Se esperaba ')' en print");
-    return new PrintStatement(e);
-  }
-  // -- 2) asignaciones (índice, campo o simple)
-  if (check(Token::ID)) {
-    Token *saveCurrent = current;
-    Token *savePrevious = previous;
-    string name = advance()->text;
-
-    // 2.a) foo[expr] = rhs
-    if (match(Token::LBRACK)) {
-      Exp *idx = parseCExp();
-      consume(Token::RBRACK, "Se esperaba ']' en índice");
-      consume(Token::ASSIGN, "Se esperaba '=' en asignación de índice");
-      Exp *rhs = parseCExp();
-      return new AssignStatement(new IndexExp(name, idx), rhs);
-    }
-    // 2.b) foo.bar = rhs
-    else if (match(Token::DOT)) {
-      string member = consume(Token::ID, "Se esperaba miembro tras '.'")->text;
-      consume(Token::ASSIGN, "Se esperaba '=' en asignación de campo");
-      Exp *rhs = parseCExp();
-      return new AssignStatement(new DotExp(name, member), rhs);
-    }
-    // 2.c) foo = rhs
-    else if (match(Token::ASSIGN)) {
-      Exp *rhs = parseCExp();
-      return new AssignStatement(new IdentifierExp(name), rhs);
-    } else {
-      error("Después del identificador se esperaba '=' para asignación");
-    }
+// Un bloque con llaves empieza con sus declaraciones; una rama sin llaves
+// es una sola sentencia
+void Parser::openBlock(Block::Kind kind, bool braces) {
+  Block b;
+  b.kind = kind;
+  b.braces = braces;
+  b.vars = braces ? parseVarDecList() : node<VarDecList>();
+  b.stmts = node<StatementList>();
+  blocks_.push_back(b);
+}
 
-    current = saveCurrent;
-    previous = savePrevious;
-  }
-  // -- 3) return
-  if (match(Token::RETURN)) {
-    Exp *e = parseCExp();
-    return new ReturnStatement(e);
-  }
-  // -- 4) if / while / for ...
+// Cabeceras de las sentencias con cuerpo; false si current no empieza una:
+//   if ( CExp ) Rama [ else Rama ]       Rama = { Body } | Stmt
+//   while ( CExp ) { Body }
+//   for ( id in (LoopExp | id) ) { Body }
+bool Parser::openStmtBlock() {
   if (match(Token::IF)) {
     consume(Token::PI, "Se esperaba '(' en if");
     Exp *cond = parseCExp();
     consume(Token::PD, "Se esperaba ')' en if");
-    Body *thenB = nullptr;
-    if (match(Token::LBRACE)) {
-      thenB = parseBody();
-      consume(Token::RBRACE, "Se esperaba '}' fin then");
-    } else {
-      Stm *s = parseStmt();
-      auto *vdl = new VarDecList();
-      auto *sl = new StatementList();
-      sl->add(s);
-      thenB = new Body(vdl, sl);
-    }
-    Body *elseB = nullptr;
-    if (match(Token::ELSE)) {
-      if (match(Token::LBRACE)) {
-        elseB = parseBody();
-        consume(Token::RBRACE, "Se esperaba '}' fin else");
-      } else {
-        Stm *s = parseStmt();
-        auto *vdl = new VarDecList();
-        auto *sl = new StatementList();
-        sl->add(s);
-        elseB = new Body(vdl, sl);
-      }
-    }
-    return new IfStatement(cond, thenB, elseB);
+    openBlock(Block::Then, match(Token::LBRACE));
+    blocks_.back().cond = cond;
+    return true;
   }
   if (match(Token::WHILE)) {
     consume(Token::PI, "Se esperaba '(' en while");
-    auto cond = parseCExp();
+    Exp *cond = parseCExp();
     consume(Token::PD, "Se esperaba ')' tras condición");
     consume(Token::LBRACE, "Se esperaba '{' tras while");
-    auto body = parseBody();
-    consume(Token::RBRACE, "Se esperaba '}' fin while");
-    return new WhileStatement(cond, body);
+    openBlock(Block::While, true);
+    blocks_.back().cond = cond;
+    return true;
   }
   if (match(Token::FOR)) {
+    // for (x in lista) { ... } o for (x in a..b [step s]) { ... }
     consume(Token::PI, "Se esperaba '(' en for");
-    string var = consume(Token::ID, "Se esperaba identificador en for")->text;
-    consume(Token::ID, "Se esperaba 'in' en for");
-    Stm *forSt = nullptr;
+    Symbol var = consume(Token::ID, "Se esperaba identificador en for").sym;
+    consume(Token::IN, "Se esperaba 'in' en for");
+    Exp *iterable;
     if (match(Token::ID)) {
-      auto listName = previous->text;
+      iterable = node<IdentifierExp>(previous.sym);
       consume(Token::PD, "Se esperaba ')' tras for");
-      consume(Token::LBRACE, "Se esperaba '{' tras for");
-      auto body = parseBody();
-      consume(Token::RBRACE, "Se esperaba '}' fin for");
-      forSt = new ForStatement(var, new IdentifierExp(listName), body);
-
     } else {
-      auto loop = parseLoopExp();
+      iterable = parseLoopExp();
       consume(Token::PD, "Se esperaba ')' de for");
-      consume(Token::LBRACE, "Se esperaba '{' tras for");
-      auto body = parseBody();
-      consume(Token::RBRACE, "Se esperaba '}' fin for");
-      forSt = new ForStatement(var, loop, body);
     }
-    return forSt;
+    consume(Token::LBRACE, "Se esperaba '{' tras for");
+    openBlock(Block::For, true);
+    blocks_.back().var = var;
+    blocks_.back().iterable = iterable;
+    return true;
   }
+  return false;
+}
+
+// Tabla de reglas de sentencia por tipo de token: parseStmt mira el primer
+// token, consume y salta directo a su regla (en 'previous' queda el token
+// que la eligió). nullptr = ninguna sentencia simple empieza así; las que
+// tienen cuerpo (if/while/for) las abre parseBody.
+const array<Parser::StmRule, Token::COUNT> Parser::stmRules = [] {
+  array<StmRule, Token::COUNT> t{};
+  t[Token::PRINT] = &Parser::parsePrintStmt;
+  t[Token::PRINTLN] = &Parser::parsePrintStmt;
+  t[Token::ID] = &Parser::parseAssignStmt;
+  t[Token::RETURN] = &Parser::parseReturnStmt;
+  return t;
+}();
 
-  error("Sentencia no reconocida");
-  return nullptr;
+Stm *Parser::parseStmt() {
+  StmRule rule = stmRules[current.type];
+  if (!rule) {
+    error("Sentencia no reconocida");
+    return nullptr;
+  }
+  advance();
+  return (this->*rule)();
+}
+
+// print(e) / println(e)
+Stm *Parser::parsePrintStmt() {
+  consume(Token::PI, "Se esperaba '(' tras print");
+  Exp *e = parseCExp();
+  consume(Token::PD, "Se esperaba ')' en print");
+  return node<PrintStatement>(e);
+}
+
+// Asignaciones: índice, campo o simple
+Stm *Parser::parseAssignStmt() {
+  Symbol name = previous.sym;
+
+  // foo[expr] = rhs
+  if (match(Token::LBRACK)) {
+    Exp *idx = parseCExp();
+    consume(Token::RBRACK, "Se esperaba ']' en índice");
+    consume(Token::ASSIGN, "Se esperaba '=' en asignación de índice");
+    Exp *rhs = parseCExp();
+    return node<AssignStatement>(node<IndexExp>(name, idx), rhs);
+  }
+  // foo.bar = rhs
+  if (match(Token::DOT)) {
+    Symbol member = consume(Token::ID, "Se esperaba miembro tras '.'").sym;
+    consume(Token::ASSIGN, "Se esperaba '=' en asignación de campo");
+    Exp *rhs = parseCExp();
+    return node<AssignStatement>(node<DotExp>(name, member), rhs);
+  }
+  // foo = rhs
+  consume(Token::ASSIGN,
+          "Después del identificador se esperaba '=' para asignación");
+  Exp *rhs = parseCExp();
+  return node<AssignStatement>(node<IdentifierExp>(name), rhs);
+}
+
+Stm *Parser::parseReturnStmt() {
+  Exp *e = parseCExp();
+  return node<ReturnStatement>(e);
+}
+
+// --- Expresiones: precedencia por tabla ---
+// Todos los operadores binarios salen de una tabla indexada por tipo de
+// token: precedencia (0 = no es operador binario) y el BinaryOp que genera.
+// Un solo bucle los parsea a todos (shunting-yard): los operandos y los
+// operadores pendientes van en pilas explícitas (vals_, ops_) en vez de en
+// la pila de llamadas, así que a + b + ... con un millón de términos cuesta
+// memoria y no profundidad de recursión. Agregar un operador es agregar una
+// fila. Todos asocian a la izquierda.
+namespace {
+struct BinOpInfo {
+  uint8_t prec;
+  BinaryOp op;
+};
+
+constexpr array<BinOpInfo, Token::COUNT> makeBinOps() {
+  array<BinOpInfo, Token::COUNT> t{};
+  t[Token::EQ] = {1, EQ_OP};
+  t[Token::LT] = {2, LT_OP};
+  t[Token::LE] = {2, LE_OP};
+  t[Token::GT] = {2, GT_OP};
+  t[Token::GE] = {2, GE_OP};
+  t[Token::PLUS] = {3, PLUS_OP};
+  t[Token::MINUS] = {3, MINUS_OP};
+  t[Token::MUL] = {4, MUL_OP};
+  t[Token::DIV] = {4, DIV_OP};
+  return t;
 }
 
-// --- Expresiones ---
+constexpr auto kBinOps = makeBinOps();
+} // namespace
 
+// Antes de apilar un operador se reducen los pendientes de precedencia
+// mayor o igual (asociatividad izquierda); un token que no es operador
+// (prec 0) reduce todo lo que queda. Las pilas se comparten con las
+// expresiones anidadas (paréntesis, argumentos): cada llamada trabaja sobre
+// lo que apiló ella.
 Exp *Parser::parseCExp() {
-  Exp *left = parseExpression();
-  if (match(Token::GE) || match(Token::GT) || match(Token::LT) ||
-      match(Token::LE) || match(Token::EQ)) {
-    auto op = previous->type == Token::GT   ? GT_OP
-              : previous->type == Token::GE ? GE_OP
-              : previous->type == Token::LT ? LT_OP
-              : previous->type == Token::LE ? LE_OP
-                                            : EQ_OP;
-    auto right = parseExpression();
-    left = new BinaryExp(left, right, op);
+  size_t opBase = ops_.size();
+  vals_.push_back(parseFactor());
+  for (;;) {
+    BinOpInfo info = kBinOps[current.type];
+    while (ops_.size() > opBase && kBinOps[ops_.back()].prec >= info.prec) {
+      Exp *right = vals_.back();
+      vals_.pop_back();
+      BinaryOp op = kBinOps[ops_.back()].op;
+      ops_.pop_back();
+      vals_.back() = node<BinaryExp>(vals_.back(), right, op);
+    }
+    if (info.prec == 0)
+      break;
+    ops_.push_back(current.type);
+    advance();
+    vals_.push_back(parseFactor());
   }
-  return left;
+  Exp *e = vals_.back();
+  vals_.pop_back();
+  return e;
 }
 
-Exp *Parser::parseExpression() {
-  auto left = parseTerm();
-  while (match(Token::PLUS) || match(Token::MINUS)) {
-    auto op = previous->type == Token::PLUS ? PLUS_OP : MINUS_OP;
-    auto right = parseTerm();
-    left = new BinaryExp(left, right, op);
+// Igual que stmRules, para el operando de una expresión: literales,
+// llamadas, paréntesis, if-exp, index, dot, listas y '-' unario. Los
+// nombres built-in (IntArray, listOf, ...) son tipos de token propios desde
+// el scanner, así que no se compara texto.
+const array<Parser::FactorRule, Token::COUNT> Parser::factorRules = [] {
+  array<FactorRule, Token::COUNT> t{};
+  t[Token::TRUE] = &Parser::parseBoolLit;
+  t[Token::FALSE] = &Parser::parseBoolLit;
+  t[Token::STRING] = &Parser::parseStringLit;
+  t[Token::NUM] = &Parser::parseNumberLit;
+  t[Token::INTARRAY] = &Parser::parseArrayInit;
+  t[Token::DOUBLEARRAY] = &Parser::parseArrayInit;
+  t[Token::ARRAY] = &Parser::parseArrayInit;
+  t[Token::ARRAYOF] = &Parser::parseListExp;
+  t[Token::INTARRAYOF] = &Parser::parseListExp;
+  t[Token::LONGARRAYOF] = &Parser::parseListExp;
+  t[Token::DOUBLEARRAYOF] = &Parser::parseListExp;
+  t[Token::BOOLEANARRAYOF] = &Parser::parseListExp;
+  t[Token::LISTOF] = &Parser::parseListExp;
+  t[Token::MUTABLELISTOF] = &Parser::parseListExp;
+  t[Token::ID] = &Parser::parseIdFactor;
+  t[Token::IF] = &Parser::parseIfExp;
+  t[Token::PI] = &Parser::parseParenExp;
+  t[Token::MINUS] = &Parser::parseUnary;
+  return t;
+}();
+
+Exp *Parser::parseFactor() {
+  FactorRule rule = factorRules[current.type];
+  if (!rule) {
+    error("Factor no reconocido");
+    return nullptr;
   }
-  return left;
+  advance();
+  return (this->*rule)();
 }
 
-Exp *Parser::parseTerm() {
-  auto left = parseFactor();
-  while (match(Token::MUL) || match(Token::DIV)) {
-    auto op = previous->type == Token::MUL ? MUL_OP : DIV_OP;
-    auto right = parseFactor();
-    left = new BinaryExp(left, right, op);
+// '-' unario (liga más que cualquier binario): un literal se niega al
+// parsear; si no, se arma 0 - x
+Exp *Parser::parseUnary() {
+  Exp *operand = parseFactor();
+  if (auto *num = node_cast<NumberExp>(operand)) {
+    num->value = -num->value;
+    return num;
   }
-  return left;
+  return node<BinaryExp>(node<NumberExp>(0), operand, MINUS_OP);
 }
 
-Exp *Parser::parseFactor() {
-  // 1) Literales básicos
-  if (match(Token::TRUE)) {
-    return new BoolExp(true);
-  } else if (match(Token::FALSE)) {
-    return new BoolExp(false);
-  } else if (match(Token::STRING)) {
-    return new StringExp(previous->text);
-  } else if (match(Token::NUM)) {
-    return new NumberExp(stoll(previous->text));
-  }
-
-  // 2) IntArray(size) { it -> ... }
-  else if (match(Token::ID, "IntArray")) {
-    consume(Token::PI, "Se esperaba '(' tras IntArray");
-    Exp *sizeExp = parseCExp();
-    auto *num = dynamic_cast<NumberExp *>(sizeExp);
-    if (!num)
-      error("El primer argumento de IntArray debe ser un literal numérico");
-    int n = num->value;
-    consume(Token::PD, "Se esperaba ')' tras tamaño de IntArray");
-
-    consume(Token::LBRACE, "Se esperaba '{' tras IntArray(...)");
-    Exp *body = parseCExp();
-    consume(Token::RBRACE, "Se esperaba '}' al final de la lambda de IntArray");
-
-    auto *le = new ListExp(false);
-    for (int i = 0; i < n; ++i) {
-      std::function<Exp *(Exp *)> subst = [&](Exp *e) -> Exp * {
-        if (auto *v = dynamic_cast<IdentifierExp *>(e)) {
-          if (v->name == "it")
-            return new NumberExp(i);
-          return new IdentifierExp(v->name);
-        }
-        if (auto *b = dynamic_cast<BinaryExp *>(e)) {
-          return new BinaryExp(subst(b->left), subst(b->right), b->op);
-        }
-        if (auto *n2 = dynamic_cast<NumberExp *>(e)) {
-          return new NumberExp(n2->value);
-        }
-        // Si tienes otros Exp, trátalos aquí…
-        return nullptr;
-      };
-      le->add(subst(body));
-    }
-    return le;
-  }
-
-  // 3) DoubleArray(size) { it -> ... }
-  else if (match(Token::ID, "DoubleArray")) {
-    consume(Token::PI, "Se esperaba '(' tras DoubleArray");
-    Exp *sizeExp = parseCExp();
-    auto *num = dynamic_cast<NumberExp *>(sizeExp);
-    if (!num)
-      error("El primer argumento de DoubleArray debe ser un literal numérico");
-    int n = num->value;
-    consume(Token::PD, "Se esperaba ')' tras tamaño de DoubleArray");
-
-    consume(Token::LBRACE, "Se esperaba '{' tras DoubleArray(...)");
-    Exp *body = parseCExp();
-    consume(Token::RBRACE,
-            "Se esperaba '}' al final de la lambda de DoubleArray");
-
-    auto *le = new ListExp(false);
-    for (int i = 0; i < n; ++i) {
-      std::function<Exp *(Exp *)> subst = [&](Exp *e) -> Exp * {
-        if (auto *v = dynamic_cast<IdentifierExp *>(e)) {
-          if (v->name == "it")
-            return new NumberExp(i);
-          return new IdentifierExp(v->name);
-        }
-        if (auto *b = dynamic_cast<BinaryExp *>(e)) {
-          return new BinaryExp(subst(b->left), subst(b->right), b->op);
-        }
-        if (auto *n2 = dynamic_cast<NumberExp *>(e)) {
-          return new NumberExp(n2->value);
-        }
-        return nullptr;
-      };
-      le->add(subst(body));
-    }
-    return le;
+Exp *Parser::parseBoolLit() {
+  return node<BoolExp>(previous.type == Token::TRUE);
+}
+
+Exp *Parser::parseStringLit() {
+  return node<StringExp>(string(previous.text));
+}
+
+Exp *Parser::parseNumberLit() { return node<NumberExp>(previous.value); }
+
+// IntArray(n) { ... }, DoubleArray(n) { ... }, Array<T>(n) { ... } con 'it'
+// implícito. El lambda se guarda una vez en un ArrayInitExp.
+Exp *Parser::parseArrayInit() {
+  std::string fn(previous.text);
+  const Type *elemType = nullptr;
+  if (previous.type == Token::INTARRAY) {
+    elemType = Type::Int();
+  } else if (previous.type == Token::DOUBLEARRAY) {
+    elemType = Type::Double();
+  } else if (match(Token::LT)) {
+    elemType = parseType("Se esperaba parámetro genérico de Array");
+    consume(Token::GT, "Se esperaba '>' tras parámetro genérico de Array");
   }
 
-  // 4) Array<T>(n) { lambda }  → siempre con 'it' implícito
-  else if (match(Token::ID, "Array")) {
-    // 1) Saltar genéricos <T>
-    if (match(Token::LT)) {
-      while (!check(Token::GT) && !isAtEnd())
-        advance();
-      consume(Token::GT, "Se esperaba '>' tras parámetro genérico de Array");
-    }
+  // tamaño: cualquier expresión
+  consume(Token::PI, "Se esperaba '(' tras " + fn);
+  Exp *sizeExp = parseCExp();
+  consume(Token::PD, "Se esperaba ')' tras tamaño de " + fn);
 
-    // 2) Leer tamaño n
-    consume(Token::PI, "Se esperaba '(' tras Array");
-    Exp *sizeExp = parseCExp();
-    auto *num = dynamic_cast<NumberExp *>(sizeExp);
-    if (!num)
-      error("El primer argumento de Array debe ser un literal numérico");
-    int n = num->value;
-    consume(Token::PD, "Se esperaba ')' tras tamaño de Array");
-
-    // 3) Leer lambda { it * ... }
-    consume(Token::LBRACE, "Se esperaba '{' tras Array(...)");
-    Exp *body = parseCExp();
-    consume(Token::RBRACE, "Se esperaba '}' al final de la lambda de Array");
-
-    // 4) Expande a ListExp con 'it' implícito
-    auto *le = new ListExp(false);
-    for (int i = 0; i < n; ++i) {
-      std::function<Exp *(Exp *)> subst = [&](Exp *e) -> Exp * {
-        if (auto *v = dynamic_cast<IdentifierExp *>(e)) {
-          if (v->name == "it")
-            return new NumberExp(i);
-          return new IdentifierExp(v->name);
-        }
-        if (auto *b = dynamic_cast<BinaryExp *>(e)) {
-          return new BinaryExp(subst(b->left), subst(b->right), b->op);
-        }
-        if (auto *n2 = dynamic_cast<NumberExp *>(e)) {
-          return new NumberExp(n2->value);
-        }
-        return nullptr;
-      };
-      le->add(subst(body));
-    }
-    return le;
+  consume(Token::LBRACE, "Se esperaba '{' tras " + fn + "(...)");
+  Exp *body = parseCExp();
+  consume(Token::RBRACE, "Se esperaba '}' al final de la lambda de " + fn);
+
+  return node<ArrayInitExp>(elemType, sizeExp, body);
+}
+
+// Fábricas sin lambda: listOf, arrayOf, intArrayOf, doubleArrayOf, ... y
+// mutableListOf (la única mutable)
+Exp *Parser::parseListExp() {
+  std::string fn(previous.text);
+  auto le = node<ListExp>(previous.type == Token::MUTABLELISTOF);
+  consume(Token::PI, "Se esperaba '(' en " + fn);
+  if (!check(Token::PD)) {
+    do {
+      le->add(parseCExp());
+    } while (match(Token::COMA));
   }
+  consume(Token::PD, "Se esperaba ')' en " + fn);
+  return le;
+}
 
-  // 4) Fábricas de lista/array sin lambda: listOf, arrayOf, intArrayOf,
-  // doubleArrayOf, ... mutableListOf (mutable)
-  else if (match(Token::ID, "mutableListOf")) {
-    consume(Token::PI, "Se esperaba '(' en mutableListOf");
-    auto le = new ListExp(true); // mutable!
-    if (!check(Token::PD)) {
-      do {
-        le->add(parseCExp());
-      } while (match(Token::COMA));
-    }
-    consume(Token::PD, "Se esperaba ')' en mutableListOf");
-    return le;
-  }
-  // 3) el resto de fábricas (arrays y demás)
-  else if (match(Token::ID, "arrayOf") || match(Token::ID, "intArrayOf") ||
-           match(Token::ID, "longArrayOf") ||
-           match(Token::ID, "doubleArrayOf") ||
-           match(Token::ID, "booleanArrayOf") || match(Token::ID, "listOf")) {
-    std::string fn = previous->text;
-    consume(Token::PI, "Se esperaba '(' en " + fn);
-    auto le = new ListExp(false); // aquí siempre false
+// Identificador, llamada foo(...), índice foo[i] o miembro foo.bar. Por
+// limitaciones, sólo se encadena un nivel
+Exp *Parser::parseIdFactor() {
+  Symbol id = previous.sym;
+  if (match(Token::PI)) {
+    auto *call = node<FCallExp>(id);
     if (!check(Token::PD)) {
       do {
-        le->add(parseCExp());
+        call->add(parseCExp());
       } while (match(Token::COMA));
     }
-    consume(Token::PD, "Se esperaba ')' en " + fn);
-    return le;
-  }
-
-  // 5) Identificador / llamada / index / member
-  else if (match(Token::ID)) {
-    Exp *expr;
-    // 1) Partimos de un IdentifierExp
-    string id = previous->text;
-
-    // 2) Parsing de llamada: foo(...)
-    if (match(Token::PI)) {
-      auto *call = new FCallExp(id);
-      if (!check(Token::PD)) {
-        do {
-          call->add(parseCExp());
-        } while (match(Token::COMA));
-      }
-      consume(Token::PD, "Se esperaba ')' en llamada");
-      expr = call;
-    } else {
-      // 3) Ahora encadenamos: [idx] o .member. Por limitaciones, solo se puede
-      // hacer de 1 nivel
-      if (match(Token::LBRACK)) {
-        Exp *idx = parseCExp();
-        consume(Token::RBRACK, "Se esperaba ']' en index");
-        expr = new IndexExp(id, idx);
-      } else if (match(Token::DOT)) {
-        auto member = consume(Token::ID, "Se esperaba miembro tras '.'")->text;
-        expr = new DotExp(id, member);
-      } else {
-        expr = new IdentifierExp(id);
-      }
-    }
-
-    return expr;
+    consume(Token::PD, "Se esperaba ')' en llamada");
+    return call;
   }
-
-  // 6) Inline if
-  else if (match(Token::IF)) {
-    consume(Token::PI, "Se esperaba '(' en inline if");
-    auto cond = parseCExp();
-    consume(Token::PD, "Se esperaba ')' tras condición de inline if");
-    auto thenExpr = parseCExp();
-    consume(Token::ELSE, "Se esperaba 'else' en inline if");
-    auto elseExpr = parseCExp();
-    return new IFExp(cond, thenExpr, elseExpr);
+  if (match(Token::LBRACK)) {
+    Exp *idx = parseCExp();
+    consume(Token::RBRACK, "Se esperaba ']' en index");
+    return node<IndexExp>(id, idx);
   }
-
-  // 7) Paréntesis
-  else if (match(Token::PI)) {
-    auto e = parseCExp();
-    consume(Token::PD, "Falta ')'");
-    return e;
+  if (match(Token::DOT)) {
+    Symbol member = consume(Token::ID, "Se esperaba miembro tras '.'").sym;
+    return node<DotExp>(id, member);
   }
+  return node<IdentifierExp>(id);
+}
+
+// Inline if: if (c) a else b
+Exp *Parser::parseIfExp() {
+  consume(Token::PI, "Se esperaba '(' en inline if");
+  auto cond = parseCExp();
+  consume(Token::PD, "Se esperaba ')' tras condición de inline if");
+  auto thenExpr = parseCExp();
+  consume(Token::ELSE, "Se esperaba 'else' en inline if");
+  auto elseExpr = parseCExp();
+  return node<IFExp>(cond, thenExpr, elseExpr);
+}
 
-  error("Factor no reconocido");
-  return nullptr;
+Exp *Parser::parseParenExp() {
+  auto e = parseCExp();
+  consume(Token::PD, "Falta ')'");
+  return e;
 }
 
 vector<Exp *> Parser::parseArgList() {
@@ -705,7 +759,7 @@ LoopExp *Parser::parseLoopExp() {
   if (match(Token::STEP)) {
     step = parseCExp();
   } else {
-    step = new NumberExp(1);
+    step = node<NumberExp>(1);
   }
-  return new LoopExp(start, end, step, downTo);
+  return node<LoopExp>(start, end, step, downTo);
 }
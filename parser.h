@@ -2,30 +2,68 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include "arena.h"
 #include "scanner.h"
 #include "token.h"
 #include "exp.h"
+#include "flat_ast.h"
+#include <array>
+#include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
 
 class Parser {
 public:
     explicit Parser(Scanner* scanner, bool e);
+    // Crea los nodos en 'arena' (p. ej. una reusada con Arena::reset)
+    Parser(Scanner* scanner, bool e, std::unique_ptr<Arena> arena);
     Program* parse();      // inicia el análisis sintáctico
     Program* parseProgram();
+    FlatAst  parseFlat();   // igual, pero en forma plana (ver flat_ast.h)
+
+    // --- Compilación por partes (ver streaming.h) ---
+    // Globales y clases, con funDecs vacío. El Program se queda con lo
+    // parseado hasta acá y el parser sigue con una arena nueva.
+    Program* parseHeader();
+    // Firma de la siguiente función (body = nullptr): el cuerpo se saltea
+    // token a token, sin armar nodos. nullptr si no quedan funciones.
+    FunDec*  parseSignature();
+    // Siguiente función completa; nullptr si no quedan
+    FunDec*  parseFunction();
+    // Entrega la arena con lo parseado desde la última vez y sigue con una
+    // nueva: liberarla libera esos nodos
+    std::unique_ptr<Arena> takeArena();
+
+    // Posición en el fuente, para volver a leer desde ahí
+    struct Mark {
+        Scanner scanner;
+        Token current, previous;
+    };
+    Mark mark() const;
+    void reset(const Mark& m);
 
 private:
     bool exitError;
     Scanner* scanner;
-    Token*   current;
-    Token*   previous;
+    Token    current;
+    Token    previous;
+    // Arena donde se crean todos los nodos; pasa al Program al terminar
+    std::unique_ptr<Arena> arena;
+
+    template <typename T, typename... Args> T* node(Args&&... args) {
+        return arena->make<T>(std::forward<Args>(args)...);
+    }
 
     // --- Helpers básicos ---
     bool      match(Token::Type type);
-    bool      match(Token::Type type, const std::string& lexeme);
     bool      check(Token::Type type) const;
-    Token*    advance();
-    Token*    consume(Token::Type type, const std::string& message);
+    bool      checkTypeName() const;
+    Token     advance();
+    // Los mensajes son string_view: un literal no se copia salvo que haya error
+    Token     consume(Token::Type type, std::string_view message);
+    Token     consumeTypeName(std::string_view message);
+    const Type* parseType(std::string_view message); // Nombre [ < Type (, Type)* > ]
     bool      isAtEnd() const;
     void      error(const std::string& msg);
 
@@ -37,25 +75,64 @@ private:
     VarDec* parseVarDec();        // var/val id : Type [ = CExp ]
     ClassDec* parseClassDec();      // class id ( Arguments ) { VarDecList }
     FunDec* parseFunDec();        // fun Type id ( ParamDecList ) [ VarDecList StmtList ] endfun
+    // fun id ( ParamDecList ) [ : Type ]; false si no viene 'fun'
+    bool parseFunSignature(Symbol& name, std::vector<Param>& params,
+                           const Type*& retType);
+    void skipFunBody();           // { ... } | = CExp, sin armar nodos
+
+    std::vector<Param> parseParamDecList(); // id : Type (, id : Type )*
+    std::vector<Argument> parseArguments();    // val id : Type (, val id : Type )*
 
-    std::vector<Param>* parseParamDecList(); // id : Type (, id : Type )*
-    std::vector<Argument>* parseArguments();    // val id : Type (, val id : Type )*
+    Body* parseBody();          // VarDecList Stmt*, iterativo (ver Block)
+    Stm* parseStmt();          // sentencia simple: despacha por stmRules
 
-    Body* parseBody();          // VarDecList StmtList
-    StatementList* parseStmtList();      // Stmt ( ; Stmt )*
-    Stm* parseStmt();          // cada tipo de sentencia
+    // Reglas de sentencia: el token que las elige ya está en 'previous'
+    Stm* parsePrintStmt();     // print ( CExp ) | println ( CExp )
+    Stm* parseAssignStmt();    // id [ [CExp] | .id ] = CExp
+    Stm* parseReturnStmt();    // return CExp
 
-    Exp* parseCExp();          // Exp [(<|<=|==) Exp]
-    Exp* parseExpression();    // Term ((+|-) Term)*
-    Exp* parseTerm();          // Factor ((*|/) Factor)*
-    Exp* parseFactor();        // literales, llamadas, paréntesis, if-exp, index, dot, lista
+    // Bloque abierto de parseBody: el cuerpo que se pidió (Root) o el de un
+    // if/else/while/for que todavía no se cerró
+    struct Block {
+        enum Kind : uint8_t { Root, Then, Else, While, For } kind;
+        bool braces;                 // { ... } o una sola sentencia
+        Exp* cond = nullptr;         // if / while
+        Symbol var;                  // for
+        Exp* iterable = nullptr;     // for
+        Body* thenB = nullptr;       // Else: la rama then ya cerrada
+        VarDecList* vars = nullptr;
+        StatementList* stmts = nullptr;
+    };
+    std::vector<Block> blocks_;
+    void openBlock(Block::Kind kind, bool braces);
+    bool openStmtBlock();      // if/while/for: parsea la cabecera y abre su bloque
+
+    Exp* parseCExp();          // Factor (op Factor)*, con pilas explícitas
+    Exp* parseFactor();        // despacha por el primer token (factorRules)
+
+    // Reglas de factor: el token que las elige ya está en 'previous'
+    Exp* parseUnary();         // - Factor
+    Exp* parseBoolLit();       // true | false
+    Exp* parseStringLit();
+    Exp* parseNumberLit();
+    Exp* parseArrayInit();     // IntArray(n) { CExp } | Array<T>(n) { CExp } ...
+    Exp* parseListExp();       // listOf(...) | mutableListOf(...) | xxxArrayOf(...)
+    Exp* parseIdFactor();      // id | id(args) | id[CExp] | id.id
+    Exp* parseIfExp();         // if ( CExp ) CExp else CExp
+    Exp* parseParenExp();      // ( CExp )
 
     std::vector<Exp*> parseArgList();       // CExp (, CExp)*
-    ListExp* parseListExp();       // listOf(...) | mutableListOf(...)
     LoopExp* parseLoopExp();       // CExp .. CExp [ step CExp ] | downTo
 
-    // para el for:
-    // for ( id in (LoopExp | id) ) { Body }
+    // Pilas de parseCExp: operandos y operadores pendientes
+    std::vector<Exp*> vals_;
+    std::vector<Token::Type> ops_;
+
+    // Tablas de despacho indexadas por Token::Type; nullptr = no hay regla
+    using StmRule = Stm* (Parser::*)();
+    using FactorRule = Exp* (Parser::*)();
+    static const std::array<StmRule, Token::COUNT> stmRules;
+    static const std::array<FactorRule, Token::COUNT> factorRules;
 };
 
 #endif // PARSER_H
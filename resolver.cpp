@@ -0,0 +1,211 @@
+// resolver.cpp
+#include "resolver.h"
+
+using namespace std;
+
+void Resolver::resolve(Program *prog) { accept(prog); }
+
+Binding Resolver::declare(Symbol name) {
+  Binding b;
+  b.depth = depth;
+  b.slot = depth == Binding::kLocal ? localSlots++ : globalSlots++;
+  scopes.back()[name] = b;
+  return b;
+}
+
+// Del scope más interno al global; sin resolver si no aparece
+Binding Resolver::lookup(Symbol name) const {
+  for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+    auto found = it->find(name);
+    if (found != it->end())
+      return found->second;
+  }
+  return Binding();
+}
+
+// ── Expresiones ──
+
+// Espina izquierda con un bucle (ver pushLeftSpine)
+void Resolver::visit(BinaryExp *exp) {
+  size_t base = spine.size();
+  accept(pushLeftSpine(exp, spine));
+  while (spine.size() > base) {
+    BinaryExp *b = spine.back();
+    spine.pop_back();
+    accept(b->right);
+  }
+}
+
+void Resolver::visit(IFExp *exp) {
+  accept(exp->cond);
+  accept(exp->left);
+  accept(exp->right);
+}
+
+void Resolver::visit(StringExp *) {}
+void Resolver::visit(NumberExp *) {}
+void Resolver::visit(BoolExp *) {}
+
+void Resolver::visit(IdentifierExp *exp) { exp->bind = lookup(exp->name); }
+
+void Resolver::visit(FCallExp *exp) {
+  for (auto *arg : exp->args)
+    accept(arg);
+  auto it = functions.find(exp->name);
+  exp->fn = it != functions.end() ? it->second : nullptr;
+  auto cls = classes.find(exp->name);
+  exp->cls = cls != classes.end() ? cls->second : nullptr;
+}
+
+void Resolver::visit(ListExp *exp) {
+  for (auto *e : exp->elements)
+    accept(e);
+}
+
+void Resolver::visit(IndexExp *exp) {
+  accept(exp->index);
+  exp->bind = lookup(exp->name);
+}
+
+void Resolver::visit(DotExp *exp) { exp->bind = lookup(exp->id); }
+
+void Resolver::visit(LoopExp *exp) {
+  accept(exp->start);
+  accept(exp->end);
+  if (exp->step)
+    accept(exp->step);
+}
+
+// 'it' sólo existe dentro del lambda
+void Resolver::visit(ArrayInitExp *exp) {
+  accept(exp->size);
+  openScope();
+  exp->it = declare(sym::it);
+  accept(exp->body);
+  closeScope();
+}
+
+// ── Sentencias ──
+
+void Resolver::visit(AssignStatement *stm) {
+  accept(stm->expr);
+  accept(stm->target);
+}
+
+void Resolver::visit(PrintStatement *stm) { accept(stm->expr); }
+
+void Resolver::visit(IfStatement *stm) {
+  accept(stm->cond);
+  accept(stm->thenBranch);
+  if (stm->elseBranch)
+    accept(stm->elseBranch);
+}
+
+void Resolver::visit(WhileStatement *stm) {
+  accept(stm->cond);
+  accept(stm->body);
+}
+
+// El iterable se resuelve fuera del scope de la variable del bucle
+void Resolver::visit(ForStatement *stm) {
+  accept(stm->iterable);
+  openScope();
+  stm->bind = declare(stm->varName);
+  localSlots++; // índice al recorrer una lista (ver GenCodeVisitor)
+  accept(stm->body);
+  closeScope();
+}
+
+void Resolver::visit(ReturnStatement *stm) {
+  if (stm->expr)
+    accept(stm->expr);
+}
+
+// ── Declaraciones y bloques ──
+
+// Cada init se resuelve antes de declarar su nombre: 'val x = x' ve la x de
+// afuera, y los nombres quedan en slots consecutivos
+void Resolver::visit(VarDec *dec) {
+  for (size_t i = 0; i < dec->names.size(); ++i) {
+    if (i < dec->inits.size() && dec->inits[i])
+      accept(dec->inits[i]);
+    Binding b = declare(dec->names[i]);
+    if (i == 0)
+      dec->bind = b;
+  }
+}
+
+void Resolver::visit(VarDecList *list) {
+  for (auto *dec : list->vars)
+    accept(dec);
+}
+
+// Los campos no son variables: sólo se resuelven sus valores por defecto,
+// que se evalúan al construir el objeto
+void Resolver::visit(ClassDec *dec) {
+  for (auto *var : dec->members->vars)
+    for (auto *init : var->inits)
+      if (init)
+        accept(init);
+}
+
+void Resolver::visit(ClassDecList *list) {
+  for (auto *cls : list->classes)
+    accept(cls);
+}
+
+void Resolver::visit(FunDec *dec) {
+  depth = Binding::kLocal;
+  localSlots = 0;
+  openScope();
+  for (auto &p : dec->params)
+    declare(p.name);
+  accept(dec->body);
+  closeScope();
+  dec->frameSize = localSlots;
+  depth = Binding::kGlobal;
+}
+
+void Resolver::visit(FunDecList *list) {
+  for (auto *fn : list->functions)
+    accept(fn);
+}
+
+void Resolver::visit(StatementList *list) {
+  for (auto *s : list->statements)
+    accept(s);
+}
+
+void Resolver::visit(Body *body) {
+  openScope();
+  accept(body->vardecs);
+  accept(body->stmts);
+  closeScope();
+}
+
+// Deja abierto el scope global para las funciones
+void Resolver::begin(Program *prog) {
+  // 1) funciones y clases primero: se pueden llamar antes de declararse
+  functions.clear();
+  for (auto *fn : prog->funDecs->functions)
+    functions[fn->name] = fn;
+  classes.clear();
+  for (auto *cls : prog->classDecs->classes)
+    classes[cls->name] = cls;
+
+  // 2) globales y clases (las funciones sólo declaran locales)
+  scopes.clear();
+  openScope();
+  depth = Binding::kGlobal;
+  globalSlots = 0;
+  accept(prog->vardecs);
+  accept(prog->classDecs);
+  prog->globalSlots = globalSlots;
+}
+
+// prog->body es el cuerpo de main
+void Resolver::visit(Program *prog) {
+  begin(prog);
+  accept(prog->funDecs);
+  closeScope();
+}
@@ -0,0 +1,78 @@
+// resolver.h
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include "exp.h"
+#include "visitor.h"
+#include <unordered_map>
+#include <vector>
+
+// Pasada de nombres que corre después de parsear (y después de cargar el AST
+// de la caché, porque los Binding no se guardan ahí). Recorre el programa con
+// los scopes léxicos y deja en cada nodo a qué variable se refiere:
+//   - IdentifierExp, IndexExp, DotExp, destinos de asignación -> Binding
+//   - VarDec, ForStatement, 'it' de ArrayInitExp               -> Binding
+//   - FCallExp                                  -> FunDec* o ClassDec*
+// Cada función tiene un frame plano: los params en los slots 0..n-1 y cada
+// variable local en un slot propio (aunque tenga el nombre de otra de un
+// bloque ya cerrado), así que FunDec::frameSize alcanza para reservarlo
+// entero al entrar. Las globales van en otro frame (Program::globalSlots).
+// Un nombre que no se encuentra queda sin resolver y cada visitor lo trata
+// como antes (error del intérprete, etiqueta global en codegen).
+class Resolver : public VisitorBase<Resolver, void, void> {
+public:
+  void resolve(Program *prog);
+  // Por partes (ver streaming.h): begin con el Program de
+  // Parser::parseHeader, que ya trae las firmas de todas las funciones, y
+  // después resolveFunction con cada función completa a medida que llega
+  void begin(Program *prog);
+  void resolveFunction(FunDec *fn) { accept(fn); }
+
+  void visit(BinaryExp *exp);
+  void visit(IFExp *exp);
+  void visit(StringExp *exp);
+  void visit(NumberExp *exp);
+  void visit(BoolExp *exp);
+  void visit(IdentifierExp *exp);
+  void visit(FCallExp *exp);
+  void visit(ListExp *exp);
+  void visit(IndexExp *exp);
+  void visit(DotExp *exp);
+  void visit(LoopExp *exp);
+  void visit(ArrayInitExp *exp);
+
+  void visit(AssignStatement *stm);
+  void visit(PrintStatement *stm);
+  void visit(IfStatement *stm);
+  void visit(WhileStatement *stm);
+  void visit(ForStatement *stm);
+  void visit(ReturnStatement *stm);
+
+  void visit(VarDec *dec);
+  void visit(VarDecList *list);
+  void visit(ClassDec *dec);
+  void visit(ClassDecList *list);
+  void visit(FunDec *dec);
+  void visit(FunDecList *list);
+
+  void visit(StatementList *list);
+  void visit(Body *body);
+  void visit(Program *prog);
+
+private:
+  // Reserva el siguiente slot del frame actual y lo asocia a name
+  Binding declare(Symbol name);
+  Binding lookup(Symbol name) const;
+  void openScope() { scopes.emplace_back(); }
+  void closeScope() { scopes.pop_back(); }
+
+  std::vector<std::unordered_map<Symbol, Binding>> scopes;
+  std::unordered_map<Symbol, FunDec *> functions;
+  std::unordered_map<Symbol, ClassDec *> classes;
+  uint8_t depth = Binding::kGlobal; // frame donde caen las declaraciones
+  uint32_t globalSlots = 0;
+  uint32_t localSlots = 0;
+  std::vector<BinaryExp *> spine; // ver visit(BinaryExp*)
+};
+
+#endif // RESOLVER_H
@@ -1,12 +1,12 @@
 // scanner.cpp
 #include "scanner.h"
 #include "token.h"
-#include <cstring>
+#include "simd_lexer.h"
 #include <iostream>
 
 using namespace std;
 
-Scanner::Scanner(const char *s) : input(s), first(0), current(0) {}
+Scanner::Scanner(string_view s) : input(s), first(0), current(0) {}
 
 Scanner::~Scanner() {}
 
@@ -15,197 +15,251 @@ void Scanner::reset() {
   current = 0;
 }
 
-static bool is_white_space(char c) {
-  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+// --- Palabras reservadas y nombres built-in ---
+// Hash perfecto generado en compilación: (len + w[0] + 4 * w[len-1]) % 64.
+// La tabla se construye con constexpr y un static_assert garantiza que no hay
+// colisiones, así que clasificar un identificador es un hash y una comparación.
+
+namespace {
+
+struct Keyword {
+  std::string_view text;
+  Token::Type type;
+};
+
+constexpr Keyword keywords[] = {
+    {"print", Token::PRINT},
+    {"println", Token::PRINTLN},
+    {"if", Token::IF},
+    {"else", Token::ELSE},
+    {"while", Token::WHILE},
+    {"for", Token::FOR},
+    {"in", Token::IN},
+    {"var", Token::VAR},
+    {"val", Token::VAL},
+    {"fun", Token::FUN},
+    {"return", Token::RETURN},
+    {"true", Token::TRUE},
+    {"false", Token::FALSE},
+    {"downTo", Token::DOWNTO},
+    {"step", Token::STEP},
+    {"class", Token::CLASS},
+    {"IntArray", Token::INTARRAY},
+    {"DoubleArray", Token::DOUBLEARRAY},
+    {"Array", Token::ARRAY},
+    {"arrayOf", Token::ARRAYOF},
+    {"intArrayOf", Token::INTARRAYOF},
+    {"longArrayOf", Token::LONGARRAYOF},
+    {"doubleArrayOf", Token::DOUBLEARRAYOF},
+    {"booleanArrayOf", Token::BOOLEANARRAYOF},
+    {"listOf", Token::LISTOF},
+    {"mutableListOf", Token::MUTABLELISTOF},
+};
+
+constexpr int kNumKeywords = sizeof(keywords) / sizeof(keywords[0]);
+constexpr unsigned kKeywordSlots = 64;
+
+constexpr unsigned keywordHash(std::string_view w) {
+  return (unsigned(w.size()) + (unsigned char)w[0] +
+          4u * (unsigned char)w[w.size() - 1]) %
+         kKeywordSlots;
 }
 
-Token *Scanner::nextToken() {
-  // saltar espacios
-  while (current < (int)input.size() && is_white_space(input[current]))
-    current++;
+// slot -> índice en 'keywords' (o -1 si está vacío)
+struct KeywordTable {
+  signed char slot[kKeywordSlots];
+  bool perfect;
+};
+
+constexpr KeywordTable buildKeywordTable() {
+  KeywordTable t{};
+  t.perfect = true;
+  for (unsigned i = 0; i < kKeywordSlots; i++)
+    t.slot[i] = -1;
+  for (int i = 0; i < kNumKeywords; i++) {
+    unsigned h = keywordHash(keywords[i].text);
+    if (t.slot[h] != -1)
+      t.perfect = false;
+    t.slot[h] = (signed char)i;
+  }
+  return t;
+}
+
+constexpr KeywordTable keywordTable = buildKeywordTable();
+static_assert(keywordTable.perfect,
+              "El hash de palabras reservadas tiene colisiones");
+
+constexpr Token::Type keywordType(std::string_view word) {
+  int k = keywordTable.slot[keywordHash(word)];
+  if (k >= 0 && keywords[k].text == word)
+    return keywords[k].type;
+  return Token::ID;
+}
+
+static_assert(keywordType("println") == Token::PRINTLN);
+static_assert(keywordType("mutableListOf") == Token::MUTABLELISTOF);
+static_assert(keywordType("it") == Token::ID);
+
+} // namespace
+
+Token Scanner::nextToken() {
+  const char *base = input.data();
+  const char *end = base + input.size();
+
+  // saltar espacios (por bloques con SIMD si la racha sigue)
+  if (current < (int)input.size() && charclass::isSpace(input[current]))
+    current = simdlex::skipSpaces(base + current + 1, end) - base;
   // fin de input
   if (current >= (int)input.size())
-    return new Token(Token::END);
+    return Token(Token::END);
 
   first = current;
   char c = input[current];
+  // span del lexema actual sobre 'input' (sin copiar)
+  auto lexeme = [&]() {
+    return std::string_view(base + first, current - first);
+  };
 
   // Números
-  if (isdigit(c)) {
-  bool isFloat = false;
-  current++;
-  while (current < input.size() && isdigit(input[current]))
+  if (charclass::isDigit(c)) {
+    // se decodifica la parte entera mientras se escanea
+    long long value = c - '0';
     current++;
-  // solo consumir '.' como parte del número si tras él hay un dígito
-  if (current + 1 < input.size()
-      && input[current] == '.'
-      && isdigit(input[current+1])) {
-    isFloat = true;
-    current++;  // consume '.'
-    while (current < input.size() && isdigit(input[current]))
+    while (current < (int)input.size() && charclass::isDigit(input[current])) {
+      value = value * 10 + (input[current] - '0');
       current++;
-  }
-    std::string txt = input.substr(first, current - first);
-    return new Token(Token::NUM, txt, 0, txt.size());
+    }
+    // solo consumir '.' como parte del número si tras él hay un dígito
+    if (current + 1 < (int)input.size() && input[current] == '.' &&
+        charclass::isDigit(input[current + 1])) {
+      current++; // consume '.'
+      while (current < (int)input.size() && charclass::isDigit(input[current]))
+        current++;
+    }
+    return Token(Token::NUM, lexeme(), value);
   }
 
   // Identificadores y palabras reservadas
-  if (isalpha(c)) {
-    current++;
-    while (current < (int)input.size() &&
-           (isalnum(input[current]) || input[current] == '_'))
-      current++;
-    std::string word = input.substr(first, current - first);
-
-    if (word == "print" || word == "println")
-      return new Token(Token::PRINT, word, 0, (int)word.size());
-    if (word == "if")
-      return new Token(Token::IF, word, 0, (int)word.size());
-    if (word == "else")
-      return new Token(Token::ELSE, word, 0, (int)word.size());
-    if (word == "while")
-      return new Token(Token::WHILE, word, 0, (int)word.size());
-    if (word == "for")
-      return new Token(Token::FOR, word, 0, (int)word.size());
-    if (word == "var")
-      return new Token(Token::VAR, word, 0, (int)word.size());
-    if (word == "val")
-      return new Token(Token::VAL, word, 0, (int)word.size());
-    if (word == "fun")
-      return new Token(Token::FUN, word, 0, (int)word.size());
-    if (word == "return")
-      return new Token(Token::RETURN, word, 0, (int)word.size());
-    if (word == "true")
-      return new Token(Token::TRUE, word, 0, (int)word.size());
-    if (word == "false")
-      return new Token(Token::FALSE, word, 0, (int)word.size());
-    if (word == "downTo")
-      return new Token(Token::DOWNTO, word, 0, (int)word.size());
-    if (word == "step")
-      return new Token(Token::STEP, word, 0, (int)word.size());
-    if (word == "class")
-      return new Token(Token::CLASS, word, 0, (int)word.size());
-
-    return new Token(Token::ID, word, 0, (int)word.size());
+  if (charclass::isAlpha(c)) {
+    current = simdlex::identEnd(base + current + 1, end) - base;
+    std::string_view word = lexeme();
+    Token tok(keywordType(word), word);
+    if (tok.type == Token::ID)
+      tok.sym = Symbol::intern(word);
+    return tok;
   }
 
   // Símbolos y operadores
-  Token *token = nullptr;
+  Token token;
   switch (c) {
   case '+':
-    token = new Token(Token::PLUS, c);
+    token.type = Token::PLUS;
     break;
   case '-':
-    token = new Token(Token::MINUS, c);
+    token.type = Token::MINUS;
     break;
   case '*':
-    token = new Token(Token::MUL, c);
+    token.type = Token::MUL;
     break;
   case '/':
-    token = new Token(Token::DIV, c);
+    token.type = Token::DIV;
     break;
   case ',':
-    token = new Token(Token::COMA, c);
+    token.type = Token::COMA;
     break;
   case ';':
-    token = new Token(Token::PC, c);
+    token.type = Token::PC;
     break;
   case '(':
-    token = new Token(Token::PI, c);
+    token.type = Token::PI;
     break;
   case ')':
-    token = new Token(Token::PD, c);
+    token.type = Token::PD;
     break;
   case '{':
-    token = new Token(Token::LBRACE, c);
+    token.type = Token::LBRACE;
     break;
   case '}':
-    token = new Token(Token::RBRACE, c);
+    token.type = Token::RBRACE;
     break;
   case '[':
-    token = new Token(Token::LBRACK, c);
+    token.type = Token::LBRACK;
     break;
   case ']':
-    token = new Token(Token::RBRACK, c);
+    token.type = Token::RBRACK;
     break;
   case ':':
-    token = new Token(Token::COLON, c);
+    token.type = Token::COLON;
     break;
 
   case '.':
     if (current + 1 < (int)input.size() && input[current + 1] == '.') {
-      token = new Token(Token::DOTDOT, "..", 0, 2);
+      token.type = Token::DOTDOT;
       current++;
     } else {
-      token = new Token(Token::DOT, ".", 0, 1);
+      token.type = Token::DOT;
     }
     break;
 
   case '=':
     if (current + 1 < (int)input.size() && input[current + 1] == '=') {
-      token = new Token(Token::EQ, "==", 0, 2);
+      token.type = Token::EQ;
       current++;
     } else {
-      token = new Token(Token::ASSIGN, c);
+      token.type = Token::ASSIGN;
     }
     break;
 
   case '>':
     if (current + 1 < (int)input.size() && input[current + 1] == '=') {
-      token = new Token(Token::GE, ">=", 0, 2);
+      token.type = Token::GE;
       current++;
     } else {
-      token = new Token(Token::GT, ">", 0, 1);
+      token.type = Token::GT;
     }
     break;
 
   case '<':
     if (current + 1 < (int)input.size() && input[current + 1] == '=') {
-      token = new Token(Token::LE, "<=", 0, 2);
+      token.type = Token::LE;
       current++;
     } else {
-      token = new Token(Token::LT, "<", 0, 1);
+      token.type = Token::LT;
     }
     break;
 
   case '"': {
-    std::string val;
-
-    while (current + 1 < (int)input.size() && input[current + 1] != '"') {
-      current++;
-      val += input[current];
-    }
-    if (current + 1 >= (int)input.size()) {
-      const char *msg = "Unterminated string literal";
-      token = new Token(Token::ERR, msg, 0, (int)strlen(msg));
+    // el texto del token es el contenido entre comillas
+    int start = current + 1;
+    current = simdlex::findQuote(base + start, end) - base;
+    if (current >= (int)input.size()) {
+      token = Token(Token::ERR, "Unterminated string literal");
     } else {
-      current++;
-      token = new Token(Token::STRING, val, 0, (int)val.size());
+      token = Token(Token::STRING,
+                    std::string_view(base + start, current - start));
+      current++; // consume '"'
     }
-    break;
+    return token;
   }
 
   default:
-
-    token = new Token(Token::ERR, c);
+    token.type = Token::ERR;
     break;
   }
   current++;
+  token.text = lexeme();
   return token;
 }
 
 void test_scanner(Scanner *scanner) {
-  Token *tok;
+  Token tok;
   cout << "Iniciando Scanner:" << endl << endl;
-  while ((tok = scanner->nextToken())->type != Token::END) {
-    if (tok->type == Token::ERR) {
-      cout << "Error en scanner - char inválido: " << tok->text << endl;
-      delete tok;
+  while ((tok = scanner->nextToken()).type != Token::END) {
+    if (tok.type == Token::ERR) {
+      cout << "Error en scanner - char inválido: " << tok.text << endl;
       break;
     }
-    cout << *tok << endl;
-    delete tok;
+    cout << tok << endl;
   }
   cout << "TOKEN(END)" << endl;
-  delete tok;
 }
@@ -2,16 +2,16 @@
 #ifndef SCANNER_H
 #define SCANNER_H
 
-#include <string>
+#include <string_view>
 #include "token.h"
 
 class Scanner {
 private:
-    std::string input;
+    std::string_view input;   // prestado: el dueño del buffer debe sobrevivir
     int first, current;
 public:
-    Scanner(const char* in_s);
-    Token* nextToken();
+    explicit Scanner(std::string_view in_s);
+    Token nextToken();
     void reset();
     ~Scanner();
 };
@@ -0,0 +1,201 @@
+// server.cpp
+#include "server.h"
+#include "asm_cache.h"
+#include "parser.h"
+#include "resolver.h"
+#include "scanner.h"
+#include "typecheck.h"
+#include "visitor.h"
+#include <cerrno>
+#include <chrono>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+using namespace std;
+
+CompileServer::CompileServer(string path)
+    : path(move(path)), arena(new Arena()) {}
+
+CompileServer::~CompileServer() {
+  if (fd >= 0) {
+    close(fd);
+    unlink(path.c_str());
+  }
+}
+
+bool CompileServer::listen(string &error) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    error = "ruta de socket demasiado larga: " + path;
+    return false;
+  }
+  memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+  // Un socket que quedó de un servidor anterior se reemplaza; cualquier
+  // otro archivo con ese nombre, no
+  struct stat st;
+  if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    unlink(path.c_str());
+
+  int s = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (s < 0 || bind(s, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+      ::listen(s, 16) != 0) {
+    error = path + ": " + strerror(errno);
+    if (s >= 0)
+      close(s);
+    return false;
+  }
+  fd = s;
+  return true;
+}
+
+namespace {
+
+// Un mensaje entero tiene que llegar en este tiempo, y cada send() del
+// servidor no puede esperar más que esto a que el cliente lea: las
+// conexiones se atienden de a una y un cliente colgado no puede dejar
+// esperando a los demás
+const int kClientTimeoutMs = 5000;
+
+using Clock = chrono::steady_clock;
+
+// Como recvAll, pero falla si llega 'deadline' antes de tener los n bytes
+// (también si el cliente los manda de a uno, despacio)
+bool recvBefore(int fd, void *data, size_t n, Clock::time_point deadline) {
+  char *p = static_cast<char *>(data);
+  while (n > 0) {
+    auto left =
+        chrono::duration_cast<chrono::milliseconds>(deadline - Clock::now());
+    pollfd pfd{fd, POLLIN, 0};
+    if (left.count() <= 0 || poll(&pfd, 1, int(left.count())) <= 0)
+      return false;
+    ssize_t k = recv(fd, p, n, 0);
+    if (k <= 0)
+      return false;
+    p += k, n -= k;
+  }
+  return true;
+}
+
+} // namespace
+
+void CompileServer::serve() {
+  while (!stopping) {
+    int client = accept(fd, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      break; // stop() cerró el socket
+    }
+    timeval tv{kClientTimeoutMs / 1000, kClientTimeoutMs % 1000 * 1000};
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    handle(client);
+    close(client);
+  }
+}
+
+// shutdown despierta al accept bloqueado en serve()
+void CompileServer::stop() {
+  stopping = true;
+  if (fd >= 0)
+    shutdown(fd, SHUT_RDWR);
+}
+
+// Un cliente que manda basura o pide más memoria de la que hay pierde su
+// conexión, no el servidor
+void CompileServer::handle(int client) {
+  uint8_t tag;
+  uint64_t size;
+  string body, out;
+  try {
+    for (;;) {
+      char head[9];
+      auto deadline = Clock::now() + chrono::milliseconds(kClientTimeoutMs);
+      if (stopping || !recvBefore(client, head, sizeof(head), deadline))
+        return;
+      tag = uint8_t(head[0]);
+      memcpy(&size, head + 1, 8);
+      if (size > kMaxMessage) {
+        sendMessage(client, kError, "mensaje demasiado grande: " +
+                                        to_string(size) + " bytes");
+        return;
+      }
+      body.resize(size);
+      if (!recvBefore(client, &body[0], size, deadline))
+        return;
+      bool ok = tag == kCompile && compile(body, out);
+      if (tag != kCompile)
+        out = "pedido desconocido";
+      else if (ok && out.size() > kMaxMessage) {
+        ok = false;
+        out = "assembly demasiado grande: " + to_string(out.size()) + " bytes";
+      }
+      if (!sendMessage(client, ok ? kOk : kError, out))
+        return;
+    }
+  } catch (const bad_alloc &) {
+    sendMessage(client, kError, "sin memoria para el pedido");
+  } catch (const length_error &) {
+    sendMessage(client, kError, "sin memoria para el pedido");
+  }
+}
+
+bool CompileServer::compile(string_view source, string &out) {
+  requests_++;
+  uint64_t key = AsmCache::key(source, "O0");
+  if (auto it = cache.find(key); it != cache.end()) {
+    hits_++;
+    out = it->second;
+    return true;
+  }
+
+  try {
+    Scanner scanner(source);
+    if (!arena)
+      arena.reset(new Arena());
+    Parser parser(&scanner, false, move(arena));
+    Program *prog;
+    try {
+      prog = parser.parseProgram();
+    } catch (...) {
+      // Lo parseado hasta el error se descarta; la arena se conserva
+      arena = parser.takeArena();
+      arena->reset();
+      throw;
+    }
+    unique_ptr<Program> owner(prog);
+    // La arena vuelve al servidor (vacía) antes de borrar el Program
+    auto reclaim = [&]() {
+      arena.reset(prog->arena);
+      prog->arena = nullptr;
+      arena->reset();
+    };
+    stringstream code;
+    try {
+      Resolver().resolve(prog);
+      TypeChecker().check(prog);
+      GenCodeVisitor<stringstream>(code).generate(prog);
+    } catch (...) {
+      reclaim();
+      throw;
+    }
+    reclaim();
+    out = code.str();
+  } catch (const exception &e) {
+    out = e.what();
+    return false;
+  }
+
+  if (cacheBytes + out.size() > kCacheBytes) {
+    cache.clear();
+    cacheBytes = 0;
+  }
+  cache.emplace(key, out);
+  cacheBytes += out.size();
+  return true;
+}
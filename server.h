@@ -0,0 +1,127 @@
+// server.h
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "arena.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <unordered_map>
+
+// Servidor de compilación: un proceso de larga vida (kotlin --serve SOCKET)
+// que escucha en un socket Unix, recibe el texto de un fuente y devuelve el
+// assembly o los errores. Ahorra lo que cuesta arrancar un proceso por
+// archivo y deja "calientes" entre pedidos la arena del AST (se reusa con
+// Arena::reset), las tablas de símbolos y de tipos, y una caché en memoria
+// de assembly por contenido (la clave es la de AsmCache).
+//
+// Protocolo: cada mensaje, en los dos sentidos, es
+//   uint8 tag | uint64 largo (orden de la máquina) | largo bytes
+// El cliente manda tag kCompile con el fuente; el servidor contesta kOk con
+// el assembly o kError con los mensajes de error. Una conexión puede mandar
+// varios pedidos, uno después de otro, hasta cerrar su lado.
+//
+// Las conexiones se atienden de a una; lo que paraleliza es la generación
+// por funciones de GenCodeVisitor. Por eso cada mensaje tiene que llegar
+// entero en unos segundos (y el cliente tiene que leer la respuesta): si
+// no, el servidor corta esa conexión y pasa a la siguiente. Una conexión
+// quieta entre pedidos también se corta.
+enum : uint8_t { kCompile = 0, kOk = 0, kError = 1 };
+
+// Lectura/escritura completas sobre un socket (también las usa el cliente,
+// que no enlaza nada del compilador). false si el otro lado se cerró
+inline bool sendAll(int fd, const void *data, size_t n) {
+  const char *p = static_cast<const char *>(data);
+  while (n > 0) {
+    ssize_t k = send(fd, p, n, MSG_NOSIGNAL);
+    if (k <= 0)
+      return false;
+    p += k, n -= k;
+  }
+  return true;
+}
+
+inline bool recvAll(int fd, void *data, size_t n) {
+  char *p = static_cast<char *>(data);
+  while (n > 0) {
+    ssize_t k = recv(fd, p, n, 0);
+    if (k <= 0)
+      return false;
+    p += k, n -= k;
+  }
+  return true;
+}
+
+inline bool sendMessage(int fd, uint8_t tag, std::string_view body) {
+  char head[9];
+  uint64_t size = body.size();
+  head[0] = char(tag);
+  memcpy(head + 1, &size, 8);
+  return sendAll(fd, head, sizeof(head)) &&
+         sendAll(fd, body.data(), body.size());
+}
+
+// Ningún mensaje puede pasar de esto: el largo lo manda el otro lado y no
+// se reserva memoria a ciegas. Un fuente o un .s de 64 MB ya no es normal
+const uint64_t kMaxMessage = 64 << 20;
+
+inline bool recvHeader(int fd, uint8_t &tag, uint64_t &size) {
+  char head[9];
+  if (!recvAll(fd, head, sizeof(head)))
+    return false;
+  tag = uint8_t(head[0]);
+  memcpy(&size, head + 1, 8);
+  return true;
+}
+
+// false también si el mensaje pasa de kMaxMessage (la conexión queda
+// inservible: no se leyó el cuerpo)
+inline bool recvMessage(int fd, uint8_t &tag, std::string &body) {
+  uint64_t size;
+  if (!recvHeader(fd, tag, size) || size > kMaxMessage)
+    return false;
+  body.resize(size);
+  return recvAll(fd, &body[0], size);
+}
+
+class CompileServer {
+public:
+  explicit CompileServer(std::string path);
+  ~CompileServer(); // cierra el socket y borra su archivo
+  CompileServer(const CompileServer &) = delete;
+  CompileServer &operator=(const CompileServer &) = delete;
+
+  // Crea el socket y empieza a escuchar; false con el motivo en 'error'
+  bool listen(std::string &error);
+  // Atiende conexiones hasta stop()
+  void serve();
+  // Se puede llamar desde otro hilo o desde un manejador de señales
+  void stop();
+
+  // Un pedido: true y el assembly en 'out', o false y los errores
+  bool compile(std::string_view source, std::string &out);
+
+  size_t requests() const { return requests_; }
+  size_t cacheHits() const { return hits_; }
+
+private:
+  void handle(int client);
+
+  std::string path;
+  int fd = -1;
+  std::atomic<bool> stopping{false};
+  std::unique_ptr<Arena> arena; // se reusa de un pedido al siguiente
+  // clave de AsmCache -> assembly; se vacía al pasar de kCacheBytes
+  static const size_t kCacheBytes = 64 << 20;
+  std::unordered_map<uint64_t, std::string> cache;
+  size_t cacheBytes = 0;
+  size_t requests_ = 0, hits_ = 0;
+};
+
+#endif // SERVER_H
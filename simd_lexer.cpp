@@ -0,0 +1,223 @@
+// simd_lexer.cpp
+#include "simd_lexer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMDLEX_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace simdlex {
+
+// --- Versión escalar (tabla de clases) ---
+
+static const char *skipSpacesScalar(const char *p, const char *end) {
+  while (p < end && charclass::isSpace(*p))
+    p++;
+  return p;
+}
+
+static const char *identEndScalar(const char *p, const char *end) {
+  while (p < end && charclass::isIdent(*p))
+    p++;
+  return p;
+}
+
+static const char *findQuoteScalar(const char *p, const char *end) {
+  while (p < end && *p != '"')
+    p++;
+  return p;
+}
+
+#ifdef SIMDLEX_X86
+
+// Cada función procesa bloques completos y deja la cola a la versión escalar.
+// Las máscaras marcan con 1 los bytes que *terminan* la búsqueda.
+
+// --- SSE2 (16 bytes) ---
+
+static inline __m128i spaceMask16(__m128i v) {
+  __m128i sp = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  __m128i nl = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+  __m128i cr = _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'));
+  __m128i tb = _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'));
+  return _mm_or_si128(_mm_or_si128(sp, nl), _mm_or_si128(cr, tb));
+}
+
+// Rango [lo, hi] con comparación con signo: los bytes >= 0x80 son negativos
+// y quedan fuera, igual que en la tabla escalar.
+static inline __m128i inRange16(__m128i v, char lo, char hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                       _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+static inline __m128i identMask16(__m128i v) {
+  __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20)); // 'A' -> 'a'
+  __m128i alpha = inRange16(lower, 'a', 'z');
+  __m128i digit = inRange16(v, '0', '9');
+  __m128i under = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+  return _mm_or_si128(_mm_or_si128(alpha, digit), under);
+}
+
+static const char *skipSpacesSSE2(const char *p, const char *end) {
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    unsigned stop = ~_mm_movemask_epi8(spaceMask16(v)) & 0xFFFFu;
+    if (stop)
+      return p + __builtin_ctz(stop);
+    p += 16;
+  }
+  return skipSpacesScalar(p, end);
+}
+
+static const char *identEndSSE2(const char *p, const char *end) {
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    unsigned stop = ~_mm_movemask_epi8(identMask16(v)) & 0xFFFFu;
+    if (stop)
+      return p + __builtin_ctz(stop);
+    p += 16;
+  }
+  return identEndScalar(p, end);
+}
+
+static const char *findQuoteSSE2(const char *p, const char *end) {
+  const __m128i quote = _mm_set1_epi8('"');
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    unsigned stop = _mm_movemask_epi8(_mm_cmpeq_epi8(v, quote));
+    if (stop)
+      return p + __builtin_ctz(stop);
+    p += 16;
+  }
+  return findQuoteScalar(p, end);
+}
+
+// --- AVX2 (32 bytes) ---
+
+#define SIMDLEX_AVX2 __attribute__((target("avx2")))
+
+SIMDLEX_AVX2 static inline __m256i spaceMask32(__m256i v) {
+  __m256i sp = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+  __m256i nl = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+  __m256i cr = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'));
+  __m256i tb = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'));
+  return _mm256_or_si256(_mm256_or_si256(sp, nl), _mm256_or_si256(cr, tb));
+}
+
+SIMDLEX_AVX2 static inline __m256i inRange32(__m256i v, char lo, char hi) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+SIMDLEX_AVX2 static inline __m256i identMask32(__m256i v) {
+  __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+  __m256i alpha = inRange32(lower, 'a', 'z');
+  __m256i digit = inRange32(v, '0', '9');
+  __m256i under = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+  return _mm256_or_si256(_mm256_or_si256(alpha, digit), under);
+}
+
+SIMDLEX_AVX2 static const char *skipSpacesAVX2(const char *p,
+                                               const char *end) {
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    unsigned stop = ~(unsigned)_mm256_movemask_epi8(spaceMask32(v));
+    if (stop)
+      return p + __builtin_ctz(stop);
+    p += 32;
+  }
+  return skipSpacesSSE2(p, end);
+}
+
+SIMDLEX_AVX2 static const char *identEndAVX2(const char *p, const char *end) {
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    unsigned stop = ~(unsigned)_mm256_movemask_epi8(identMask32(v));
+    if (stop)
+      return p + __builtin_ctz(stop);
+    p += 32;
+  }
+  return identEndSSE2(p, end);
+}
+
+SIMDLEX_AVX2 static const char *findQuoteAVX2(const char *p,
+                                              const char *end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  while (end - p >= 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    __m256i eq = _mm256_cmpeq_epi8(v, quote);
+    unsigned stop = (unsigned)_mm256_movemask_epi8(eq);
+    if (stop)
+      return p + __builtin_ctz(stop);
+    p += 32;
+  }
+  return findQuoteSSE2(p, end);
+}
+
+#endif // SIMDLEX_X86
+
+// --- Dispatch ---
+
+struct Impl {
+  Level level;
+  const char *(*skipSpaces)(const char *, const char *);
+  const char *(*identEnd)(const char *, const char *);
+  const char *(*findQuote)(const char *, const char *);
+};
+
+static Impl implFor(Level l) {
+#ifdef SIMDLEX_X86
+  if (l == AVX2)
+    return {AVX2, skipSpacesAVX2, identEndAVX2, findQuoteAVX2};
+  if (l == SSE2)
+    return {SSE2, skipSpacesSSE2, identEndSSE2, findQuoteSSE2};
+#endif
+  return {SCALAR, skipSpacesScalar, identEndScalar, findQuoteScalar};
+}
+
+Level detect() {
+#ifdef SIMDLEX_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return AVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return SSE2;
+#endif
+  return SCALAR;
+}
+
+static Impl impl = implFor(detect());
+
+Level level() { return impl.level; }
+
+void setLevel(Level l) {
+  Level best = detect();
+  impl = implFor(l > best ? best : l);
+}
+
+const char *levelName(Level l) {
+  switch (l) {
+  case AVX2:
+    return "avx2";
+  case SSE2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
+
+const char *skipSpacesWide(const char *p, const char *end) {
+  return impl.skipSpaces(p, end);
+}
+
+const char *identEndWide(const char *p, const char *end) {
+  return impl.identEnd(p, end);
+}
+
+const char *findQuoteWide(const char *p, const char *end) {
+  return impl.findQuote(p, end);
+}
+
+} // namespace simdlex
@@ -0,0 +1,94 @@
+// simd_lexer.h
+#ifndef SIMD_LEXER_H
+#define SIMD_LEXER_H
+
+// Rutinas rápidas para el Scanner: saltar espacios, encontrar el final de un
+// identificador y la comilla de cierre de un string de 16 en 16 (SSE2) o de
+// 32 en 32 (AVX2) bytes. El nivel se elige en tiempo de ejecución según la CPU
+// y siempre existe la versión escalar, que usa la tabla de clases de abajo.
+
+namespace charclass {
+
+enum : unsigned char {
+  SPACE = 1, // ' ', '\n', '\r', '\t'
+  DIGIT = 2, // 0-9
+  ALPHA = 4, // a-z, A-Z
+  IDENT = 8, // a-z, A-Z, 0-9, '_'
+};
+
+struct Table {
+  unsigned char cls[256];
+};
+
+constexpr Table buildTable() {
+  Table t{};
+  t.cls[(unsigned char)' '] = SPACE;
+  t.cls[(unsigned char)'\n'] = SPACE;
+  t.cls[(unsigned char)'\r'] = SPACE;
+  t.cls[(unsigned char)'\t'] = SPACE;
+  for (int c = '0'; c <= '9'; c++)
+    t.cls[c] = DIGIT | IDENT;
+  for (int c = 'a'; c <= 'z'; c++)
+    t.cls[c] = ALPHA | IDENT;
+  for (int c = 'A'; c <= 'Z'; c++)
+    t.cls[c] = ALPHA | IDENT;
+  t.cls[(unsigned char)'_'] = IDENT;
+  return t;
+}
+
+// A diferencia de isalpha/isalnum no depende del locale
+inline constexpr Table table = buildTable();
+
+inline bool isSpace(char c) { return table.cls[(unsigned char)c] & SPACE; }
+inline bool isDigit(char c) { return table.cls[(unsigned char)c] & DIGIT; }
+inline bool isAlpha(char c) { return table.cls[(unsigned char)c] & ALPHA; }
+inline bool isIdent(char c) { return table.cls[(unsigned char)c] & IDENT; }
+
+} // namespace charclass
+
+namespace simdlex {
+
+enum Level { SCALAR, SSE2, AVX2 };
+
+// Mejor nivel que soporta la CPU actual
+Level detect();
+// Nivel en uso (por defecto detect()). setLevel lo limita a lo soportado;
+// sirve para comparar implementaciones en el benchmark.
+Level level();
+void setLevel(Level l);
+const char *levelName(Level l);
+
+// Versiones vectoriales (según level()). Devuelven un puntero en [p, end] y
+// nunca leen más allá de 'end'.
+const char *skipSpacesWide(const char *p, const char *end);
+const char *identEndWide(const char *p, const char *end);
+const char *findQuoteWide(const char *p, const char *end);
+
+// Las rachas cortas (lo normal) se resuelven en línea con la tabla; sólo si
+// pasan de kInlineBytes se paga la llamada a la versión vectorial.
+constexpr int kInlineBytes = 8;
+
+inline const char *skipSpaces(const char *p, const char *end) {
+  for (int i = 0; i < kInlineBytes; i++, p++)
+    if (p >= end || !charclass::isSpace(*p))
+      return p;
+  return skipSpacesWide(p, end);
+}
+
+inline const char *identEnd(const char *p, const char *end) {
+  for (int i = 0; i < kInlineBytes; i++, p++)
+    if (p >= end || !charclass::isIdent(*p))
+      return p;
+  return identEndWide(p, end);
+}
+
+inline const char *findQuote(const char *p, const char *end) {
+  for (int i = 0; i < kInlineBytes; i++, p++)
+    if (p >= end || *p == '"')
+      return p;
+  return findQuoteWide(p, end);
+}
+
+} // namespace simdlex
+
+#endif // SIMD_LEXER_H
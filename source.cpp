@@ -0,0 +1,50 @@
+// source.cpp
+#include "source.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+SourceFile::SourceFile() : data(nullptr), size(0), mapped(false) {}
+
+SourceFile::~SourceFile() { close(); }
+
+bool SourceFile::open(const string &path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  // mmap no admite longitud 0: un archivo vacío es simplemente texto vacío
+  if (st.st_size > 0) {
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+    // el Scanner lo recorre una sola vez de principio a fin
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    data = static_cast<const char *>(p);
+    size = st.st_size;
+    mapped = true;
+  }
+  // el mapeo sigue siendo válido después de cerrar el descriptor
+  ::close(fd);
+  return true;
+}
+
+void SourceFile::close() {
+  if (mapped)
+    munmap(const_cast<char *>(data), size);
+  data = nullptr;
+  size = 0;
+  mapped = false;
+}
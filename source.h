@@ -0,0 +1,29 @@
+// source.h
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <string>
+#include <string_view>
+
+// Archivo fuente mapeado en memoria (solo lectura). El Scanner trabaja
+// directamente sobre text(), así que leer un archivo no copia su contenido.
+class SourceFile {
+public:
+    SourceFile();
+    ~SourceFile();
+    SourceFile(const SourceFile &) = delete;
+    SourceFile &operator=(const SourceFile &) = delete;
+
+    // Mapea 'path'; devuelve false si no se pudo abrir o mapear
+    bool open(const std::string &path);
+    void close();
+
+    std::string_view text() const { return std::string_view(data, size); }
+
+private:
+    const char *data;
+    size_t size;
+    bool mapped;
+};
+
+#endif // SOURCE_H
@@ -0,0 +1,46 @@
+// streaming.cpp
+#include "streaming.h"
+#include "arena.h"
+#include "parser.h"
+#include "resolver.h"
+#include "scanner.h"
+#include "typecheck.h"
+#include "visitor.h"
+#include <algorithm>
+#include <memory>
+
+using namespace std;
+
+StreamStats compileStreaming(string_view source, ostream &out) {
+  StreamStats stats;
+  Scanner scanner(source);
+  Parser parser(&scanner, false);
+
+  // 1) globales y clases; 2) firmas, en una arena que vive hasta el final
+  unique_ptr<Program> prog(parser.parseHeader());
+  Parser::Mark functions = parser.mark();
+  while (FunDec *sig = parser.parseSignature())
+    prog->funDecs->add(sig);
+  unique_ptr<Arena> signatures = parser.takeArena();
+  stats.headerBytes = prog->arena->bytesUsed() + signatures->bytesUsed();
+
+  Resolver resolver;
+  TypeChecker checker;
+  GenCodeVisitor<ostream> gen(out);
+  resolver.begin(prog.get());
+  checker.begin(prog.get());
+  gen.beginProgram(prog.get());
+
+  // 3) una función por vez; su arena se libera al terminar la vuelta
+  parser.reset(functions);
+  while (FunDec *fn = parser.parseFunction()) {
+    unique_ptr<Arena> nodes = parser.takeArena();
+    resolver.resolveFunction(fn);
+    checker.checkFunction(fn);
+    gen.emitFunction(fn);
+    stats.functions++;
+    stats.maxFunctionBytes = max(stats.maxFunctionBytes, nodes->bytesUsed());
+  }
+  gen.endProgram();
+  return stats;
+}
@@ -0,0 +1,33 @@
+// streaming.h
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+
+// Compilación por partes para programas generados muy grandes. En vez de
+// armar el Program entero y generar todo el ensamblador en memoria:
+//   1) se parsean globales y clases (Parser::parseHeader);
+//   2) se leen sólo las firmas de todas las funciones, salteando los
+//      cuerpos, para que una llamada pueda ir a una función declarada más
+//      abajo (Resolver y TypeChecker necesitan sus parámetros y su tipo);
+//   3) se vuelve al comienzo de las funciones y cada una se parsea en su
+//      propia arena, se resuelve, se chequea, se genera, se escribe en
+//      'out' y se libera antes de leer la siguiente.
+// La memoria máxima queda en el encabezado más la función más grande, no en
+// el programa completo. La salida es ensamblador equivalente al de
+// GenCodeVisitor::generate (los literales de cada función van en una
+// sección .data propia).
+//
+// Lanza runtime_error ante errores de sintaxis o de tipos; lo ya escrito en
+// 'out' queda incompleto.
+struct StreamStats {
+  size_t functions = 0;
+  size_t headerBytes = 0;      // arena de globales, clases y firmas
+  size_t maxFunctionBytes = 0; // arena de la función más grande
+};
+
+StreamStats compileStreaming(std::string_view source, std::ostream &out);
+
+#endif // STREAMING_H
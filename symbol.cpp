@@ -0,0 +1,107 @@
+// symbol.cpp
+#include "symbol.h"
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+// Los textos se guardan en bloques de tamaño fijo que nunca se mueven, así
+// str() puede leerlos sin tomar el lock: quien tiene un id lo obtuvo de
+// intern(), que publicó el texto antes de devolverlo.
+const uint32_t kBlockBits = 12;
+const uint32_t kBlockSize = 1u << kBlockBits;
+const uint32_t kMaxBlocks = 1u << 14; // hasta 64M símbolos
+
+// Deben coincidir con las constantes de sym:: en symbol.h
+const char *const kPredefined[] = {
+    "",           "it",          "main",          "print",
+    "println",    "arrayOf",     "intArrayOf",    "longArrayOf",
+    "doubleArrayOf", "booleanArrayOf", "listOf", "mutableListOf",
+    "String",     "Int",         "Long",          "Double",
+    "Boolean",    "Unit",
+};
+
+class Interner {
+public:
+  Interner() {
+    for (const char *name : kPredefined)
+      insert(name);
+  }
+
+  uint32_t intern(string_view name) {
+    lock_guard<mutex> lock(mtx);
+    auto it = ids.find(name);
+    if (it != ids.end())
+      return it->second;
+    return insert(name);
+  }
+
+  const string &str(uint32_t id) const {
+    return blocks[id >> kBlockBits].load(memory_order_acquire)
+        [id & (kBlockSize - 1)];
+  }
+
+  size_t count() {
+    lock_guard<mutex> lock(mtx);
+    return next;
+  }
+
+private:
+  // Requiere el lock (o estar en el constructor)
+  uint32_t insert(string_view name) {
+    uint32_t id = next;
+    uint32_t b = id >> kBlockBits;
+    if (b >= kMaxBlocks)
+      throw runtime_error("Demasiados símbolos distintos");
+    string *block = blocks[b].load(memory_order_relaxed);
+    if (!block) {
+      block = new string[kBlockSize];
+      blocks[b].store(block, memory_order_release);
+    }
+    string &slot = block[id & (kBlockSize - 1)];
+    slot.assign(name.data(), name.size());
+    // la clave apunta al texto ya guardado, que no se mueve
+    ids.emplace(string_view(slot), id);
+    next++;
+    return id;
+  }
+
+  mutex mtx;
+  unordered_map<string_view, uint32_t> ids;
+  atomic<string *> blocks[kMaxBlocks] = {};
+  uint32_t next = 0;
+};
+
+Interner &interner() {
+  static Interner *table = new Interner(); // vive hasta el final del proceso
+  return *table;
+}
+
+} // namespace
+
+// Caché por hilo delante del mapa: los nombres se repiten mucho en un mismo
+// archivo y así la mayoría de búsquedas no toman el lock.
+Symbol Symbol::intern(string_view name) {
+  struct Entry {
+    string_view text; // apunta al texto guardado en la tabla
+    uint32_t id;
+  };
+  static thread_local Entry cache[256];
+
+  Entry &e = cache[hash<string_view>()(name) & 255];
+  if (e.text.size() == name.size() && e.text == name)
+    return Symbol(e.id);
+  uint32_t id = interner().intern(name);
+  e = {interner().str(id), id};
+  return Symbol(id);
+}
+
+const string &Symbol::str() const { return interner().str(id_); }
+
+size_t Symbol::count() { return interner().count(); }
+
+ostream &operator<<(ostream &outs, Symbol s) { return outs << s.str(); }
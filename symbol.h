@@ -0,0 +1,67 @@
+// symbol.h
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Identificador internado: cada nombre distinto del programa se guarda una
+// sola vez en una tabla global y se representa con un id de 32 bits. Comparar
+// o usar un Symbol como clave de un mapa es trabajar con un entero.
+// La tabla es compartida por todos los hilos y nunca se vacía.
+class Symbol {
+public:
+  constexpr Symbol() : id_(0) {} // símbolo vacío ""
+  constexpr explicit Symbol(uint32_t id) : id_(id) {}
+
+  static Symbol intern(std::string_view name);
+
+  constexpr uint32_t id() const { return id_; }
+  const std::string &str() const;
+  bool empty() const { return id_ == 0; }
+
+  constexpr bool operator==(Symbol o) const { return id_ == o.id_; }
+  constexpr bool operator!=(Symbol o) const { return id_ != o.id_; }
+  constexpr bool operator<(Symbol o) const { return id_ < o.id_; }
+
+  // Cantidad de símbolos distintos internados hasta ahora
+  static size_t count();
+
+private:
+  uint32_t id_;
+};
+
+std::ostream &operator<<(std::ostream &outs, Symbol s);
+
+namespace std {
+template <> struct hash<Symbol> {
+  size_t operator()(Symbol s) const noexcept { return s.id(); }
+};
+} // namespace std
+
+// Nombres que el compilador usa directamente. Se internan al arrancar en
+// este mismo orden, así que sus ids son constantes (ver symbol.cpp).
+namespace sym {
+constexpr Symbol it{1};
+constexpr Symbol main{2};
+constexpr Symbol print{3};
+constexpr Symbol println{4};
+constexpr Symbol arrayOf{5};
+constexpr Symbol intArrayOf{6};
+constexpr Symbol longArrayOf{7};
+constexpr Symbol doubleArrayOf{8};
+constexpr Symbol booleanArrayOf{9};
+constexpr Symbol listOf{10};
+constexpr Symbol mutableListOf{11};
+constexpr Symbol String{12};
+constexpr Symbol Int{13};
+constexpr Symbol Long{14};
+constexpr Symbol Double{15};
+constexpr Symbol Boolean{16};
+constexpr Symbol Unit{17};
+} // namespace sym
+
+#endif // SYMBOL_H
@@ -0,0 +1,155 @@
+// timing.cpp
+#include "timing.h"
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+
+using namespace std;
+
+namespace {
+
+atomic<Trace *> activeTrace{nullptr};
+
+int64_t nanos(clockid_t clock) {
+  timespec ts;
+  clock_gettime(clock, &ts);
+  return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Hilos numerados en el orden en que registran su primer evento
+unsigned threadId() {
+  static atomic<unsigned> next{1};
+  thread_local unsigned id = next.fetch_add(1);
+  return id;
+}
+
+void putJsonString(ostream &out, string_view s) {
+  out << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      out << '\\' << c;
+    else if ((unsigned char)c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out << buf;
+    } else
+      out << c;
+  }
+  out << '"';
+}
+
+// 'name' seguido de espacios hasta 'width' columnas; setw cuenta bytes y
+// los nombres de fase tienen acentos
+string padded(string_view name, size_t width) {
+  size_t columns = 0;
+  for (char c : name)
+    columns += ((unsigned char)c & 0xC0) != 0x80;
+  return string(name) + string(width > columns ? width - columns : 0, ' ');
+}
+
+} // namespace
+
+// ── TimeReport ──
+
+void TimeReport::add(string_view phase, double wall, double cpu) {
+  for (auto &p : phases)
+    if (p.first == phase) {
+      p.second.wall += wall;
+      p.second.cpu += cpu;
+      return;
+    }
+  phases.push_back({string(phase), {wall, cpu}});
+}
+
+void TimeReport::print(ostream &out, string_view file) const {
+  PhaseTime total;
+  for (auto &p : phases) {
+    total.wall += p.second.wall;
+    total.cpu += p.second.cpu;
+  }
+  auto row = [&](string_view name, const PhaseTime &t) {
+    out << "  " << padded(name, 12) << fixed
+        << setprecision(3) << setw(10) << t.wall * 1e3 << setw(10)
+        << t.cpu * 1e3 << setw(6) << setprecision(0)
+        << (total.wall > 0 ? 100 * t.wall / total.wall : 0) << "%\n";
+  };
+  ios::fmtflags flags = out.flags();
+  streamsize precision = out.precision();
+  out << "Tiempos de " << file << ":\n"
+      << "  " << padded("fase", 12) << setw(10)
+      << "pared(ms)" << setw(10) << "CPU(ms)" << setw(7) << "%" << "\n";
+  for (auto &p : phases)
+    row(p.first, p.second);
+  row("total", total);
+  out.flags(flags);
+  out.precision(precision);
+}
+
+// ── Trace ──
+
+Trace::Trace() : origin(nanos(CLOCK_MONOTONIC)) {}
+
+Trace *Trace::active() { return activeTrace.load(memory_order_acquire); }
+
+void Trace::setActive(Trace *trace) {
+  activeTrace.store(trace, memory_order_release);
+}
+
+uint64_t Trace::now() const {
+  return uint64_t(nanos(CLOCK_MONOTONIC) - origin) / 1000;
+}
+
+void Trace::add(string_view name, const char *cat, uint64_t startUs,
+                uint64_t durUs) {
+  unsigned tid = threadId();
+  lock_guard<mutex> lock(eventsMutex);
+  events.push_back({string(name), cat, startUs, durUs, tid});
+}
+
+bool Trace::write(const string &path) const {
+  ofstream out(path, ios::binary);
+  lock_guard<mutex> lock(eventsMutex);
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  for (size_t i = 0; i < events.size(); i++) {
+    const Event &e = events[i];
+    out << (i ? ",\n" : "\n") << "{\"name\": ";
+    putJsonString(out, e.name);
+    out << ", \"cat\": ";
+    putJsonString(out, e.cat);
+    out << ", \"ph\": \"X\", \"ts\": " << e.start << ", \"dur\": " << e.dur
+        << ", \"pid\": 1, \"tid\": " << e.tid << "}";
+  }
+  out << "\n]}\n";
+  out.close();
+  return bool(out);
+}
+
+// ── Span ──
+
+Span::Span(string_view name, const char *cat, TimeReport *report)
+    : cat(cat), report(report), trace(Trace::active()),
+      running(report || trace) {
+  if (!running)
+    return;
+  this->name = name;
+  if (trace)
+    traceStart = trace->now();
+  wall0 = nanos(CLOCK_MONOTONIC);
+  cpu0 = nanos(CLOCK_THREAD_CPUTIME_ID);
+}
+
+PhaseTime Span::end() {
+  if (!running)
+    return {};
+  running = false;
+  PhaseTime t;
+  t.cpu = (nanos(CLOCK_THREAD_CPUTIME_ID) - cpu0) * 1e-9;
+  t.wall = (nanos(CLOCK_MONOTONIC) - wall0) * 1e-9;
+  if (report)
+    report->add(name, t.wall, t.cpu);
+  if (trace)
+    trace->add(name, cat, traceStart, trace->now() - traceStart);
+  return t;
+}
@@ -0,0 +1,88 @@
+// timing.h
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Medición de tiempos por fase, al estilo de -ftime-report, y trazas en el
+// formato trace_event de Chrome (se abren con chrome://tracing o Perfetto).
+//
+// Un Span mide un tramo: tiempo de pared y CPU del hilo que lo corre (el
+// CPU de los hilos que generan funciones en paralelo no entra en la fase
+// codegen del que los lanzó; en la traza se ven aparte). Al
+// terminar suma su fase a un TimeReport (si se le pasó uno) y agrega un
+// evento a la traza activa (si hay). Sin reporte ni traza no hace nada, así
+// que los que quedan en el código (p. ej. uno por función en
+// GenCodeVisitor) no cuestan nada en una compilación normal.
+
+struct PhaseTime {
+  double wall = 0, cpu = 0; // segundos
+};
+
+// Tiempos de un archivo, por fase en el orden en que aparecieron. Lo usa un
+// solo hilo
+class TimeReport {
+public:
+  void add(std::string_view phase, double wall, double cpu);
+  // Tabla con pared, CPU y porcentaje de cada fase, y el total
+  void print(std::ostream &out, std::string_view file) const;
+
+private:
+  std::vector<std::pair<std::string, PhaseTime>> phases;
+};
+
+// Eventos de una corrida; compartida por todos los hilos
+class Trace {
+public:
+  Trace();
+  // La traza donde escriben los Span; nullptr (lo normal) no guarda nada
+  static Trace *active();
+  static void setActive(Trace *trace);
+
+  void add(std::string_view name, const char *cat, uint64_t startUs,
+           uint64_t durUs);
+  // JSON {"traceEvents": [...]} con un evento "X" (completo) por Span
+  bool write(const std::string &path) const;
+
+  // Microsegundos desde que se creó la traza
+  uint64_t now() const;
+
+private:
+  struct Event {
+    std::string name;
+    const char *cat;
+    uint64_t start, dur;
+    unsigned tid;
+  };
+  mutable std::mutex eventsMutex;
+  std::vector<Event> events;
+  int64_t origin; // ns de CLOCK_MONOTONIC
+};
+
+class Span {
+public:
+  Span(std::string_view name, const char *cat, TimeReport *report = nullptr);
+  ~Span() { end(); }
+  Span(const Span &) = delete;
+  Span &operator=(const Span &) = delete;
+
+  // Termina antes del destructor; devuelve lo medido (cero si no medía)
+  PhaseTime end();
+
+private:
+  std::string name;
+  const char *cat;
+  TimeReport *report;
+  Trace *trace;
+  bool running;
+  int64_t wall0, cpu0; // ns
+  uint64_t traceStart;
+};
+
+#endif // TIMING_H
@@ -4,20 +4,6 @@
 
 using namespace std;
 
-// --- constructores ---
-
-Token::Token(Type type)
-  : type(type), text("") {}
-
-Token::Token(Type type, char c)
-  : type(type), text(string(1, c)) {}
-
-Token::Token(Type type, const string &source, int first, int last)
-  : type(type)
-{
-    text = source.substr(first, last - first);
-}
-
 // --- operadores de salida ---
 
 ostream& operator<<(ostream &outs, const Token &tok) {
@@ -70,12 +56,21 @@ ostream& operator<<(ostream &outs, const Token &tok) {
         case Token::STEP:outs << "TOKEN(STEP)"; break;
 
         case Token::CLASS:outs << "TOKEN(CLASS)"; break;
+        case Token::PRINTLN:outs << "TOKEN(PRINTLN)"; break;
+        case Token::IN:outs << "TOKEN(IN)"; break;
+
+        case Token::INTARRAY:
+        case Token::DOUBLEARRAY:
+        case Token::ARRAY:
+        case Token::ARRAYOF:
+        case Token::INTARRAYOF:
+        case Token::LONGARRAYOF:
+        case Token::DOUBLEARRAYOF:
+        case Token::BOOLEANARRAYOF:
+        case Token::LISTOF:
+        case Token::MUTABLELISTOF:outs << "TOKEN(BUILTIN," << tok.text << ")"; break;
 
         default:outs << "TOKEN(UNKNOWN)"; break;
     }
     return outs;
 }
-
-ostream& operator<<(ostream &outs, const Token *tok) {
-    return outs << *tok;
-}
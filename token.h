@@ -2,8 +2,9 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
-#include <string>
+#include <string_view>
 #include <ostream>
+#include "symbol.h"
 
 class Token {
 public:
@@ -25,19 +26,30 @@ public:
         DOT, DOTDOT,        // '.' , '..'
         DOWNTO, STEP,
         CLASS,
+        PRINTLN, IN,
+        // nombres built-in (se reconocen en el scanner, no son ID)
+        INTARRAY, DOUBLEARRAY, ARRAY,                    // IntArray(n) { ... }
+        ARRAYOF, INTARRAYOF, LONGARRAYOF, DOUBLEARRAYOF, // xxxArrayOf(...)
+        BOOLEANARRAYOF, LISTOF, MUTABLELISTOF,
+        COUNT              // cantidad de tipos (tamaño de las tablas por tipo)
     };
 
-    Type        type;
-    std::string text;
+    // El token se devuelve por valor: 'text' es un span (puntero + longitud)
+    // sobre el buffer del Scanner, así que no hay copias ni memoria dinámica.
+    // Sólo es válido mientras viva ese buffer (el archivo mapeado, etc.).
+    Type             type;
+    Symbol           sym;     // ID: nombre ya internado en el scanner
+    std::string_view text;
+    long long        value;   // NUM: literal ya decodificado (parte entera)
 
     // constructores
-    Token(Type type);
-    Token(Type type, char c);
-    Token(Type type, const std::string &source, int first, int last);
+    Token() : type(END), value(0) {}
+    explicit Token(Type type) : type(type), value(0) {}
+    Token(Type type, std::string_view text, long long value = 0)
+      : type(type), text(text), value(value) {}
 
     // impresión
     friend std::ostream &operator<<(std::ostream &outs, const Token &tok);
-    friend std::ostream &operator<<(std::ostream &outs, const Token *tok);
 };
 
 #endif // TOKEN_H
@@ -0,0 +1,400 @@
+// typecheck.cpp
+#include "typecheck.h"
+#include <stdexcept>
+
+using namespace std;
+
+// ── Tipos ──
+
+// Los numéricos se mezclan libremente (los literales grandes son Long) y
+// los arreglos y listas se comparan por su tipo de elemento
+bool TypeChecker::compatible(const Type *a, const Type *b) {
+  if (a == b || !a || !b)
+    return true;
+  if (a->isNumeric() && b->isNumeric())
+    return true;
+  const Type *ea = a->element(), *eb = b->element();
+  return ea && eb && compatible(ea, eb);
+}
+
+// ── Utilidades ──
+
+void TypeChecker::check(Program *prog) {
+  errors.clear();
+  accept(prog);
+  report();
+}
+
+void TypeChecker::begin(Program *prog) {
+  errors.clear();
+  visitGlobals(prog);
+  report();
+}
+
+void TypeChecker::checkFunction(FunDec *fn) {
+  accept(fn);
+  report();
+}
+
+void TypeChecker::report() {
+  if (errors.empty())
+    return;
+  string msg = "Errores de tipo:";
+  for (auto &e : errors)
+    msg += "\n  " + e;
+  throw runtime_error(msg);
+}
+
+const Type *TypeChecker::typeOf(Exp *e) {
+  e->type = accept(e);
+  return e->type;
+}
+
+const Type *&TypeChecker::slotType(const Binding &b) {
+  return b.isLocal() ? localTypes[b.slot] : globalTypes[b.slot];
+}
+
+void TypeChecker::expect(const Type *expected, const Type *found,
+                         const string &what) {
+  if (!compatible(expected, found))
+    error("se esperaba " + typeName(expected) + " pero se encontró " +
+          typeName(found) + " en " + what);
+}
+
+void TypeChecker::error(const string &msg) {
+  if (current)
+    errors.push_back("fun " + current->name.str() + ": " + msg);
+  else
+    errors.push_back(msg);
+}
+
+// ── Expresiones ──
+
+// Espina izquierda con un bucle (ver pushLeftSpine): el tipo de cada nivel
+// es el operando izquierdo del siguiente
+const Type *TypeChecker::visit(BinaryExp *exp) {
+  size_t base = spine.size();
+  const Type *l = typeOf(pushLeftSpine(exp, spine));
+  while (spine.size() > base) {
+    BinaryExp *b = spine.back();
+    spine.pop_back();
+    l = binaryType(b, l, typeOf(b->right));
+    if (spine.size() > base)
+      b->type = l; // el de exp lo anota typeOf
+  }
+  return l;
+}
+
+const Type *TypeChecker::binaryType(BinaryExp *exp, const Type *l,
+                                    const Type *r) {
+  string op = Exp::binopToChar(exp->op);
+  switch (exp->op) {
+  case PLUS_OP:
+    if (l == Type::String() || r == Type::String())
+      return Type::String();
+    [[fallthrough]];
+  case MINUS_OP:
+  case MUL_OP:
+  case DIV_OP:
+    if (!l || !r)
+      return l ? l : r;
+    if (!l->isNumeric() || !r->isNumeric()) {
+      error("'" + op + "' no aplica a " + l->str() + " y " + r->str());
+      return nullptr;
+    }
+    // el más ancho de los dos
+    if (l == Type::Double() || r == Type::Double())
+      return Type::Double();
+    return l == Type::Long() || r == Type::Long() ? Type::Long() : Type::Int();
+  case EQ_OP:
+    if (!compatible(l, r))
+      error("'" + op + "' compara " + l->str() + " con " + r->str());
+    return Type::Boolean();
+  default: // <, <=, >, >=
+    if ((l && !l->isNumeric()) || (r && !r->isNumeric()))
+      error("'" + op + "' no aplica a " + typeName(l) + " y " + typeName(r));
+    return Type::Boolean();
+  }
+}
+
+const Type *TypeChecker::visit(IFExp *exp) {
+  typeOf(exp->cond);
+  const Type *l = typeOf(exp->left);
+  const Type *r = typeOf(exp->right);
+  expect(l, r, "las ramas de if");
+  return l ? l : r;
+}
+
+const Type *TypeChecker::visit(StringExp *) { return Type::String(); }
+
+const Type *TypeChecker::visit(NumberExp *exp) {
+  return exp->value > INT32_MAX || exp->value < INT32_MIN ? Type::Long()
+                                                          : Type::Int();
+}
+
+const Type *TypeChecker::visit(BoolExp *) { return Type::Boolean(); }
+
+const Type *TypeChecker::visit(IdentifierExp *exp) {
+  if (!exp->bind.resolved()) {
+    error("variable no declarada: " + exp->name.str());
+    return nullptr;
+  }
+  return slotType(exp->bind);
+}
+
+const Type *TypeChecker::visit(FCallExp *exp) {
+  vector<const Type *> args;
+  for (auto *arg : exp->args)
+    args.push_back(typeOf(arg));
+  string what = "la llamada a " + exp->name.str();
+
+  // 1) función del usuario
+  if (FunDec *fn = exp->fn) {
+    if (args.size() != fn->params.size()) {
+      error(what + ": se esperaban " + to_string(fn->params.size()) +
+            " argumentos y hay " + to_string(args.size()));
+    }
+    for (size_t i = 0; i < args.size() && i < fn->params.size(); ++i)
+      expect(fn->params[i].type, args[i], what);
+    return fn->retType;
+  }
+
+  // 2) constructor: los args llenan los campos del constructor en orden
+  if (ClassDec *cls = exp->cls) {
+    if (args.size() > cls->args.size())
+      error(what + ": demasiados argumentos para el constructor");
+    for (size_t i = 0; i < args.size() && i < cls->args.size(); ++i)
+      expect(cls->args[i].type, args[i], what);
+    return Type::classType(cls->name);
+  }
+
+  // 3) builtins
+  if (exp->name == sym::print || exp->name == sym::println)
+    return Type::Unit();
+  const Type *elem = nullptr;
+  if (exp->name == sym::intArrayOf)
+    elem = Type::Int();
+  else if (exp->name == sym::longArrayOf)
+    elem = Type::Long();
+  else if (exp->name == sym::doubleArrayOf)
+    elem = Type::Double();
+  else if (exp->name == sym::booleanArrayOf)
+    elem = Type::Boolean();
+  else if (exp->name != sym::arrayOf && exp->name != sym::listOf &&
+           exp->name != sym::mutableListOf) {
+    error("función no declarada: " + exp->name.str());
+    return nullptr;
+  }
+  // el primer elemento manda: intArrayOf(intArrayOf(...)) es una matriz
+  if (!args.empty() && args[0])
+    elem = args[0];
+  for (auto *a : args)
+    expect(elem, a, what);
+  return elem ? Type::array(elem) : nullptr;
+}
+
+// listOf, arrayOf, intArrayOf, ... llegan todos como ListExp; en ejecución
+// son el mismo arreglo, así que el tipo es Array<T>
+const Type *TypeChecker::visit(ListExp *exp) {
+  const Type *elem = nullptr;
+  for (auto *e : exp->elements) {
+    const Type *t = typeOf(e);
+    expect(elem, t, "los elementos de la lista");
+    if (!elem)
+      elem = t;
+  }
+  return elem ? Type::array(elem) : nullptr;
+}
+
+const Type *TypeChecker::visit(IndexExp *exp) {
+  const Type *idx = typeOf(exp->index);
+  if (idx && !idx->isNumeric())
+    error("el índice de " + exp->name.str() + " es " + idx->str());
+  if (!exp->bind.resolved()) {
+    error("variable no declarada: " + exp->name.str());
+    return nullptr;
+  }
+  const Type *arr = slotType(exp->bind);
+  if (arr && !arr->element())
+    error(exp->name.str() + " es " + arr->str() + ", no un arreglo");
+  return arr ? arr->element() : nullptr;
+}
+
+const Type *TypeChecker::visit(DotExp *exp) {
+  if (!exp->bind.resolved()) {
+    error("variable no declarada: " + exp->id.str());
+    return nullptr;
+  }
+  const Type *obj = slotType(exp->bind);
+  if (!obj)
+    return nullptr;
+  auto cls = classes.find(obj->name);
+  if (obj->kind != Type::Kind::Class || cls == classes.end()) {
+    error(exp->id.str() + " es " + obj->str() + ", no una clase");
+    return nullptr;
+  }
+  exp->field = cls->second->field(exp->member);
+  if (!exp->field) {
+    error("la clase " + obj->str() + " no tiene el campo " +
+          exp->member.str());
+    return nullptr;
+  }
+  return exp->field->type;
+}
+
+// Sólo aparece como iterable de un for (ver visit(ForStatement*))
+const Type *TypeChecker::visit(LoopExp *exp) {
+  for (Exp *e : {exp->start, exp->end, exp->step}) {
+    if (!e)
+      continue;
+    const Type *t = typeOf(e);
+    if (t && !t->isNumeric())
+      error("los límites de un rango deben ser numéricos, no " + t->str());
+  }
+  return nullptr;
+}
+
+const Type *TypeChecker::visit(ArrayInitExp *exp) {
+  const Type *n = typeOf(exp->size);
+  if (n && !n->isNumeric())
+    error("el tamaño de un arreglo debe ser numérico, no " + n->str());
+  slotType(exp->it) = Type::Int();
+  const Type *body = typeOf(exp->body);
+  expect(exp->elemType, body, "el lambda del arreglo");
+  const Type *elem = exp->elemType ? exp->elemType : body;
+  return elem ? Type::array(elem) : nullptr;
+}
+
+// ── Sentencias ──
+
+void TypeChecker::visit(AssignStatement *stm) {
+  const Type *value = typeOf(stm->expr);
+  const Type *target = typeOf(stm->target);
+  expect(target, value, "la asignación");
+}
+
+void TypeChecker::visit(PrintStatement *stm) { typeOf(stm->expr); }
+
+void TypeChecker::visit(IfStatement *stm) {
+  typeOf(stm->cond);
+  accept(stm->thenBranch);
+  if (stm->elseBranch)
+    accept(stm->elseBranch);
+}
+
+void TypeChecker::visit(WhileStatement *stm) {
+  typeOf(stm->cond);
+  accept(stm->body);
+}
+
+void TypeChecker::visit(ForStatement *stm) {
+  // rango numérico -> Int; arreglo/lista -> tipo de sus elementos
+  const Type *var = nullptr;
+  const Type *it = typeOf(stm->iterable);
+  if (node_cast<LoopExp>(stm->iterable)) {
+    var = Type::Int();
+  } else if (it) {
+    var = it->element();
+    if (!var)
+      error("no se puede recorrer " + it->str() + " con for");
+  }
+  slotType(stm->bind) = var;
+  accept(stm->body);
+}
+
+void TypeChecker::visit(ReturnStatement *stm) {
+  const Type *t = stm->expr ? typeOf(stm->expr) : Type::Unit();
+  expect(retType, t, "return");
+}
+
+// ── Declaraciones y bloques ──
+
+// Sin anotación, la variable toma el tipo de su inicializador
+void TypeChecker::visit(VarDec *dec) {
+  Binding b = dec->bind;
+  for (size_t i = 0; i < dec->names.size(); ++i, ++b.slot) {
+    const Type *t = dec->type;
+    if (i < dec->inits.size() && dec->inits[i]) {
+      const Type *init = typeOf(dec->inits[i]);
+      expect(dec->type, init, "la declaración de " + dec->names[i].str());
+      if (!t)
+        t = init;
+    }
+    slotType(b) = t;
+  }
+}
+
+void TypeChecker::visit(VarDecList *list) {
+  for (auto *dec : list->vars)
+    accept(dec);
+}
+
+// Los campos no tienen slot: van al layout de la clase, uno tras otro
+void TypeChecker::visit(ClassDec *dec) {
+  dec->layout.clear();
+  dec->bytes = 0;
+  auto add = [&](Symbol name, const Type *t, Exp *init) {
+    dec->layout.push_back({name, t, dec->bytes, init});
+    dec->bytes += t ? t->size : Type::kSlotSize;
+  };
+  for (auto &arg : dec->args)
+    add(arg.name, arg.type, nullptr);
+  for (auto *var : dec->members->vars) {
+    for (size_t i = 0; i < var->names.size(); ++i) {
+      const Type *t = var->type;
+      Exp *init = i < var->inits.size() ? var->inits[i] : nullptr;
+      if (init) {
+        const Type *it = typeOf(init);
+        expect(var->type, it, "el campo " + var->names[i].str());
+        if (!t)
+          t = it;
+      }
+      add(var->names[i], t, init);
+    }
+  }
+}
+
+void TypeChecker::visit(ClassDecList *list) {
+  for (auto *cls : list->classes)
+    accept(cls);
+}
+
+void TypeChecker::visit(FunDec *dec) {
+  current = dec;
+  retType = dec->name == sym::main ? Type::Unit() : dec->retType;
+  localTypes.assign(dec->frameSize, nullptr);
+  for (size_t i = 0; i < dec->params.size(); ++i)
+    localTypes[i] = dec->params[i].type;
+  accept(dec->body);
+  current = nullptr;
+}
+
+void TypeChecker::visit(FunDecList *list) {
+  for (auto *fn : list->functions)
+    accept(fn);
+}
+
+void TypeChecker::visit(StatementList *list) {
+  for (auto *s : list->statements)
+    accept(s);
+}
+
+void TypeChecker::visit(Body *body) {
+  accept(body->vardecs);
+  accept(body->stmts);
+}
+
+// Clases primero: las globales pueden ser objetos
+void TypeChecker::visitGlobals(Program *prog) {
+  classes.clear();
+  for (auto *cls : prog->classDecs->classes)
+    classes[cls->name] = cls;
+  globalTypes.assign(prog->globalSlots, nullptr);
+  accept(prog->classDecs);
+  accept(prog->vardecs);
+}
+
+void TypeChecker::visit(Program *prog) {
+  visitGlobals(prog);
+  accept(prog->funDecs);
+}
@@ -0,0 +1,91 @@
+// typecheck.h
+#ifndef TYPECHECK_H
+#define TYPECHECK_H
+
+#include "exp.h"
+#include "visitor.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Inferencia y chequeo de tipos. Corre después del Resolver (usa los
+// Binding para saber el tipo de cada slot) y antes de cualquier visitor que
+// ejecute o genere código: deja en cada Exp::type su tipo, arma el layout
+// de cada ClassDec y apunta cada DotExp::field a su campo, así GenCodeVisitor
+// y EVALVisitor deciden por lo ya calculado en vez de adivinarlo en cada uso.
+//
+// Los tipos son Type internados (types.h) y se comparan por puntero.
+// Arreglos y listas se comparan por su tipo de elemento (IntArray y
+// List<Int> tienen la misma representación en ejecución). nullptr es un
+// tipo desconocido y es compatible con todo, para no encadenar errores.
+//
+// check() junta todos los errores del programa y, si hubo alguno, lanza
+// runtime_error con la lista: el driver no llega a generar código.
+class TypeChecker : public VisitorBase<TypeChecker, const Type *, void> {
+public:
+  void check(Program *prog);
+  // Por partes, como Resolver::begin/resolveFunction: cada una lanza con
+  // los errores que haya encontrado
+  void begin(Program *prog);
+  void checkFunction(FunDec *fn);
+
+  static bool compatible(const Type *a, const Type *b);
+
+  const Type *visit(BinaryExp *exp);
+  const Type *visit(IFExp *exp);
+  const Type *visit(StringExp *exp);
+  const Type *visit(NumberExp *exp);
+  const Type *visit(BoolExp *exp);
+  const Type *visit(IdentifierExp *exp);
+  const Type *visit(FCallExp *exp);
+  const Type *visit(ListExp *exp);
+  const Type *visit(IndexExp *exp);
+  const Type *visit(DotExp *exp);
+  const Type *visit(LoopExp *exp);
+  const Type *visit(ArrayInitExp *exp);
+
+  void visit(AssignStatement *stm);
+  void visit(PrintStatement *stm);
+  void visit(IfStatement *stm);
+  void visit(WhileStatement *stm);
+  void visit(ForStatement *stm);
+  void visit(ReturnStatement *stm);
+
+  void visit(VarDec *dec);
+  void visit(VarDecList *list);
+  void visit(ClassDec *dec);
+  void visit(ClassDecList *list);
+  void visit(FunDec *dec);
+  void visit(FunDecList *list);
+
+  void visit(StatementList *list);
+  void visit(Body *body);
+  void visit(Program *prog);
+
+private:
+  // Clases y globales (todo menos las funciones)
+  void visitGlobals(Program *prog);
+  // Lanza runtime_error con los errores juntados, si hay
+  void report();
+  // accept() + anotar e->type
+  const Type *typeOf(Exp *e);
+  // Tipo de l op r
+  const Type *binaryType(BinaryExp *exp, const Type *l, const Type *r);
+  const Type *&slotType(const Binding &b);
+  void expect(const Type *expected, const Type *found,
+              const std::string &what);
+  void error(const std::string &msg);
+
+  // Tipo de cada slot, en paralelo a los frames del Resolver
+  std::vector<const Type *> globalTypes;
+  std::vector<const Type *> localTypes;
+  // nombre -> clase, para resolver el campo de un DotExp
+  std::unordered_map<Symbol, ClassDec *> classes;
+
+  FunDec *current = nullptr; // función que se está chequeando
+  const Type *retType = nullptr;
+  std::vector<std::string> errors;
+  std::vector<BinaryExp *> spine; // ver visit(BinaryExp*)
+};
+
+#endif // TYPECHECK_H
@@ -0,0 +1,171 @@
+// types.cpp
+#include "types.h"
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+// Clave estructural: los hijos ya son únicos, así que basta comparar sus
+// punteros
+struct Key {
+  Type::Kind kind;
+  Symbol name;
+  const Type *elem;
+  vector<const Type *> args;
+  bool operator==(const Key &o) const {
+    return kind == o.kind && name == o.name && elem == o.elem &&
+           args == o.args;
+  }
+};
+
+struct KeyHash {
+  size_t operator()(const Key &k) const {
+    size_t h = size_t(k.kind) * 0x9e3779b97f4a7c15ull ^ k.name.id();
+    h = h * 31 + hash<const Type *>()(k.elem);
+    for (auto *a : k.args)
+      h = h * 31 + hash<const Type *>()(a);
+    return h;
+  }
+};
+
+string textOf(Type::Kind kind, Symbol name, const Type *elem,
+              const vector<const Type *> &args) {
+  if (kind == Type::Kind::Array)
+    return "Array<" + typeName(elem) + ">";
+  string s = name.str();
+  if (kind == Type::Kind::Generic) {
+    s += "<";
+    for (size_t i = 0; i < args.size(); i++)
+      s += (i ? "," : "") + typeName(args[i]);
+    s += ">";
+  }
+  return s;
+}
+
+} // namespace
+
+Type::Type(Kind kind, Symbol name, const Type *elem,
+           vector<const Type *> args)
+    : kind(kind), name(name), elem(elem), args(move(args)), size(kSlotSize),
+      text(textOf(kind, name, elem, this->args)) {}
+
+const Type *Type::intern(Kind kind, Symbol name, const Type *elem,
+                         const vector<const Type *> &args) {
+  static mutex mtx;
+  static auto *types = new unordered_map<Key, const Type *, KeyHash>();
+  Key key{kind, name, elem, args};
+  lock_guard<mutex> lock(mtx);
+  auto it = types->find(key);
+  if (it != types->end())
+    return it->second;
+  const Type *t = new Type(kind, name, elem, args);
+  types->emplace(move(key), t);
+  return t;
+}
+
+const Type *Type::Int() {
+  static const Type *t = intern(Kind::Int, sym::Int, nullptr, {});
+  return t;
+}
+
+const Type *Type::Long() {
+  static const Type *t = intern(Kind::Long, sym::Long, nullptr, {});
+  return t;
+}
+
+const Type *Type::Double() {
+  static const Type *t = intern(Kind::Double, sym::Double, nullptr, {});
+  return t;
+}
+
+const Type *Type::Boolean() {
+  static const Type *t = intern(Kind::Boolean, sym::Boolean, nullptr, {});
+  return t;
+}
+
+const Type *Type::String() {
+  static const Type *t = intern(Kind::String, sym::String, nullptr, {});
+  return t;
+}
+
+const Type *Type::Unit() {
+  static const Type *t = intern(Kind::Unit, sym::Unit, nullptr, {});
+  return t;
+}
+
+const Type *Type::array(const Type *elem) {
+  return intern(Kind::Array, Symbol(), elem, {});
+}
+
+const Type *Type::generic(Symbol name, const vector<const Type *> &args) {
+  if (name.str() == "Array" && args.size() == 1)
+    return array(args[0]);
+  return intern(Kind::Generic, name, nullptr, args);
+}
+
+const Type *Type::classType(Symbol name) {
+  return intern(Kind::Class, name, nullptr, {});
+}
+
+const Type *Type::named(string_view name) {
+  if (name.empty())
+    return nullptr;
+  Symbol s = Symbol::intern(name);
+  if (s == sym::Int)
+    return Int();
+  if (s == sym::Long)
+    return Long();
+  if (s == sym::Double)
+    return Double();
+  if (s == sym::Boolean)
+    return Boolean();
+  if (s == sym::String)
+    return String();
+  if (s == sym::Unit)
+    return Unit();
+  if (name == "IntArray")
+    return array(Int());
+  if (name == "LongArray")
+    return array(Long());
+  if (name == "DoubleArray")
+    return array(Double());
+  if (name == "BooleanArray")
+    return array(Boolean());
+  return classType(s);
+}
+
+// Parser recursivo mínimo: Nombre [ '<' Tipo (',' Tipo)* '>' ]
+static const Type *parseAt(string_view text, size_t &pos) {
+  size_t start = pos;
+  while (pos < text.size() && text[pos] != '<' && text[pos] != '>' &&
+         text[pos] != ',')
+    pos++;
+  string_view name = text.substr(start, pos - start);
+  if (pos >= text.size() || text[pos] != '<')
+    return Type::named(name);
+  vector<const Type *> args;
+  do {
+    pos++; // '<' o ','
+    args.push_back(parseAt(text, pos));
+  } while (pos < text.size() && text[pos] == ',');
+  pos++; // '>'
+  return Type::generic(Symbol::intern(name), args);
+}
+
+const Type *Type::parse(string_view text) {
+  size_t pos = 0;
+  return text.empty() ? nullptr : parseAt(text, pos);
+}
+
+const Type *Type::element() const {
+  if (kind == Kind::Array)
+    return elem;
+  if (kind == Kind::Generic && args.size() == 1 &&
+      (name.str() == "List" || name.str() == "MutableList"))
+    return args[0];
+  return nullptr;
+}
+
+string typeName(const Type *t) { return t ? t->str() : "?"; }
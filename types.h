@@ -0,0 +1,82 @@
+// types.h
+#ifndef TYPES_H
+#define TYPES_H
+
+#include "symbol.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Tipo del lenguaje como objeto estructural. Los tipos se "hash-consean":
+// cada tipo distinto existe una sola vez en una tabla global (como los
+// Symbol), así que dos tipos son iguales si y sólo si sus punteros lo son, y
+// lo que se calcula por tipo (tamaño, texto) se calcula una vez al crearlo.
+// Se obtienen siempre con las fábricas de abajo y viven hasta el final del
+// proceso. La tabla es compartida por todos los hilos.
+//
+// Un tipo desconocido o no escrito en el fuente es nullptr.
+class Type {
+public:
+  enum class Kind : uint8_t {
+    Int,
+    Long,
+    Double,
+    Boolean,
+    String,
+    Unit,
+    Array,   // Array<T>, IntArray, LongArray, ...
+    Generic, // List<T>, MutableList<T> y cualquier otro Nombre<T, ...>
+    Class
+  };
+
+  const Kind kind;
+  const Symbol name;       // nombre del primitivo, clase o genérico
+  const Type *const elem;  // Array: tipo de los elementos
+  const std::vector<const Type *> args; // Generic: argumentos
+  // Bytes que ocupa un valor en un slot, en un campo o como elemento de un
+  // arreglo. En este backend todo valor cabe en kSlotSize bytes (los objetos,
+  // arreglos y String son punteros); un tipo desconocido también ocupa eso.
+  static constexpr uint32_t kSlotSize = 8;
+  const uint32_t size;
+
+  static const Type *Int();
+  static const Type *Long();
+  static const Type *Double();
+  static const Type *Boolean();
+  static const Type *String();
+  static const Type *Unit();
+  static const Type *array(const Type *elem);
+  // Array<T> se normaliza a array(T)
+  static const Type *generic(Symbol name,
+                             const std::vector<const Type *> &args);
+  static const Type *classType(Symbol name);
+
+  // Nombre simple del fuente: "Int", "IntArray", "P", ...
+  static const Type *named(std::string_view name);
+  // Texto completo, con genéricos anidados ("List<Array<Int>>"); es la
+  // inversa de str(). "" -> nullptr
+  static const Type *parse(std::string_view text);
+
+  bool isNumeric() const {
+    return kind == Kind::Int || kind == Kind::Long || kind == Kind::Double;
+  }
+  // Tipo de los elementos si se puede indexar/recorrer (Array, List<T>,
+  // MutableList<T>); nullptr si no
+  const Type *element() const;
+
+  const std::string &str() const { return text; }
+
+private:
+  Type(Kind kind, Symbol name, const Type *elem,
+       std::vector<const Type *> args);
+  static const Type *intern(Kind kind, Symbol name, const Type *elem,
+                            const std::vector<const Type *> &args);
+
+  const std::string text;
+};
+
+// Para mensajes: "Int", "Array<Int>" o "?" si es desconocido
+std::string typeName(const Type *t);
+
+#endif // TYPES_H
@@ -1,6 +1,8 @@
 #include "ui.h"
 #include "parser.h"
+#include "resolver.h"
 #include "scanner.h"
+#include "typecheck.h"
 #include "visitor.h"
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
@@ -139,10 +141,13 @@ int main() {
           }
         }
         if (buttonRun.isClicked(mousePos)) {
-          Scanner scanner(kotlinEditor.getText().c_str());
+          string source = kotlinEditor.getText();
+          Scanner scanner(source);
           Parser parser(&scanner, false);
           try {
             Program *program = parser.parseProgram();
+            Resolver().resolve(program);
+            TypeChecker().check(program);
             stringstream ss;
             GenCodeVisitor<stringstream> genVisitor(ss);
             genVisitor.generate(program);
@@ -1,6 +1,9 @@
 // visitor.cpp
 #include "visitor.h"
 #include "exp.h"
+#include "parallel.h"
+#include "timing.h"
+#include <exception>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -8,185 +11,127 @@
 
 using namespace std;
 
-//------------------------------------------------------------
-// Accept hooks for Exp and Stm (if not already in exp.cpp)
-//------------------------------------------------------------
-
-int BinaryExp::accept(Visitor *v) { return v->visit(this); }
-int IFExp::accept(Visitor *v) { return v->visit(this); }
-int NumberExp::accept(Visitor *v) { return v->visit(this); }
-int BoolExp::accept(Visitor *v) { return v->visit(this); }
-int IdentifierExp::accept(Visitor *v) { return v->visit(this); }
-int FCallExp::accept(Visitor *v) { return v->visit(this); }
-int ListExp::accept(Visitor *v) { return v->visit(this); }
-int IndexExp::accept(Visitor *v) { return v->visit(this); }
-int DotExp::accept(Visitor *v) { return v->visit(this); }
-int LoopExp::accept(Visitor *v) { return v->visit(this); }
-
-int AssignStatement::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int PrintStatement::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int IfStatement::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int WhileStatement::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int ForStatement::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int ReturnStatement::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-
-int VarDec::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int VarDecList::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int ClassDec::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int ClassDecList::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int FunDec::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int FunDecList::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-
-int StatementList::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int Body::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-int Program::accept(Visitor *v) {
-  v->visit(this);
-  return 0;
-}
-
 //----------------------------------------------------------------------
 // PrintVisitor implementations
 //----------------------------------------------------------------------
 
 void PrintVisitor::imprimir(Program *p) {
-  p->accept(this);
+  accept(p);
   cout << endl;
 }
 
-int PrintVisitor::visit(BinaryExp *e) {
-  e->left->accept(this);
-  cout << " " << Exp::binopToChar(e->op) << " ";
-  e->right->accept(this);
-  return 0;
+// Espina izquierda con un bucle (ver pushLeftSpine)
+void PrintVisitor::visit(BinaryExp *e) {
+  size_t base = spine.size();
+  accept(pushLeftSpine(e, spine));
+  while (spine.size() > base) {
+    BinaryExp *b = spine.back();
+    spine.pop_back();
+    cout << " " << Exp::binopToChar(b->op) << " ";
+    accept(b->right);
+  }
 }
 
-int PrintVisitor::visit(IFExp *e) {
+void PrintVisitor::visit(IFExp *e) {
   cout << "if(";
-  e->cond->accept(this);
+  accept(e->cond);
   cout << "){";
-  e->left->accept(this);
+  accept(e->left);
   cout << "}else{";
-  e->right->accept(this);
+  accept(e->right);
   cout << "}";
-  return 0;
+  return;
 }
 
-int PrintVisitor::visit(StringExp *exp) {
+void PrintVisitor::visit(StringExp *exp) {
   cout << '"' << exp->value << '"';
-  return 0;
+  return;
 }
 
-int PrintVisitor::visit(NumberExp *e) {
+void PrintVisitor::visit(NumberExp *e) {
   cout << e->value;
-  return 0;
+  return;
 }
 
-int PrintVisitor::visit(BoolExp *e) {
+void PrintVisitor::visit(BoolExp *e) {
   cout << (e->value ? "true" : "false");
-  return 0;
+  return;
 }
-int PrintVisitor::visit(IdentifierExp *e) {
+void PrintVisitor::visit(IdentifierExp *e) {
   cout << e->name;
-  return 0;
+  return;
 }
 
-int PrintVisitor::visit(FCallExp *e) {
+void PrintVisitor::visit(FCallExp *e) {
   cout << e->name << "(";
   for (size_t i = 0; i < e->args.size(); ++i) {
-    e->args[i]->accept(this);
+    accept(e->args[i]);
     if (i + 1 < e->args.size())
       cout << ", ";
   }
   cout << ")";
-  return 0;
+  return;
 }
 
-int PrintVisitor::visit(ListExp *e) {
+void PrintVisitor::visit(ListExp *e) {
   cout << (e->isMutable ? "mutableListOf(" : "listOf(");
   for (size_t i = 0; i < e->elements.size(); ++i) {
-    e->elements[i]->accept(this);
+    accept(e->elements[i]);
     if (i + 1 < e->elements.size())
       cout << ", ";
   }
   cout << ")";
-  return 0;
+  return;
 }
 
-int PrintVisitor::visit(IndexExp *e) {
+void PrintVisitor::visit(IndexExp *e) {
   // imprime algo como: lista[indice]
   cout << e->name << "[";
-  e->index->accept(this);
+  accept(e->index);
   cout << "]";
-  return 0;
+  return;
 }
 
-int PrintVisitor::visit(DotExp *e) {
+void PrintVisitor::visit(DotExp *e) {
   cout << e->id << "." << e->member;
-  return 0;
+  return;
 }
 
-int PrintVisitor::visit(LoopExp *e) {
-  e->start->accept(this);
+void PrintVisitor::visit(LoopExp *e) {
+  accept(e->start);
   cout << (e->downTo ? " downTo " : "..");
-  e->end->accept(this);
+  accept(e->end);
   if (e->step) {
     cout << " step ";
-    e->step->accept(this);
+    accept(e->step);
   }
-  return 0;
+  return;
+}
+
+// Tipo tal como se escribe; vacío si no se escribió
+static string typeText(const Type *t) { return t ? t->str() : ""; }
+
+void PrintVisitor::visit(ArrayInitExp *e) {
+  if (e->elemType == Type::Int() || e->elemType == Type::Double())
+    cout << e->elemType->str() << "Array(";
+  else
+    cout << "Array<" << typeText(e->elemType) << ">(";
+  accept(e->size);
+  cout << ") { ";
+  accept(e->body);
+  cout << " }";
+  return;
 }
 
 void PrintVisitor::visit(AssignStatement *s) {
   cout << s->target << " = ";
-  s->expr->accept(this);
+  accept(s->expr);
   cout << ";" << endl;
 }
 
 void PrintVisitor::visit(PrintStatement *s) {
   cout << "print(";
-  s->expr->accept(this);
+  accept(s->expr);
   cout << ");" << endl;
 }
 
@@ -194,7 +139,7 @@ void PrintVisitor::visit(ReturnStatement *s) {
   cout << "return";
   if (s->expr) {
     cout << " ";
-    s->expr->accept(this);
+    accept(s->expr);
   }
   cout << ";" << endl;
 }
@@ -202,15 +147,15 @@ void PrintVisitor::visit(ReturnStatement *s) {
 void PrintVisitor::visit(IfStatement *s) {
   cout << "if ";
   cout << "--- cond" << endl;
-  s->cond->accept(this);
+  accept(s->cond);
   cout << " {" << endl;
   cout << "--- then branch" << endl;
-  s->thenBranch->accept(this);
+  accept(s->thenBranch);
   cout << "}";
   cout << "--- else branch" << endl;
   if (s->elseBranch) {
     cout << " else {" << endl;
-    s->elseBranch->accept(this);
+    accept(s->elseBranch);
     cout << "}";
   }
   cout << endl;
@@ -218,17 +163,17 @@ void PrintVisitor::visit(IfStatement *s) {
 
 void PrintVisitor::visit(WhileStatement *s) {
   cout << "while ";
-  s->cond->accept(this);
+  accept(s->cond);
   cout << " {" << endl;
-  s->body->accept(this);
+  accept(s->body);
   cout << "}" << endl;
 }
 
 void PrintVisitor::visit(ForStatement *s) {
   cout << "for(" << s->varName << " in ";
-  s->iterable->accept(this);
+  accept(s->iterable);
   cout << ") {" << endl;
-  s->body->accept(this);
+  accept(s->body);
   cout << "}" << endl;
 }
 
@@ -238,14 +183,14 @@ void PrintVisitor::visit(VarDec *d) {
     cout << ", " << d->names[i];
   }
 
-  cout << ": " << d->typeName;
+  cout << ": " << typeText(d->type);
 
   if (d->inits.size() > 0) {
     cout << " = ";
-    d->inits[0]->accept(this);
+    accept(d->inits[0]);
     for (int i = 1; i < d->inits.size(); i++) {
       cout << ", " << d->names[i];
-      d->inits[i]->accept(this);
+      accept(d->inits[i]);
     }
   }
 
@@ -254,56 +199,56 @@ void PrintVisitor::visit(VarDec *d) {
 
 void PrintVisitor::visit(VarDecList *list) {
   for (auto dec : list->vars)
-    dec->accept(this);
+    accept(dec);
 }
 
 void PrintVisitor::visit(ClassDec *c) {
   cout << "class " << c->name << "(";
   for (size_t i = 0; i < c->args.size(); ++i) {
-    cout << c->args[i].name << ":" << c->args[i].type;
+    cout << c->args[i].name << ":" << typeText(c->args[i].type);
     if (i + 1 < c->args.size())
       cout << ", ";
   }
   cout << ") {" << endl;
-  c->members->accept(this);
+  accept(c->members);
   cout << "}" << endl;
 }
 
 void PrintVisitor::visit(ClassDecList *l) {
   for (auto c : l->classes)
-    c->accept(this);
+    accept(c);
 }
 
 void PrintVisitor::visit(FunDec *f) {
   cout << "fun " << f->name << "(";
   for (size_t i = 0; i < f->params.size(); ++i) {
-    cout << f->params[i].name << ":" << f->params[i].type;
+    cout << f->params[i].name << ":" << typeText(f->params[i].type);
     if (i + 1 < f->params.size())
       cout << ", ";
   }
-  cout << "):" << f->retType << " {" << endl;
-  f->body->accept(this);
+  cout << "):" << typeText(f->retType) << " {" << endl;
+  accept(f->body);
   cout << "}" << endl;
 }
 
 void PrintVisitor::visit(FunDecList *l) {
   for (auto f : l->functions)
-    f->accept(this);
+    accept(f);
 }
 
 void PrintVisitor::visit(StatementList *l) {
   for (auto s : l->statements)
-    s->accept(this);
+    accept(s);
 }
 
 void PrintVisitor::visit(Body *b) {
-  b->vardecs->accept(this);
-  b->stmts->accept(this);
+  accept(b->vardecs);
+  accept(b->stmts);
 }
 
 void PrintVisitor::visit(Program *p) {
   if (p->body)
-    p->body->accept(this);
+    accept(p->body);
 }
 
 //----------------------------------------------------------------------
@@ -311,48 +256,37 @@ void PrintVisitor::visit(Program *p) {
 //----------------------------------------------------------------------
 
 void EVALVisitor::ejecutar(Program *p) {
-  // ── 0) Registrar todas las clases (campos e inits) ──
-  if (p->classDecs) {
-    for (auto *cd : p->classDecs->classes) {
-      // 0.a) Campos (ya lo hace tu visit(ClassDec*), pero podemos rellenarlo
-      // aquí con seguridad)
-      std::vector<std::string> flds;
-      for (auto *vd : cd->members->vars)
-        for (auto &nm : vd->names)
-          flds.push_back(nm);
-      classFields_[cd->name] = std::move(flds);
-
-      // 0.b) Inits por defecto
-      std::vector<Exp *> inits;
-      for (auto *vd : cd->members->vars)
-        for (auto *e : vd->inits)
-          inits.push_back(e);
-      classFieldInits_[cd->name] = std::move(inits);
+  // Las clases ya traen su layout (ClassDec::layout, de TypeChecker)
+  // 1) Frame de globales, inicializadas en orden de declaración
+  globals.assign(p->globalSlots, 0);
+  accept(p->vardecs);
+
+  // 2) Frame de main y su cuerpo
+  for (auto *fn : p->funDecs->functions) {
+    if (fn->name == sym::main) {
+      stack.assign(fn->frameSize, 0);
+      base = 0;
+      accept(fn->body);
+      break;
     }
   }
-  // 1) Nuevo scope (global)
-  env.add_level();
-
-  // 2) Registra variables globales declaradas antes de 'fun'
-  if (p->vardecs) {
-    p->vardecs->accept(this);
-  }
+}
 
-  // 3) Registra todas las funciones (llenado de fdecs)
-  if (p->funDecs) {
-    p->funDecs->accept(this);
+// La espina izquierda se recorre con un bucle (ver pushLeftSpine),
+// acumulando el valor de izquierda a derecha
+int EVALVisitor::visit(BinaryExp *exp) {
+  size_t base = spine.size();
+  int v = accept(pushLeftSpine(exp, spine));
+  while (spine.size() > base) {
+    BinaryExp *b = spine.back();
+    spine.pop_back();
+    v = apply(b->op, v, accept(b->right));
   }
-
-  p->body->accept(this);
-
-  // 5) Sal del scope global
-  env.remove_level();
+  return v;
 }
 
-int EVALVisitor::visit(BinaryExp *exp) {
-  int v1 = exp->left->accept(this);
-  int v2 = exp->right->accept(this);
-  switch (exp->op) {
+int EVALVisitor::apply(BinaryOp op, int v1, int v2) {
+  switch (op) {
   case PLUS_OP:
     return v1 + v2;
   case MINUS_OP:
@@ -374,127 +308,97 @@ int EVALVisitor::visit(BinaryExp *exp) {
   }
 }
 
-int EVALVisitor::visit(StringExp *exp) { return 0; }
+// Un String es el id de su texto internado (ver printValue)
+int EVALVisitor::visit(StringExp *exp) {
+  return Symbol::intern(exp->value).id();
+}
 
 int EVALVisitor::visit(NumberExp *exp) { return exp->value; }
 int EVALVisitor::visit(BoolExp *exp) { return exp->value; }
 
 int EVALVisitor::visit(IdentifierExp *exp) {
-  if (!env.check(exp->name)) {
+  if (!exp->bind.resolved()) {
     cout << "Variable no declarada: " << exp->name << endl;
     return 0;
   }
-  int r = env.lookup(exp->name);
-  return env.lookup(exp->name);
+  return slot(exp->bind);
 }
 
 int EVALVisitor::visit(FCallExp *exp) {
-  auto itFields = classFields_.find(exp->name);
-  if (itFields != classFields_.end()) {
+  // 0) Constructor: un valor por campo, en el orden del layout. Los args
+  // llenan los campos del constructor y el resto toma su valor por defecto.
+  if (ClassDec *cls = exp->cls) {
     int objId = nextObjectId++;
-    auto &fields = itFields->second;
-    auto &inits = classFieldInits_[exp->name];
-
-    for (size_t i = 0; i < fields.size(); ++i) {
-      int val;
-      if (i < exp->args.size())
-        val = exp->args[i]->accept(this);
-      else
-        val = inits[i]->accept(this);
-      objectHeap[objId][fields[i]] = val;
+    auto &obj = objectHeap[objId];
+    obj.assign(cls->layout.size(), 0);
+    for (size_t i = 0; i < cls->layout.size(); ++i) {
+      const Field &f = cls->layout[i];
+      if (i < cls->args.size()) {
+        if (i < exp->args.size())
+          obj[i] = accept(exp->args[i]);
+      } else if (f.init) {
+        obj[i] = accept(f.init);
+      }
     }
-    retval = objId;
     return objId;
   }
 
   // 1) Built-in: print / println
-  if (exp->name == "print" || exp->name == "println") {
-    for (auto arg : exp->args) {
-      // 1.a) String literal directo
-      if (auto se = dynamic_cast<StringExp *>(arg)) {
-        cout << se->value;
-        continue;
-      }
-      // 1.b) IndexExp sobre lista de strings
-      if (auto ie = dynamic_cast<IndexExp *>(arg)) {
-        int listId = env.lookup(ie->name);
-        int idx = ie->index->accept(this);
-        // si existe en el heap de strings
-        if (stringListHeap.count(listId)) {
-          cout << stringListHeap[listId][idx];
-          continue;
-        }
-        // si no, cae a imprimir como entero abajo
-      }
-      // 1.c) cualquier otro caso: interpreta como Int
-      cout << arg->accept(this);
-    }
-    if (exp->name == "println")
+  if (exp->name == sym::print || exp->name == sym::println) {
+    for (auto arg : exp->args)
+      printValue(arg);
+    if (exp->name == sym::println)
       cout << "\n";
     return 0;
   }
 
   // BUILTIN para arrays de enteros y objetos
-  if (exp->name == "arrayOf" || exp->name == "intArrayOf" ||
-      exp->name == "longArrayOf" || exp->name == "doubleArrayOf" ||
-      exp->name == "booleanArrayOf") {
+  if (exp->name == sym::arrayOf || exp->name == sym::intArrayOf ||
+      exp->name == sym::longArrayOf || exp->name == sym::doubleArrayOf ||
+      exp->name == sym::booleanArrayOf) {
     std::vector<int> vals;
     for (auto *arg : exp->args)
-      vals.push_back(arg->accept(this));
+      vals.push_back(accept(arg));
     int id = nextListId++;
     listHeap[id] = std::move(vals);
     return id;
   }
 
-  // 2) Llamada a función del usuario
-  auto it = fdecs.find(exp->name);
-  if (it == fdecs.end()) {
+  // 2) Llamada a función del usuario (el resolver ya dejó el FunDec)
+  FunDec *fn = exp->fn;
+  if (!fn) {
     cerr << "Error: función no declarada: " << exp->name << endl;
     exit(1);
   }
-  FunDec *fn = it->second;
 
   // 3) Evaluar todos los argumentos como Int
   vector<int> vals;
   for (auto arg : exp->args) {
-    vals.push_back(arg->accept(this));
+    vals.push_back(accept(arg));
   }
 
-  // 4) Nuevo scope para parámetros
-  env.add_level();
-  for (size_t i = 0; i < fn->params.size(); ++i) {
-    env.add_var(fn->params[i].name, fn->params[i].type);
-    env.update(fn->params[i].name, vals[i]);
-  }
+  // 4) Frame nuevo encima del actual; los params van en los primeros slots
+  size_t callerBase = base;
+  base = stack.size();
+  stack.resize(base + fn->frameSize, 0);
+  for (size_t i = 0; i < fn->params.size() && i < vals.size(); ++i)
+    stack[base + i] = vals[i];
 
   // 5) Ejecutar cuerpo de la función
-  fn->body->accept(this);
-  int result = retval;
+  int result = accept(fn->body).value;
 
-  // 6) Salir del scope
-  env.remove_level();
+  // 6) Descartar el frame
+  stack.resize(base);
+  base = callerBase;
   return result;
 }
 
 // Lista literal: construye un vector<int>, lo guarda en listHeap y devuelve su
-// ID
+// ID (una lista de String guarda los ids de sus textos)
 int EVALVisitor::visit(ListExp *exp) {
-  // Si el primer elemento es StringExp hacemos lista de strings
-  if (!exp->elements.empty() &&
-      dynamic_cast<StringExp *>(exp->elements[0]) != nullptr) {
-    std::vector<std::string> svals;
-    for (auto e : exp->elements) {
-      auto se = dynamic_cast<StringExp *>(e);
-      svals.push_back(se->value);
-    }
-    int id = nextListId++;
-    stringListHeap[id] = std::move(svals);
-    return id;
-  }
-  // Si no, lista de enteros
   std::vector<int> ivals;
   for (auto e : exp->elements) {
-    ivals.push_back(e->accept(this));
+    ivals.push_back(accept(e));
   }
   int id = nextListId++;
   listHeap[id] = std::move(ivals);
@@ -503,21 +407,10 @@ int EVALVisitor::visit(ListExp *exp) {
 
 int EVALVisitor::visit(IndexExp *exp) {
   // 1) obtenemos el id de la lista
-  int listId = env.lookup(exp->name);
-  int idx = exp->index->accept(this);
-
-  // 2) si existe en stringListHeap, devolvemos un índice inválido (no se usa
-  // aquí)
-  if (stringListHeap.count(listId)) {
-    auto &svec = stringListHeap[listId];
-    if (idx < 0 || idx >= (int)svec.size()) {
-      std::cerr << "Error: índice fuera de rango en " << exp->name << ": "
-                << idx << "\n";
-      exit(1);
-    }
-    return idx;
-  }
-  // 3) si está en listHeap, devolvemos el valor int
+  int listId = slot(exp->bind);
+  int idx = accept(exp->index);
+
+  // 2) devolvemos el elemento
   auto &vec = listHeap.at(listId);
   if (idx < 0 || idx >= (int)vec.size()) {
     std::cerr << "Error: índice fuera de rango en " << exp->name << ": " << idx
@@ -529,223 +422,217 @@ int EVALVisitor::visit(IndexExp *exp) {
 
 int EVALVisitor::visit(DotExp *exp) {
   // 1) Evaluar la sub-expresión que produce el objectId
-  int objId = env.lookup(exp->id);
+  int objId = slot(exp->bind);
 
-  // 2) Buscar el campo en objectHeap[objId]
-  auto &objMap = objectHeap[objId];
-  auto it = objMap.find(exp->member);
-  if (it == objMap.end()) {
+  // 2) El campo está en la posición que le dio el layout de su clase
+  auto it = objectHeap.find(objId);
+  if (it == objectHeap.end() || !exp->field) {
     std::cerr << "Error: campo '" << exp->member
               << "' no existe en el objeto\n";
     std::exit(1);
   }
-  retval = it->second;
-  return it->second;
+  return it->second[fieldIndex(exp->field)];
 }
 
 int EVALVisitor::visit(IFExp *exp) {
-  if (exp->cond->accept(this))
-    return exp->left->accept(this);
+  if (accept(exp->cond))
+    return accept(exp->left);
   else
-    return exp->right->accept(this);
+    return accept(exp->right);
 }
 
 int EVALVisitor::visit(LoopExp *exp) {
   // numeric range only
-  int start = exp->start->accept(this);
-  int end = exp->end->accept(this);
-  int step = exp->step ? exp->step->accept(this) : (exp->downTo ? -1 : 1);
+  int start = accept(exp->start);
+  int end = accept(exp->end);
+  int step = exp->step ? accept(exp->step) : (exp->downTo ? -1 : 1);
   // return start as placeholder
   return start;
 }
 
-void EVALVisitor::visit(AssignStatement *stm) {
-  // 1) Evaluar RHS
-  int val = stm->expr->accept(this);
-
-  // 2) Asignación a variable simple
-  if (auto id = dynamic_cast<IdentifierExp *>(stm->target)) {
-    const std::string &name = id->name;
-    if (!env.check(name)) {
-      std::cerr << "Variable no declarada: " << name << "\n";
-      return;
-    }
-    env.update(name, val);
-    return;
-  }
-
-  // 3) Asignación a array[index]
-  if (auto idx = dynamic_cast<IndexExp *>(stm->target)) {
-    // asumimos que la variable es un array de enteros en listHeap[id]
-    int arrId = env.lookup(idx->name);
-    int i = idx->index->accept(this);
-    listHeap[arrId][i] = val;
-    return;
-  }
-
-  // 4) Asignación a struct.field
-  if (auto dot = dynamic_cast<DotExp *>(stm->target)) {
-    int objId = env.lookup(dot->id);
-    objectHeap[objId][dot->member] = val;
-    return;
+// Array con lambda: se evalúa el cuerpo una vez por elemento con 'it' = i
+int EVALVisitor::visit(ArrayInitExp *exp) {
+  int n = accept(exp->size);
+  std::vector<int> vals;
+  vals.reserve(n > 0 ? n : 0);
+  for (int i = 0; i < n; ++i) {
+    slot(exp->it) = i;
+    vals.push_back(accept(exp->body));
   }
-  // 5) Cualquier otro LHS no es válido
-  std::cerr << "Asignación inválida en LHS no identificador\n";
+  int id = nextListId++;
+  listHeap[id] = std::move(vals);
+  return id;
 }
 
-void EVALVisitor::visit(PrintStatement *stm) {
-  Exp *e = stm->expr;
-
-  // 1) String literal directo
-  if (auto se = dynamic_cast<StringExp *>(e)) {
-    cout << se->value;
-
-    // 2) IndexExp sobre lista de strings
-  } else if (auto ie = dynamic_cast<IndexExp *>(e)) {
-    int listId = env.lookup(ie->name);
-    int idx = ie->index->accept(this);
-    auto it = stringListHeap.find(listId);
-    if (it != stringListHeap.end()) {
-      // imprimimos el elemento string
-      cout << it->second[idx];
-    } else {
-      // cae en lista de ints: usamos el valor numérico
-      cout << ie->accept(this);
-    }
-
-    // 3) Cualquier otro caso: lo tratamos como Int
-  } else {
-    cout << e->accept(this);
-  }
-
+Flow EVALVisitor::visit(AssignStatement *stm) {
+  // 1) Evaluar RHS
+  int val = accept(stm->expr);
+
+  match(stm->target,
+        Overload{
+            // 2) Asignación a variable simple
+            [&](IdentifierExp *id) {
+              if (!id->bind.resolved()) {
+                std::cerr << "Variable no declarada: " << id->name << "\n";
+                return;
+              }
+              slot(id->bind) = val;
+            },
+            // 3) Asignación a array[index]
+            [&](IndexExp *idx) {
+              // asumimos que la variable es un array de enteros en
+              // listHeap[id]
+              int arrId = slot(idx->bind);
+              int i = accept(idx->index);
+              listHeap[arrId][i] = val;
+            },
+            // 4) Asignación a struct.field
+            [&](DotExp *dot) {
+              int objId = slot(dot->bind);
+              objectHeap[objId][fieldIndex(dot->field)] = val;
+            },
+            // 5) Cualquier otro LHS no es válido
+            [](Exp *) {
+              std::cerr << "Asignación inválida en LHS no identificador\n";
+            }});
+  return {};
+}
+
+Flow EVALVisitor::visit(PrintStatement *stm) {
+  printValue(stm->expr);
   cout << endl;
+  return {};
 }
 
-void EVALVisitor::visit(ReturnStatement *stm) {
-  retval = stm->expr ? stm->expr->accept(this) : 0;
+// El tipo que dejó TypeChecker dice cómo mostrar el valor
+void EVALVisitor::printValue(Exp *e) {
+  int v = accept(e);
+  if (e->type == Type::String())
+    cout << Symbol(v).str();
+  else
+    cout << v;
 }
 
-void EVALVisitor::visit(IfStatement *stm) {
-  if (stm->cond->accept(this))
-    stm->thenBranch->accept(this);
-  else if (stm->elseBranch)
-    stm->elseBranch->accept(this);
+// El valor de 'return' sube como resultado hasta la llamada (ver FCallExp)
+Flow EVALVisitor::visit(ReturnStatement *stm) {
+  return {true, stm->expr ? accept(stm->expr) : 0};
 }
 
-void EVALVisitor::visit(WhileStatement *stm) {
-  while (stm->cond->accept(this))
-    stm->body->accept(this);
+Flow EVALVisitor::visit(IfStatement *stm) {
+  if (accept(stm->cond))
+    return accept(stm->thenBranch);
+  if (stm->elseBranch)
+    return accept(stm->elseBranch);
+  return {};
 }
 
-void EVALVisitor::visit(ForStatement *stm) {
+Flow EVALVisitor::visit(WhileStatement *stm) {
+  while (accept(stm->cond)) {
+    Flow f = accept(stm->body);
+    if (f.returned)
+      return f;
+  }
+  return {};
+}
+
+Flow EVALVisitor::visit(ForStatement *stm) {
   // only numeric ranges supported
-  if (auto loop = dynamic_cast<LoopExp *>(stm->iterable)) {
-    int start = loop->start->accept(this);
-    int end = loop->end->accept(this);
-    int step = loop->step ? loop->step->accept(this) : (loop->downTo ? -1 : 1);
-    env.add_level();
+  Flow f;
+  if (auto loop = node_cast<LoopExp>(stm->iterable)) {
+    int start = accept(loop->start);
+    int end = accept(loop->end);
+    int step = loop->step ? accept(loop->step) : (loop->downTo ? -1 : 1);
     for (int i = start; loop->downTo ? i >= end : i <= end; i += step) {
-      env.add_var(stm->varName, "int");
-      env.update(stm->varName, i);
-      stm->body->accept(this);
+      slot(stm->bind) = i;
+      f = accept(stm->body);
+      if (f.returned)
+        break;
     }
-    env.remove_level();
   }
+  return f;
 }
 
+// Los nombres de un VarDec ocupan slots consecutivos desde dec->bind
 void EVALVisitor::visit(VarDec *dec) {
-  for (size_t i = 0; i < dec->names.size(); ++i) {
-    const string &nm = dec->names[i];
-    string tname = dec->typeName;
-    // inferir List<Int> si viene de listOf()
-    if (tname.empty() && i < dec->inits.size() && dec->inits[i]) {
-      if (auto fc = dynamic_cast<FCallExp *>(dec->inits[i])) {
-        if (fc->name == "listOf" || fc->name == "mutableListOf")
-          tname = "List<Int>";
-      }
-    }
-    // si tiene init, lo evaluamos y registramos con valor
-    if (i < dec->inits.size() && dec->inits[i]) {
-      int v = dec->inits[i]->accept(this);
-      env.add_var(nm, v, tname);
-    }
-    // si no, valor por defecto 0
-    else {
-      env.add_var(nm, tname);
-    }
+  Binding b = dec->bind;
+  for (size_t i = 0; i < dec->names.size(); ++i, ++b.slot) {
+    // si tiene init, lo evaluamos; si no, valor por defecto 0
+    int v = 0;
+    if (i < dec->inits.size() && dec->inits[i])
+      v = accept(dec->inits[i]);
+    slot(b) = v;
   }
 }
 
 void EVALVisitor::visit(VarDecList *list) {
   for (auto dec : list->vars)
-    dec->accept(this);
+    accept(dec);
 }
 
-void EVALVisitor::visit(ClassDec *dec) {
-  vector<string> fields;
-  for (auto &arg : dec->args)
-    fields.push_back(arg.name);
-  for (auto *vdl : dec->members->vars)
-    for (auto &nm : vdl->names)
-      fields.push_back(nm);
-  classFields_[dec->name] = move(fields);
-}
+// Los constructores ya apuntan a su ClassDec (FCallExp::cls) y ésta a su
+// layout: no hay nada que registrar
+void EVALVisitor::visit(ClassDec *) {}
+void EVALVisitor::visit(ClassDecList *) {}
 
-void EVALVisitor::visit(ClassDecList *cdl) {
-  for (auto c : cdl->classes) {
-    classFields_[c->name] = vector<string>();
-    for (auto arg : c->args)
-      classFields_[c->name].push_back(arg.name);
-    c->members->accept(this);
-  }
-}
+// Las llamadas ya apuntan a su FunDec (FCallExp::fn): no hay nada que
+// registrar
+void EVALVisitor::visit(FunDec *) {}
 
-void EVALVisitor::visit(FunDec *fn) { fdecs[fn->name] = fn; }
+void EVALVisitor::visit(FunDecList *) {}
 
-void EVALVisitor::visit(FunDecList *list) {
-  for (auto f : list->functions) {
-    fdecs[f->name] = f;
+// Se corta en el primer 'return'
+Flow EVALVisitor::visit(StatementList *list) {
+  for (auto s : list->statements) {
+    Flow f = accept(s);
+    if (f.returned)
+      return f;
   }
+  return {};
 }
 
-void EVALVisitor::visit(StatementList *list) {
-  for (auto s : list->statements)
-    s->accept(this);
-}
-
-void EVALVisitor::visit(Body *body) {
-  env.add_level();
-  body->vardecs->accept(this);
-  body->stmts->accept(this);
-  env.remove_level();
+// Las variables del bloque ya tienen su slot en el frame de la función
+Flow EVALVisitor::visit(Body *body) {
+  accept(body->vardecs);
+  return accept(body->stmts);
 }
 
 void EVALVisitor::visit(Program *prog) { ejecutar(prog); }
 
 //----------------------------------------------------------------------
 // Constructor
-template <typename T> GenCodeVisitor<T>::GenCodeVisitor(T &out) : out_(out) {}
+template <typename T>
+GenCodeVisitor<T>::GenCodeVisitor(T &out)
+    : out_(&out), jobs_(defaultJobs()), g_(&globals_) {}
+
+template <typename T>
+GenCodeVisitor<T>::GenCodeVisitor(const Globals *globals, Symbol fn)
+    : out_(nullptr), labelTag_("_" + fn.str() + "_"), jobs_(1), g_(globals) {}
 
 // Generación principal
 template <typename T> void GenCodeVisitor<T>::generate(Program *prog) {
-  prog->accept(this);
+  this->accept(prog);
 }
 
 // Etiquetas únicas
 template <typename T>
 std::string GenCodeVisitor<T>::newLabel(const std::string &prefix) {
-  return prefix + std::to_string(labelCount_++);
+  return prefix + labelTag_ + std::to_string(labelCount_++);
+}
+
+template <typename T>
+std::string GenCodeVisitor<T>::operand(const Binding &b, Symbol name) const {
+  if (b.isLocal())
+    return std::to_string(slotOffset(b.slot)) + "(%rbp)";
+  return name.str() + "(%rip)";
 }
 
 // ── Expresiones ──
 
-template <typename T> int GenCodeVisitor<T>::visit(StringExp *e) {
+template <typename T> void GenCodeVisitor<T>::visit(StringExp *e) {
   // 1) genera un label único en .rodata con el literal
-  std::string lbl = "";
   // Checks if the string is already labeled
-  if (auto find = stringLabel_.find(e->value); find != stringLabel_.end()) {
-    lbl = stringLabel_[e->value];
-  } else {
+  std::string lbl = stringLabel(e->value);
+  if (lbl.empty()) {
     lbl = newLabel("str");
     stringLabel_[e->value] = lbl;
     data << lbl << ": .string \"" << e->value << "\"\n";
@@ -754,42 +641,52 @@ template <typename T> int GenCodeVisitor<T>::visit(StringExp *e) {
   if (!inGlobal_) {
     text << "  movq $" << lbl << "(%rip)" << ", %rax\n";
   }
-  return 0;
+  return;
 }
 
-template <typename T> int GenCodeVisitor<T>::visit(NumberExp *e) {
+template <typename T> void GenCodeVisitor<T>::visit(NumberExp *e) {
   text << "  movq $" << e->value << ", %rax\n";
-  return 0;
+  return;
 }
 
-template <typename T> int GenCodeVisitor<T>::visit(BoolExp *e) {
+template <typename T> void GenCodeVisitor<T>::visit(BoolExp *e) {
   text << "  movq $" << (e->value ? 1 : 0) << ", %rax\n";
-  return 0;
+  return;
 }
 
-template <typename T> int GenCodeVisitor<T>::visit(IdentifierExp *e) {
-  if (memoria.count(e->name)) {
-    // local variable, so search in memory
-    int off = memoria.at(e->name);
-    text << "  movq " << off << "(%rbp), %rax\n";
+template <typename T> void GenCodeVisitor<T>::visit(IdentifierExp *e) {
+  if (arrayInitDepth_ > 0 && e->name == sym::it) {
+    // índice del lambda de IntArray/Array (ver visit(ArrayInitExp*))
+    text << "  movq %r12, %rax\n";
   } else {
-    // variable global
-    text << "  movq " << e->name << "(%rip), %rax\n";
+    // slot local o variable global
+    text << "  movq " << operand(e->bind, e->name) << ", %rax\n";
+  }
+  return;
+}
+
+// La espina izquierda se recorre con un bucle (ver pushLeftSpine): cada
+// nivel encuentra su operando izquierdo ya calculado en %rax
+template <typename T> void GenCodeVisitor<T>::visit(BinaryExp *e) {
+  size_t base = spine_.size();
+  // Evalúa el primer operando, deja en %rax
+  this->accept(pushLeftSpine(e, spine_));
+  while (spine_.size() > base) {
+    BinaryExp *b = spine_.back();
+    spine_.pop_back();
+    // Guarda %rax en la pila
+    text << "  pushq %rax\n";
+    // Evalúa la derecha, deja en %rax
+    this->accept(b->right);
+    // Recupera izquierda de la pila a %rcx
+    text << " movq %rax, %rcx\n popq %rax\n";
+    emitBinop(b->op);
   }
-  return 0;
 }
 
-template <typename T> int GenCodeVisitor<T>::visit(BinaryExp *e) {
-  // Evalúa la izquierda, deja en %rax
-  e->left->accept(this);
-  // Guarda %rax en la pila
-  text << "  pushq %rax\n";
-  // Evalúa la derecha, deja en %rax
-  e->right->accept(this);
-  // Recupera izquierda de la pila a %rcx
-  text << " movq %rax, %rcx\n popq %rax\n";
-
-  switch (e->op) {
+// %rax = %rax op %rcx
+template <typename T> void GenCodeVisitor<T>::emitBinop(BinaryOp op) {
+  switch (op) {
   case PLUS_OP:
     text << "  addq %rcx, %rax\n";
     break;
@@ -835,94 +732,68 @@ template <typename T> int GenCodeVisitor<T>::visit(BinaryExp *e) {
   default:
     break;
   }
-  return 0;
+  return;
 }
 
-template <typename T> int GenCodeVisitor<T>::visit(IndexExp *e) {
+template <typename T> void GenCodeVisitor<T>::visit(IndexExp *e) {
   // 1) Evaluar el índice → %rax
-  e->index->accept(this);
+  this->accept(e->index);
 
-  // 2) Cargar la dirección base del array en %rbx
-  if (memoria.count(e->name)) {
-    int off = memoria.at(e->name);
-    text << "  lea " << off << "(%rbp), %rbx\n"; // &var
-    text << "  movq (%rbx), %rbx\n";             // ptr heap
-  } else {
-    text << "  movq " << e->name << "(%rip), %rbx\n"; // global
-  }
+  // 2) Cargar la dirección base del array (ptr al heap) en %rbx
+  text << "  movq " << operand(e->bind, e->name) << ", %rbx\n";
 
-  // 3) Determinar tamaño de elemento (por defecto 8)
-  int esz = 8;
-  auto itSize = elemSize_.find(e->name);
-  if (itSize != elemSize_.end())
-    esz = itSize->second;
-
-  // 4) Indexación distinta para booleanArrayOf (1 byte) vs resto
-  if (booleanArrs_.count(e->name)) {
-    // offset = idx * 1
-    text << "  lea    (%rbx,%rax,1), %rbx\n";
-    text << "  movzbq (%rbx), %rax\n";
-  } else {
-    if (esz == 8) {
-      text << "  salq $3, %rax\n";
-    } else {
-      text << "  imulq  $" << esz << ", %rax" << esz << "\n";
-    }
-    text << "  addq   %rax, %rbx\n";
-    text << "  movq   (%rbx), %rax\n";
-  }
+  // 3) Todos los elementos ocupan 8 bytes (también Boolean)
+  text << "  salq $3, %rax\n";
+  text << "  addq   %rax, %rbx\n";
+  text << "  movq   (%rbx), %rax\n";
 
-  return 0;
+  return;
 }
 
-template <typename T> int GenCodeVisitor<T>::visit(DotExp *exp) {
+template <typename T> void GenCodeVisitor<T>::visit(DotExp *exp) {
   // 1) puntero al objeto anidado
-  int off = memoria.at(exp->id);
-  text << "  movq " << off << "(%rbp), %rax\n";
+  text << "  movq " << operand(exp->bind, exp->id) << ", %rax\n";
   text << "  movq %rax, %rbx\n";
 
-  // 2) averiguar el tipo de ese objeto
-  std::string objType = memoriaTypes_.at(exp->id);
-
-  // 3) sumar offset del campo en esa clase
-  int fldOff = structLayouts_.at(objType).at(exp->member);
+  // 2) sumar offset del campo en la clase del objeto (TypeChecker)
+  int fldOff = exp->field->offset;
   if (fldOff != 0) {
     text << "  addq $" << fldOff << ", %rbx\n";
   }
 
-  // 4) cargar campo
+  // 3) cargar campo
   text << "  movq (%rbx), %rax\n";
-  return 0;
+  return;
 }
 
-template <typename T> int GenCodeVisitor<T>::visit(LoopExp *exp) {
+template <typename T> void GenCodeVisitor<T>::visit(LoopExp *exp) {
   // Generación mínima: evalúa el inicio y devuelve un valor ficticio
-  exp->start->accept(this);
-  return 0;
+  this->accept(exp->start);
+  return;
 }
 
-template <typename T> int GenCodeVisitor<T>::visit(IFExp *e) {
+template <typename T> void GenCodeVisitor<T>::visit(IFExp *e) {
   auto Lelse = newLabel("Lelse");
   auto Lend = newLabel("Lend");
   // condición
-  e->cond->accept(this);
+  this->accept(e->cond);
   text << "  cmpq $0, %rax\n";
   text << "  je " << Lelse << "\n";
   // then
-  e->left->accept(this);
+  this->accept(e->left);
   text << "  jmp " << Lend << "\n";
   text << Lelse << ":\n";
   // else
-  e->right->accept(this);
+  this->accept(e->right);
   text << Lend << ":\n";
-  return 0;
+  return;
 }
 
-template <typename T> int GenCodeVisitor<T>::visit(ListExp *e) {
+template <typename T> void GenCodeVisitor<T>::visit(ListExp *e) {
   size_t n = e->elements.size();
 
   // A) Lista de String: malloc de punteros + llenar con labels
-  if (n > 0 && dynamic_cast<StringExp *>(e->elements[0])) {
+  if (n > 0 && node_cast<StringExp>(e->elements[0])) {
     text << "  movq $" << (n * 8) << ", %rdi\n"
          << "  call malloc@PLT\n"
          << "  movq %rax, %rbx\n";
@@ -932,7 +803,7 @@ template <typename T> int GenCodeVisitor<T>::visit(ListExp *e) {
       // strings from lists
       // TODO
       auto txt = static_cast<StringExp *>(e->elements[i])->value;
-      auto lbl = stringLabel_[txt];
+      auto lbl = stringLabel(txt);
       text << "  leaq " << lbl << "(%rip), %rax\n"
            << "  movq %rax, " << (i * 8) << "(%rbx)\n";
     }
@@ -944,7 +815,7 @@ template <typename T> int GenCodeVisitor<T>::visit(ListExp *e) {
     for (size_t i = 0; i < n; ++i) {
       // Saves the pointer towards the space allocated with malloc
       text << "  pushq %rax\n";
-      e->elements[i]->accept(this); // → %rax = valor entero
+      this->accept(e->elements[i]); // → %rax = valor entero
       text << "  movq %rax, %rcx\n";
       // Pops to have the rax pointer saved at the start
       text << "  popq %rax\n";
@@ -952,61 +823,90 @@ template <typename T> int GenCodeVisitor<T>::visit(ListExp *e) {
       text << "  movq %rcx, " << (i * 8) << "(%rax)\n";
     }
   }
-  return 0;
-}
-
-template <typename T> int GenCodeVisitor<T>::visit(FCallExp *e) {
-  // 0) Constructor de struct/clase si existe layout
-  auto it = structLayouts_.find(e->name);
-  if (it != structLayouts_.end()) {
-    // número de campos
-    // 1. Sum number of variables and number of variables declared
-    int nFields = structLayouts_[e->name].size();
-    // 2. Reserver memory
-    text << "  movq $" << (nFields * 8) << ", %rdi\n"
-         << "  call malloc@PLT\n";
-    // 3. Unload the args, assume the args are only for the constructor,
-    // so the args of call and class are equal Then go for variables
-    // Fill every field in order: args[i] → offset i*8
-    int nFieldsConstructor = structFieldConstructorsOrder_[e->name].size();
-    for (size_t i = 0; i < nFieldsConstructor; ++i) {
-      string fieldName = structFieldConstructorsOrder_[e->name][i];
-      int offField = structLayouts_[e->name][fieldName];
-      // Saves the pointer towards the memory reserved
-      text << "  pushq %rax\n";
-      e->args[i]->accept(this); // → %rax = valor de arg
-      // Saves result in rcx
-      text << "  movq %rax, %rcx\n";
-      // Pops to have the rax pointer saved at the start
-      text << "  popq %rax\n";
-      // Uses rax to access the index values
-      text << "  movq %rcx, " << offField << "(%rax)\n";
-    }
+  return;
+}
+
+// Array con lambda → bucle de llenado. Usa registros callee-saved (guardados
+// para permitir anidar): %r12 = it, %r13 = n, %r15 = puntero al heap.
+// Devuelve el puntero en %rax y la longitud en %rdx.
+template <typename T> void GenCodeVisitor<T>::visit(ArrayInitExp *e) {
+  this->accept(e->size); // → %rax = n
+  text << "  pushq %r12\n"
+       << "  pushq %r13\n"
+       << "  pushq %r15\n"
+       << "  subq $8, %rsp\n" // mantiene la alineación de 16 bytes
+       << "  movq %rax, %r13\n";
+
+  if (e->isZeroFill()) {
+    // cuerpo constante 0: calloc ya deja la memoria en cero
+    text << "  movq %r13, %rdi\n"
+         << "  movq $8, %rsi\n"
+         << "  call calloc@PLT\n"
+         << "  movq %rax, %r15\n";
+  } else {
+    auto Lloop = newLabel("Linit");
+    auto Lend = newLabel("Lendinit");
+    text << "  leaq 0(,%r13,8), %rdi\n"
+         << "  call malloc@PLT\n"
+         << "  movq %rax, %r15\n"
+         << "  movq $0, %r12\n"
+         << Lloop << ":\n"
+         << "  cmpq %r13, %r12\n"
+         << "  jge " << Lend << "\n";
+    arrayInitDepth_++;
+    this->accept(e->body); // → %rax = valor del elemento
+    arrayInitDepth_--;
+    text << "  movq %rax, (%r15,%r12,8)\n"
+         << "  incq %r12\n"
+         << "  jmp " << Lloop << "\n"
+         << Lend << ":\n";
+  }
+
+  text << "  movq %r15, %rax\n"
+       << "  movq %r13, %rdx\n"
+       << "  addq $8, %rsp\n"
+       << "  popq %r15\n"
+       << "  popq %r13\n"
+       << "  popq %r12\n";
+  return;
+}
 
-    // 4. Init variables
-    for (auto v : structFieldInits_[e->name]) {
-      int offField = structLayouts_[e->name][v.first];
+template <typename T> void GenCodeVisitor<T>::visit(FCallExp *e) {
+  // 0) Constructor de struct/clase: el layout lo armó TypeChecker
+  if (ClassDec *cls = e->cls) {
+    // 1. Reserve memory
+    text << "  movq $" << cls->bytes << ", %rdi\n"
+         << "  call malloc@PLT\n";
+    // 2. Fill every field in layout order: the args go to the constructor
+    // fields, then the members with a default value
+    for (size_t i = 0; i < cls->layout.size(); ++i) {
+      const Field &f = cls->layout[i];
+      Exp *value = i < cls->args.size()
+                       ? (i < e->args.size() ? e->args[i] : nullptr)
+                       : f.init;
+      if (!value)
+        continue;
       // Saves the pointer towards the memory reserved
       text << "  pushq %rax\n";
-      v.second->accept(this); // → %rax = valor de arg
+      this->accept(value); // → %rax = valor del campo
       // Saves result in rcx
       text << "  movq %rax, %rcx\n";
       // Pops to have the rax pointer saved at the start
       text << "  popq %rax\n";
       // Uses rax to access the index values
-      text << "  movq %rcx, " << offField << "(%rax)\n";
+      text << "  movq %rcx, " << f.offset << "(%rax)\n";
     }
 
     // Dont' forget to clean!!!
     // TODO
-    return 0;
+    return;
   } else {
     // fun call
     // 1) Evaluar parametros dados
     vector<std::string> argRegs = {"%rdi", "%rsi", "%rdx",
                                    "%rcx", "%r8",  "%r9"};
     for (int i = 0; i < e->args.size(); i++) {
-      e->args[i]->accept(this);
+      this->accept(e->args[i]);
       text << " movq %rax," << argRegs[i] << endl;
     }
 
@@ -1014,30 +914,27 @@ template <typename T> int GenCodeVisitor<T>::visit(FCallExp *e) {
     text << "  call " << e->name << "\n";
 
     // Resultado en %rax
-    return 0;
+    return;
   }
 }
 
 // ── Sentencias ──
 template <typename T> void GenCodeVisitor<T>::visit(AssignStatement *s) {
   // 1) evaluar RHS -> %rax
-  s->expr->accept(this);
+  this->accept(s->expr);
 
   // 2) caso var local
-  if (auto id = dynamic_cast<IdentifierExp *>(s->target)) {
-    int off = memoria.at(id->name);
-    text << "  movq %rax, " << off << "(%rbp)\n";
+  if (auto id = node_cast<IdentifierExp>(s->target)) {
+    text << "  movq %rax, " << operand(id->bind, id->name) << "\n";
     return;
-  } else if (auto idx = dynamic_cast<IndexExp *>(s->target)) {
+  } else if (auto idx = node_cast<IndexExp>(s->target)) {
     // 3) caso array[index]
     // push rax of expr
     text << "  pushq %rax\n";
 
-    int off = memoria.at(idx->name);
     // Obtains the address. It's kind of dealing with pointers
-    text << "  lea " << off << "(%rbp), %rbx\n"
-         << "  movq (%rbx), %rbx\n";
-    idx->index->accept(this);
+    text << "  movq " << operand(idx->bind, idx->name) << ", %rbx\n";
+    this->accept(idx->index);
     // Shifts the bits of rax by 3 positions
     // This is to move the index the correct number of positions
     text << "  salq $3, %rax\n"
@@ -1047,17 +944,13 @@ template <typename T> void GenCodeVisitor<T>::visit(AssignStatement *s) {
     text << "  popq %rax\n";
     text << "  movq %rax, (%rbx)\n";
     return;
-  } else if (auto dot = dynamic_cast<DotExp *>(s->target)) {
+  } else if (auto dot = node_cast<DotExp>(s->target)) {
     // 4) caso struct.field
-    // evaluar objeto para dejar puntero en %rax
-    int off = memoria.at(dot->id);
-
     // offset del campo
-    string structType = memoriaTypes_.at(dot->id);
-    int fldOff = structLayouts_.at(structType).at(dot->member);
+    int fldOff = dot->field->offset;
 
     // escribir el valor
-    text << "  movq " << off << "(%rbp)" << ", %rcx\n";
+    text << "  movq " << operand(dot->bind, dot->id) << ", %rcx\n";
     text << "  movq %rax," << fldOff << " (%rcx)\n";
     return;
   }
@@ -1067,32 +960,12 @@ template <typename T> void GenCodeVisitor<T>::visit(AssignStatement *s) {
 }
 
 template <typename T> void GenCodeVisitor<T>::visit(PrintStatement *s) {
-  s->expr->accept(this);
+  this->accept(s->expr);
   text << "  movq %rax, %rsi\n";
-  // Needs to determinate which print use: print_string or print_fmt
-  // This depends on the output
-  // Needs to simplify the logic
-  if (auto stringexp = dynamic_cast<StringExp *>(s->expr)) {
+  // El formato sale del tipo que dejó TypeChecker
+  if (s->expr->type == Type::String()) {
     text << "  leaq print_string(%rip), %rdi\n";
-  } else if (auto idexp = dynamic_cast<IdentifierExp *>(s->expr)) {
-    if (memoriaTypes_[idexp->name] == "String") {
-      text << "  leaq print_string(%rip), %rdi\n";
-    } else {
-      text << "  leaq print_fmt(%rip), %rdi\n";
-    }
-  }
-  // else if (auto indexp = dynamic_cast<IndexExp *>(s->expr);
-  //            memoriaTypes_[indexp->name].substr(
-  //                memoriaTypes_[indexp->name].find('<') + 1,
-  //                memoriaTypes_[indexp->name].find('>') -
-  //                    memoriaTypes_[indexp->name].find('<') + 1) == "String")
-  //                    {
-  //   cout << "Index exp" << endl;
-  //   // TODO
-  //   // Fix and simplify logic and use logic for classes
-  //   text << "  leaq print_string(%rip), %rdi\n";
-  // }
-  else {
+  } else {
     text << "  leaq print_fmt(%rip), %rdi\n";
   }
 
@@ -1104,16 +977,16 @@ template <typename T> void GenCodeVisitor<T>::visit(IfStatement *s) {
   auto Lelse = newLabel("Lelse");
   auto Lend = newLabel("Lend");
   // if
-  s->cond->accept(this);
+  this->accept(s->cond);
   text << "  cmpq $0, %rax\n";
   text << "  je " << Lelse << "\n";
   // then
-  s->thenBranch->accept(this);
+  this->accept(s->thenBranch);
   text << "  jmp " << Lend << "\n";
   // else
   text << Lelse << ":\n";
   if (s->elseBranch)
-    s->elseBranch->accept(this);
+    this->accept(s->elseBranch);
   text << Lend << ":\n";
 }
 
@@ -1121,35 +994,36 @@ template <typename T> void GenCodeVisitor<T>::visit(WhileStatement *s) {
   auto Lbegin = newLabel("while");
   auto Lend = newLabel("endwhile");
   text << Lbegin << ":\n";
-  s->cond->accept(this);
+  this->accept(s->cond);
   text << "  cmpq $0, %rax\n";
   text << "  je " << Lend << "\n";
-  s->body->accept(this);
+  this->accept(s->body);
   text << "  jmp " << Lbegin << "\n";
   text << Lend << ":\n";
 }
 
 template <typename T> void GenCodeVisitor<T>::visit(ForStatement *s) {
-  // 1) Crear espacio para la variable de iteración
-  stackFor_ += 8;
-  memoria[s->varName] = -stackFor_ - stackSize_;
-  text << " subq $" << 8 << ", %rsp" << endl;
+  // 1) La variable y el índice ya tienen slot en el frame (resolver)
+  std::string var = operand(s->bind, s->varName);
+  Binding indexSlot = s->bind;
+  indexSlot.slot++;
+  std::string index = operand(indexSlot, s->varName);
 
   // 2) Distinguir rango numérico o lista
-  if (auto loop = dynamic_cast<LoopExp *>(s->iterable)) {
+  if (auto loop = node_cast<LoopExp>(s->iterable)) {
     // 2.1) Define the start, the end and the step to make the comparisons
-    loop->start->accept(this); // -> %rax
-    text << "  movq %rax, " << memoria[s->varName] << "(%rbp)\n";
+    this->accept(loop->start); // -> %rax
+    text << "  movq %rax, " << var << "\n";
 
     // 2.2) Bucle con etiquetas
     auto Lfor = newLabel("for");
     auto Lend = newLabel("endfor");
     text << Lfor << ":\n";
     // cargar end
-    loop->end->accept(this); // -> %rax
+    this->accept(loop->end); // -> %rax
     text << " movq %rax, %rcx\n ";
     // cargar i
-    text << "  movq " << memoria[s->varName] << "(%rbp), %rax\n";
+    text << "  movq " << var << ", %rax\n";
 
     // compare, code from GE case in binary
     text << "  cmpq %rcx, %rax\n"
@@ -1159,10 +1033,10 @@ template <typename T> void GenCodeVisitor<T>::visit(ForStatement *s) {
     text << "  cmpq $0, %rax\n";
     text << "  jne " << Lend << "\n";
     // cuerpo
-    s->body->accept(this);
+    this->accept(s->body);
     // i += step
 
-    loop->step->accept(this);
+    this->accept(loop->step);
     // This isn't working correctly
     // TODO
     if (loop->downTo) {
@@ -1170,31 +1044,32 @@ template <typename T> void GenCodeVisitor<T>::visit(ForStatement *s) {
     }
     // update start with step
     text << " movq %rax, %rcx\n ";
-    text << "  movq " << memoria[s->varName] << "(%rbp), %rax\n";
+    text << "  movq " << var << ", %rax\n";
 
     text << "  addq %rcx, %rax\n";
-    text << "  movq %rax, " << memoria[s->varName] << "(%rbp)\n";
+    text << "  movq %rax, " << var << "\n";
     text << "  jmp " << Lfor << "\n";
     text << Lend << ":\n";
   } else {
     // 1) inicializar índice = 0
-    text << "  movq $0, " << memoriaIndex_[s->varName] << "(%rbp)\n";
+    text << "  movq $0, " << index << "\n";
 
     // 2) cargar sólo UNA VEZ la dirección base del array en %r14
     auto id = static_cast<IdentifierExp *>(s->iterable);
-    if (memoria.count(id->name)) {
-      // array/lista local en pila
-      int offList = memoria.at(id->name);
-      text << "  lea " << offList << "(%rbp), %rax\n" // &local
-           << "  movq (%rax), %r14\n";                // ptr heap -> r14
+    // array/lista local en pila o global en .data: ptr heap -> r14
+    text << "  movq " << operand(id->bind, id->name) << ", %r14\n";
+
+    // 3) longitud: constante o, si sólo se conoce en ejecución, <name>_len
+    std::string bound;
+    if (g_->listLength_.count(id->name)) {
+      bound = "$" + std::to_string(g_->listLength_.at(id->name));
+    } else if (g_->runtimeLength_.count(id->name)) {
+      bound = id->name.str() + "_len(%rip)";
     } else {
-      // array global en .data
-      text << "  movq " << id->name << "(%rip), %r14\n";
+      throw std::runtime_error("Longitud desconocida para recorrer " +
+                               id->name.str());
     }
 
-    // 3) longitud
-    int n = listLength_.at(id->name);
-
     // 4) etiquetas
     std::string Lfor = newLabel("Lfor");
     std::string Lend = newLabel("Lend");
@@ -1203,27 +1078,27 @@ template <typename T> void GenCodeVisitor<T>::visit(ForStatement *s) {
     text << Lfor
          << ":\n"
          // cargar índice
-         << "  movq " << memoriaIndex_[s->varName] << "(%rbp), %rax\n"
-         << "  cmpq $" << n << ", %rax\n"
+         << "  movq " << index << ", %rax\n"
+         << "  cmpq " << bound << ", %rax\n"
          << "  jge " << Lend
          << "\n"
 
          // calcular dirección en %rdx
-         << "  movq " << memoriaIndex_[s->varName] << "(%rbp), %rdx\n"
+         << "  movq " << index << ", %rdx\n"
          << "  salq $3, %rdx\n"
          << "  addq %r14, %rdx\n"
 
          // cargar elemento y guardarlo en varName
          << "  movq (%rdx), %rax\n"
-         << "  movq %rax, " << memoria[s->varName] << "(%rbp)\n";
+         << "  movq %rax, " << var << "\n";
 
     // 8) cuerpo
-    s->body->accept(this);
+    this->accept(s->body);
 
     // 9) incrementar índice y saltar
-    text << "  movq " << memoriaIndex_[s->varName] << "(%rbp), %rax\n"
+    text << "  movq " << index << ", %rax\n"
          << "  addq $1, %rax\n"
-         << "  movq %rax, " << memoriaIndex_[s->varName] << "(%rbp)\n"
+         << "  movq %rax, " << index << "\n"
          << "  jmp " << Lfor << "\n"
          << Lend << ":\n";
   }
@@ -1233,69 +1108,52 @@ template <typename T> void GenCodeVisitor<T>::visit(ForStatement *s) {
 
 template <typename T> void GenCodeVisitor<T>::visit(VarDec *d) {
   for (size_t i = 0; i < d->names.size(); ++i) {
-    const auto &name = d->names[i];
-    // 1) Guardar el tipo: si hay anotación explícita, la usamos;
-    //    si no y viene de un constructor (FCallExp), inferimos el tipo.
-    if (!d->typeName.empty()) {
-      memoriaTypes_[name] = d->typeName;
-    } else if (i < d->inits.size()) {
-      if (auto *fc = dynamic_cast<FCallExp *>(d->inits[i])) {
-        memoriaTypes_[name] = fc->name; // inferimos "P" de P()
-      }
-    }
+    Symbol name = d->names[i];
 
     // If in global, needs to declare the quad in data to can be used anywhere
     if (inGlobal_) {
-      // 2) Marcar la variable como global
-      memoriaGlobal[name] = true;
-
-      // 3) Por defecto, 8 bytes por elemento
-      elemSize_[name] = 8;
+      // Marcar la variable como global
+      globals_.memoriaGlobal.push_back(name);
 
       // Si se inicializa
       if (i < d->inits.size() && d->inits[i]) {
-        if (auto *num = dynamic_cast<NumberExp *>(d->inits[i])) {
+        if (auto *num = node_cast<NumberExp>(d->inits[i])) {
           data << name << ": .quad " << num->value << "\n";
           continue; // skip resto (no malloc)
-        } else if (auto *str = dynamic_cast<StringExp *>(d->inits[i])) {
+        } else if (auto *str = node_cast<StringExp>(d->inits[i])) {
           // Si es inicialización con string
-          str->accept(this);
+          this->accept(str);
           string valString = str->value;
-          std::string label = stringLabel_[valString];
+          std::string label = stringLabel(valString);
           data << name << ": .quad " << label << "\n";
           continue; // skip resto
-        } else if (auto *le = dynamic_cast<ListExp *>(d->inits[i])) {
+        } else if (auto *le = node_cast<ListExp>(d->inits[i])) {
           // Si es una lista (ya tienes esto bien)
-          listLength_[name] = (int)le->elements.size();
-          globalInits_[name] = le;
-
-          bool allBool = true;
-          for (auto *el : le->elements) {
-            if (!dynamic_cast<BoolExp *>(el)) {
-              allBool = false;
-              break;
-            }
-          }
-          if (allBool) {
-            elemSize_[name] = 1;
-            booleanArrs_.insert(name);
-          }
+          globals_.listLength_[name] = (int)le->elements.size();
+          globals_.globalInits_[name] = le;
 
           // Create global label to can be used as a pointer towards the list
           data << name << ": .quad " << 0 << "\n";
+        } else if (auto *ai = node_cast<ArrayInitExp>(d->inits[i])) {
+          // Array con lambda: se reserva y llena en main con un bucle
+          globals_.globalArrayInits_[name] = ai;
+          if (auto *num = node_cast<NumberExp>(ai->size)) {
+            globals_.listLength_[name] = (int)num->value;
+          } else {
+            globals_.runtimeLength_.insert(name);
+            data << name << "_len: .quad 0\n";
+          }
+          data << name << ": .quad 0\n";
         }
       }
-    } else {
-      // variables locales sin cambios
-      stackSize_ += 8;
-      memoria[name] = -stackSize_ - stackFor_;
     }
+    // las locales ya tienen su slot en el frame (ver visit(FunDec*))
   }
 }
 
 template <typename T> void GenCodeVisitor<T>::visit(VarDecList *l) {
   for (auto v : l->vars)
-    v->accept(this);
+    this->accept(v);
 }
 
 template <typename T> void GenCodeVisitor<T>::visit(FunDec *f) {
@@ -1307,30 +1165,24 @@ template <typename T> void GenCodeVisitor<T>::visit(FunDec *f) {
   this->nombreFuncion = f->name;
 
   // If inside, main declare list global variables
-  if (nombreFuncion == "main") {
-    for (auto &pr : memoriaGlobal) {
-      const std::string &name = pr.first;
+  if (nombreFuncion == sym::main) {
+    for (Symbol name : g_->memoriaGlobal) {
 
       // Solo inicializar en main si es una lista o array (es decir, está en
       // globalInits_)
-      if (globalInits_.count(name)) {
-        int n = listLength_.at(name);     // longitud
-        auto *le = globalInits_.at(name); // ListExp*
-        int esz = elemSize_.at(name);
+      if (g_->globalInits_.count(name)) {
+        int n = g_->listLength_.at(name);     // longitud
+        auto *le = g_->globalInits_.at(name); // ListExp*
 
         // 1. Reservar el heap
-        text << "  movq $" << (n * esz) << ", %rdi\n"
+        text << "  movq $" << (n * 8) << ", %rdi\n"
              << "  call malloc@PLT\n"
              << "  pushq %rax\n";
         // 2. Assing initial values
         for (size_t i = 0; i < n; ++i) {
           text << "  pushq %rax\n";
-          le->elements[i]->accept(this); // → %rax = valor entero
-          if (esz == 1) {
-            text << "  movq %al, %rcx\n";
-          } else {
-            text << "  movq %rax, %rcx\n";
-          }
+          this->accept(le->elements[i]); // → %rax = valor entero
+          text << "  movq %rax, %rcx\n";
           // Pops to have the rax pointer saved at the start
           text << "  popq %rax\n";
           // Uses rax to access the index values
@@ -1341,101 +1193,113 @@ template <typename T> void GenCodeVisitor<T>::visit(FunDec *f) {
 
         // 3. Guardar puntero en la etiqueta global
         text << "  movq %rax, " << name << "(%rip)\n\n";
+      } else if (g_->globalArrayInits_.count(name)) {
+        this->accept(g_->globalArrayInits_.at(name)); // %rax = ptr, %rdx = n
+        text << "  movq %rax, " << name << "(%rip)\n";
+        if (g_->runtimeLength_.count(name))
+          text << "  movq %rdx, " << name << "_len(%rip)\n";
+        text << "\n";
       }
     }
   }
 
-  memoria.clear();
-  stackSize_ = 0;
+  // Frame completo de una vez (params + todas las locales, ver resolver),
+  // redondeado a 16 bytes para que las llamadas queden alineadas
+  int frameBytes = (f->frameSize * 8 + 15) & ~15;
+  if (frameBytes > 0)
+    text << "  subq $" << frameBytes << ", %rsp\n";
 
   static const char *argRegs[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
-  for (size_t i = 0; i < f->params.size() && i < 6; ++i) {
-    auto &p = f->params[i];
-    stackSize_ += 8;
-    memoria[p.name] = -stackSize_;
-    memoriaTypes_[p.name] = p.type;
-    text << "  movq " << argRegs[i] << ", " << memoria[p.name] << "(%rbp)\n";
-  }
+  for (size_t i = 0; i < f->params.size() && i < 6; ++i)
+    text << "  movq " << argRegs[i] << ", " << slotOffset(i) << "(%rbp)\n";
   text << "\n";
 
-  f->body->accept(this);
+  this->accept(f->body);
 
   text << ".end_" << f->name << ":" << endl;
   text << "leave" << endl;
   text << "ret" << endl;
 
-  this->nombreFuncion = "";
+  this->nombreFuncion = Symbol();
 }
 
+// Cada función se genera con su propio visitor (etiquetas, literales y
+// buffers propios; las globales y los layouts de clase sólo se leen), en
+// paralelo, y el resultado se junta en el orden del fuente: la salida no
+// depende de cuántos hilos se usen
 template <typename T> void GenCodeVisitor<T>::visit(FunDecList *list) {
-  for (auto fn : list->functions) {
-    fn->accept(this);
+  auto &fns = list->functions;
+  std::vector<FunctionCode> code(fns.size());
+  std::vector<std::exception_ptr> errors(fns.size());
+  parallelFor(fns.size(), jobs_, [&](size_t i) {
+    try {
+      code[i] = genFunction(fns[i]);
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  });
+  for (auto &e : errors)
+    if (e)
+      std::rethrow_exception(e);
+  for (auto &c : code) {
+    data << c.data;
+    text << c.text;
   }
 }
 
-template <typename T> void GenCodeVisitor<T>::visit(ClassDec *dec) {
-  int offset = 0;
-  // Also add the arguments
-  // Separate it for the constructor
-  for (auto arg : dec->args) {
-    // 1) Graba el offset
-    structLayouts_[dec->name][arg.name] = offset;
-    // 2) Graba el tipo del campo
-    structFieldTypes_[dec->name][arg.name] = arg.type;
-    structFieldConstructorsOrder_[dec->name].push_back(arg.name);
-    // 3) Siguiente campo a +8 bytes
-    offset += 8;
-  }
-  for (auto *var : dec->members->vars) {
-    for (int i = 0; i < var->names.size(); i++) {
-      // 1) Graba el offset
-      structLayouts_[dec->name][var->names[i]] = offset;
-      // 2) Graba el tipo del campo
-      structFieldTypes_[dec->name][var->names[i]] = var->typeName;
-      // 3) Siguiente campo a +8 bytes
-      offset += 8;
-      // 4) Add initializer
-      if (i < var->inits.size() && var->inits[i]) {
-        structFieldInits_[dec->name][var->names[i]] = var->inits[i];
-      }
-    }
-  }
+template <typename T>
+typename GenCodeVisitor<T>::FunctionCode
+GenCodeVisitor<T>::genFunction(FunDec *fn) const {
+  Span span(fn->name.str(), "función"); // sólo mide con --trace
+  GenCodeVisitor worker(g_, fn->name);
+  worker.accept(fn);
+  return {worker.data.str(), worker.text.str()};
+}
+
+// Primero los del encabezado (compartidos), después los de este visitor
+template <typename T>
+std::string GenCodeVisitor<T>::stringLabel(const std::string &value) const {
+  if (auto it = g_->strings.find(value); it != g_->strings.end())
+    return it->second;
+  auto it = stringLabel_.find(value);
+  return it != stringLabel_.end() ? it->second : "";
 }
 
+// El layout (offsets y valores por defecto) ya está en ClassDec::layout y
+// lo usan directamente el constructor y los accesos a campos
+template <typename T> void GenCodeVisitor<T>::visit(ClassDec *) {}
+
 template <typename T> void GenCodeVisitor<T>::visit(ClassDecList *list) {
   for (auto cls : list->classes) {
-    cls->accept(this);
+    this->accept(cls);
   }
 }
 
 template <typename T> void GenCodeVisitor<T>::visit(StatementList *l) {
   for (auto s : l->statements)
-    s->accept(this);
+    this->accept(s);
 }
 
 template <typename T> void GenCodeVisitor<T>::visit(Body *b) {
-  // 1. Reserva para las variables
-  b->vardecs->accept(this);
-  if (stackSize_ > 0) {
-    text << "  subq $" << stackSize_ + stackFor_ << ", %rsp\n\n";
-  }
+  // 1. Tipos de las variables (el espacio ya se reservó en el prólogo)
+  this->accept(b->vardecs);
 
   // 2. Inicializa las variables locales con sus valores
   for (auto *d : b->vardecs->vars) {
     for (size_t i = 0; i < d->inits.size(); ++i) {
       if (!d->inits[i])
         continue;
-      d->inits[i]->accept(this); // calcula el valor → %rax
-      text << "  movq %rax, " << memoria[d->names[i]] << "(%rbp)\n";
+      this->accept(d->inits[i]); // calcula el valor → %rax
+      text << "  movq %rax, " << slotOffset(d->bind.slot + i) << "(%rbp)\n";
     }
   }
   text << "\n";
 
   // 3. Acepta statements
-  b->stmts->accept(this);
+  this->accept(b->stmts);
 }
 
-template <typename T> void GenCodeVisitor<T>::visit(Program *prog) {
+template <typename T> void GenCodeVisitor<T>::emitHeader(Program *prog) {
   data << ".data\n";
   data << "print_fmt: .string \"%ld\\n\"\n\n";
   data << "print_string: .string \"%s\\n\"\n\n";
@@ -1443,27 +1307,53 @@ template <typename T> void GenCodeVisitor<T>::visit(Program *prog) {
   // Variables
   // 2.b) Variables globales (listas)
   inGlobal_ = true;
-  prog->vardecs->accept(this);
+  this->accept(prog->vardecs);
 
   inGlobal_ = false;
 
   // 2.c) clases/globales si tuvieras más…
-  prog->classDecs->accept(this);
+  this->accept(prog->classDecs);
+
+  // Los literales de las globales pasan a ser los compartidos
+  globals_.strings = std::move(stringLabel_);
+  stringLabel_.clear();
 
   // — PASO 3: emitimos text
   text << "\n.text\n\n";
+}
+
+template <typename T> void GenCodeVisitor<T>::visit(Program *prog) {
+  emitHeader(prog);
 
   // ahora vienen los FunDec
-  prog->funDecs->accept(this);
+  this->accept(prog->funDecs);
 
   text << ".section .note.GNU-stack,\"\",@progbits\n";
 
-  out_ << data.str() << text.str();
+  *out_ << data.str() << text.str();
+}
+
+template <typename T> void GenCodeVisitor<T>::beginProgram(Program *prog) {
+  emitHeader(prog);
+  *out_ << data.str() << text.str();
+  data.str("");
+  text.str("");
+}
+
+template <typename T> void GenCodeVisitor<T>::emitFunction(FunDec *fn) {
+  FunctionCode code = genFunction(fn);
+  *out_ << code.text;
+  if (!code.data.empty())
+    *out_ << ".data\n" << code.data << ".text\n";
+}
+
+template <typename T> void GenCodeVisitor<T>::endProgram() {
+  *out_ << ".section .note.GNU-stack,\"\",@progbits\n";
 }
 
 template <typename T> void GenCodeVisitor<T>::visit(ReturnStatement *s) {
   if (s->expr)
-    s->expr->accept(this); // valor → %rax
+    this->accept(s->expr); // valor → %rax
   text << " jmp .end_" << this->nombreFuncion << endl;
 }
 
@@ -2,12 +2,13 @@
 #ifndef VISITOR_H
 #define VISITOR_H
 
-#include "environment.h"
 #include "exp.h"
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 class Program;
 class VarDecList;
@@ -39,237 +40,315 @@ class ListExp;
 class IndexExp;
 class DotExp;
 class LoopExp;
-
-// Visitor interface
-class Visitor {
+class ArrayInitExp;
+
+// Base de todos los visitors, con despacho estático (CRTP): Derived define
+// un visit(...) por cada tipo de nodo y accept(...) elige el overload con un
+// switch sobre el 'kind' del nodo, sin llamadas virtuales. ExpR y StmR son
+// los tipos de resultado de expresiones y sentencias; el resto de nodos
+// (declaraciones, listas, Body, Program) devuelven lo que declare Derived.
+template <typename Derived, typename ExpR = int, typename StmR = void>
+class VisitorBase {
 public:
-  // Expressions
-  virtual int visit(BinaryExp *exp) = 0;
-  virtual int visit(IFExp *exp) = 0;
-  virtual int visit(StringExp *exp) = 0;
-  virtual int visit(NumberExp *exp) = 0;
-  virtual int visit(BoolExp *exp) = 0;
-  virtual int visit(IdentifierExp *exp) = 0;
-  virtual int visit(FCallExp *exp) = 0;
-  virtual int visit(ListExp *exp) = 0;
-  virtual int visit(IndexExp *exp) = 0;
-  virtual int visit(DotExp *exp) = 0;
-  virtual int visit(LoopExp *exp) = 0;
-
-  // Statements / declarations
-  virtual void visit(AssignStatement *stm) = 0;
-  virtual void visit(PrintStatement *stm) = 0;
-  virtual void visit(IfStatement *stm) = 0;
-  virtual void visit(WhileStatement *stm) = 0;
-  virtual void visit(ForStatement *stm) = 0;
-  virtual void visit(ReturnStatement *stm) = 0;
-
-  virtual void visit(VarDec *dec) = 0;
-  virtual void visit(VarDecList *list) = 0;
-  virtual void visit(ClassDec *dec) = 0;
-  virtual void visit(ClassDecList *list) = 0;
-  virtual void visit(FunDec *dec) = 0;
-  virtual void visit(FunDecList *list) = 0;
-
-  virtual void visit(StatementList *list) = 0;
-  virtual void visit(Body *body) = 0;
-  virtual void visit(Program *prog) = 0;
-
-  virtual ~Visitor() = default;
+  using ExpResult = ExpR;
+  using StmResult = StmR;
+
+  ExpR accept(Exp *e) {
+    return match(e, [this](auto *n) -> ExpR { return self().visit(n); });
+  }
+  StmR accept(Stm *s) {
+    return match(s, [this](auto *n) -> StmR { return self().visit(n); });
+  }
+  // Tipo ya conocido en compilación: llamada directa
+  template <typename Node> decltype(auto) accept(Node *n) {
+    return self().visit(n);
+  }
+
+protected:
+  Derived &self() { return static_cast<Derived &>(*this); }
+};
+
+// Resultado de ejecutar una sentencia en EVALVisitor: si se ejecutó un
+// 'return' (que corta el resto del cuerpo) y con qué valor
+struct Flow {
+  bool returned = false;
+  int value = 0;
 };
 
 //----------------------------------------------------------------------
 // PrintVisitor: “pretty prints” the AST to stdout
 //----------------------------------------------------------------------
 
-class PrintVisitor : public Visitor {
+class PrintVisitor : public VisitorBase<PrintVisitor, void, void> {
 public:
   int indent = 0;
   int step = 2;
 
   void imprimir(Program *program);
 
-  int visit(BinaryExp *exp) override;
-  int visit(IFExp *exp) override;
-  int visit(StringExp *exp) override;
-  int visit(NumberExp *exp) override;
-  int visit(BoolExp *exp) override;
-  int visit(IdentifierExp *exp) override;
-  int visit(FCallExp *exp) override;
-  int visit(ListExp *exp) override;
-  int visit(IndexExp *exp) override;
-  int visit(DotExp *exp) override;
-  int visit(LoopExp *exp) override;
-
-  void visit(AssignStatement *stm) override;
-  void visit(PrintStatement *stm) override;
-  void visit(IfStatement *stm) override;
-  void visit(WhileStatement *stm) override;
-  void visit(ForStatement *stm) override;
-  void visit(ReturnStatement *stm) override;
-
-  void visit(VarDec *dec) override;
-  void visit(VarDecList *list) override;
-  void visit(ClassDec *dec) override;
-  void visit(ClassDecList *list) override;
-  void visit(FunDec *dec) override;
-  void visit(FunDecList *list) override;
-
-  void visit(StatementList *list) override;
-  void visit(Body *body) override;
-  void visit(Program *prog) override;
+  void visit(BinaryExp *exp);
+  void visit(IFExp *exp);
+  void visit(StringExp *exp);
+  void visit(NumberExp *exp);
+  void visit(BoolExp *exp);
+  void visit(IdentifierExp *exp);
+  void visit(FCallExp *exp);
+  void visit(ListExp *exp);
+  void visit(IndexExp *exp);
+  void visit(DotExp *exp);
+  void visit(LoopExp *exp);
+  void visit(ArrayInitExp *exp);
+
+  void visit(AssignStatement *stm);
+  void visit(PrintStatement *stm);
+  void visit(IfStatement *stm);
+  void visit(WhileStatement *stm);
+  void visit(ForStatement *stm);
+  void visit(ReturnStatement *stm);
+
+  void visit(VarDec *dec);
+  void visit(VarDecList *list);
+  void visit(ClassDec *dec);
+  void visit(ClassDecList *list);
+  void visit(FunDec *dec);
+  void visit(FunDecList *list);
+
+  void visit(StatementList *list);
+  void visit(Body *body);
+  void visit(Program *prog);
+
+private:
+  std::vector<BinaryExp *> spine; // ver visit(BinaryExp*)
 };
 
 //----------------------------------------------------------------------
 // EVALVisitor: interprets the AST in-memory (for testing)
 //----------------------------------------------------------------------
 
-class EVALVisitor : public Visitor {
-  Environment env;
-  std::unordered_map<std::string, FunDec *> fdecs;
-  int retval;
+// Requiere un programa ya resuelto y chequeado (resolver.h, typecheck.h):
+// las variables se leen de frames planos por (depth, slot), las llamadas van
+// directo al FunDec y cada Exp trae su tipo (un String vale el id de su
+// texto internado).
+class EVALVisitor : public VisitorBase<EVALVisitor, int, Flow> {
+  // Globales en su propio frame; los frames de las llamadas se apilan en
+  // 'stack' y el de la función en curso empieza en 'base'
+  std::vector<int> globals;
+  std::vector<int> stack;
+  size_t base = 0;
+  int &slot(const Binding &b) {
+    return b.isLocal() ? stack[base + b.slot] : globals[b.slot];
+  }
   // Heap interno para literales de lista
   std::unordered_map<int, std::vector<int>> listHeap;
-  std::unordered_map<int, std::vector<std::string>> stringListHeap;
   int nextListId = 1;
 
   // Para asignar IDs únicos a cada instancia
   int nextObjectId = 1;
-  // Para saber el orden de los campos de cada clase
-  // class ->
-  std::unordered_map<std::string, std::vector<std::string>> classFields_;
-  std::unordered_map<std::string, std::vector<Exp *>>
-      classFieldInits_; // nombre de clase → expresiones iniciales
-  // “Heap” de objetos: objectId -> map(campo -> valor)
-  std::unordered_map<int, std::unordered_map<std::string, int>> objectHeap;
+  // “Heap” de objetos: objectId -> un valor por campo, en el orden de
+  // ClassDec::layout
+  std::unordered_map<int, std::vector<int>> objectHeap;
+  static size_t fieldIndex(const Field *f) {
+    return f->offset / Type::kSlotSize;
+  }
+
+  void printValue(Exp *e);
+
+  std::vector<BinaryExp *> spine; // ver visit(BinaryExp*)
+  static int apply(BinaryOp op, int v1, int v2);
 
 public:
   void ejecutar(Program *program);
 
-  int visit(BinaryExp *exp) override;
-  int visit(IFExp *exp) override;
-  int visit(StringExp *exp) override;
-  int visit(NumberExp *exp) override;
-  int visit(BoolExp *exp) override;
-  int visit(IdentifierExp *exp) override;
-  int visit(FCallExp *exp) override;
-  int visit(ListExp *exp) override;
-  int visit(IndexExp *exp) override;
-  int visit(DotExp *exp) override;
-  int visit(LoopExp *exp) override;
-
-  void visit(AssignStatement *stm) override;
-  void visit(PrintStatement *stm) override;
-  void visit(IfStatement *stm) override;
-  void visit(WhileStatement *stm) override;
-  void visit(ForStatement *stm) override;
-  void visit(ReturnStatement *stm) override;
-
-  void visit(VarDec *dec) override;
-  void visit(VarDecList *list) override;
-  void visit(ClassDec *dec) override;
-  void visit(ClassDecList *list) override;
-  void visit(FunDec *dec) override;
-  void visit(FunDecList *list) override;
-
-  void visit(StatementList *list) override;
-  void visit(Body *body) override;
-  void visit(Program *prog) override;
+  int visit(BinaryExp *exp);
+  int visit(IFExp *exp);
+  int visit(StringExp *exp);
+  int visit(NumberExp *exp);
+  int visit(BoolExp *exp);
+  int visit(IdentifierExp *exp);
+  int visit(FCallExp *exp);
+  int visit(ListExp *exp);
+  int visit(IndexExp *exp);
+  int visit(DotExp *exp);
+  int visit(LoopExp *exp);
+  int visit(ArrayInitExp *exp);
+
+  Flow visit(AssignStatement *stm);
+  Flow visit(PrintStatement *stm);
+  Flow visit(IfStatement *stm);
+  Flow visit(WhileStatement *stm);
+  Flow visit(ForStatement *stm);
+  Flow visit(ReturnStatement *stm);
+
+  void visit(VarDec *dec);
+  void visit(VarDecList *list);
+  void visit(ClassDec *dec);
+  void visit(ClassDecList *list);
+  void visit(FunDec *dec);
+  void visit(FunDecList *list);
+
+  Flow visit(StatementList *list);
+  Flow visit(Body *body);
+  void visit(Program *prog);
 };
 
 //----------------------------------------------------------------------
 // GenCodeVisitor: genera ensamblador x86-64 recorriendo el AST
 //----------------------------------------------------------------------
 
-template <typename T> class GenCodeVisitor : public Visitor {
+// Requiere un programa ya resuelto y chequeado (resolver.h, typecheck.h):
+// cada función reserva su frame entero en el prólogo, el slot i vive en
+// -8*(i+1)(%rbp) y el formato de print o la clase de un DotExp salen de los
+// tipos ya anotados.
+
+template <typename T>
+class GenCodeVisitor : public VisitorBase<GenCodeVisitor<T>, void, void> {
 public:
   GenCodeVisitor(T &out);
 
   // Lanza la generación: .data, .text, prologue/epilogue y recorre el programa
   void generate(Program *prog);
 
+  // Lo mismo por partes (ver streaming.h), escribiendo en out a medida que
+  // avanza: el encabezado (.data con las globales) con el Program de
+  // Parser::parseHeader, cada función apenas se genera y el cierre. Los
+  // literales que aparecen en una función van en su propia sección .data
+  // después de su código.
+  void beginProgram(Program *prog);
+  void emitFunction(FunDec *fn);
+  void endProgram();
+
+  // Hilos para generar las funciones (ver visit(FunDecList*)); por defecto
+  // los del hardware. La salida es la misma con cualquier valor.
+  void setJobs(unsigned jobs) { jobs_ = jobs; }
+
+  // Tablas y buffers del generador después de generate() (ver
+  // --mem-report): f(nombre, entradas, bytes aproximados) por cada uno. Los
+  // visitors de cada función se liberan al terminarla y no aparecen.
+  template <typename F> void forEachStructure(F &&f) const;
+
   // – Expresiones
-  int visit(BinaryExp *exp) override;
-  int visit(IFExp *exp) override;
-  int visit(StringExp *exp) override;
-  int visit(NumberExp *exp) override;
-  int visit(BoolExp *exp) override;
-  int visit(IdentifierExp *exp) override;
-  int visit(FCallExp *exp) override;
-  int visit(ListExp *exp) override;
-  int visit(IndexExp *exp) override;
-  int visit(DotExp *exp) override;
-  int visit(LoopExp *exp) override;
+  void visit(BinaryExp *exp);
+  void visit(IFExp *exp);
+  void visit(StringExp *exp);
+  void visit(NumberExp *exp);
+  void visit(BoolExp *exp);
+  void visit(IdentifierExp *exp);
+  void visit(FCallExp *exp);
+  void visit(ListExp *exp);
+  void visit(IndexExp *exp);
+  void visit(DotExp *exp);
+  void visit(LoopExp *exp);
+  void visit(ArrayInitExp *exp);
 
   // – Sentencias / declaraciones
-  void visit(AssignStatement *stm) override;
-  void visit(PrintStatement *stm) override;
-  void visit(IfStatement *stm) override;
-  void visit(WhileStatement *stm) override;
-  void visit(ForStatement *stm) override;
-  void visit(ReturnStatement *stm) override;
-
-  void visit(VarDec *dec) override;
-  void visit(VarDecList *list) override;
-  void visit(ClassDec *dec) override;
-  void visit(ClassDecList *list) override;
-  void visit(FunDec *dec) override;
-  void visit(FunDecList *list) override;
-
-  void visit(StatementList *list) override;
-  void visit(Body *body) override;
-  void visit(Program *prog) override;
+  void visit(AssignStatement *stm);
+  void visit(PrintStatement *stm);
+  void visit(IfStatement *stm);
+  void visit(WhileStatement *stm);
+  void visit(ForStatement *stm);
+  void visit(ReturnStatement *stm);
+
+  void visit(VarDec *dec);
+  void visit(VarDecList *list);
+  void visit(ClassDec *dec);
+  void visit(ClassDecList *list);
+  void visit(FunDec *dec);
+  void visit(FunDecList *list);
+
+  void visit(StatementList *list);
+  void visit(Body *body);
+  void visit(Program *prog);
 
 private:
-  T &out_;
+  // Lo que dejan las globales y que las funciones sólo leen: cada función
+  // se genera con su propio visitor que apunta a esto (ver genFunction)
+  struct Globals {
+    // Globales en orden de declaración: main las inicializa en este orden,
+    // así el .s no depende del orden de un hash (ni de los ids de Symbol)
+    std::vector<Symbol> memoriaGlobal;
+    // literal -> label de los literales de las globales
+    std::unordered_map<std::string, std::string> strings;
+    // para longitudes de listas:
+    std::unordered_map<Symbol, int> listLength_; // varName -> n
+    // Mapa nuevo: nombre de lista global → su ListExp*
+    unordered_map<Symbol, ListExp *> globalInits_;
+    // Arrays globales con lambda: nombre → ArrayInitExp* (se llenan en main)
+    unordered_map<Symbol, ArrayInitExp *> globalArrayInits_;
+    // Arrays cuya longitud sólo se conoce en ejecución: se guarda en <name>_len
+    unordered_set<Symbol> runtimeLength_;
+  };
+  // Código de una función: sus literales (.data) y su texto
+  struct FunctionCode {
+    std::string data, text;
+  };
+
+  // Visitor de una sola función: sin salida propia, etiquetas con el
+  // nombre de la función
+  GenCodeVisitor(const Globals *globals, Symbol fn);
+  FunctionCode genFunction(FunDec *fn) const;
+
+  T *out_;
   stringstream data;
   stringstream text;
-  int stackSize_ = 0;
   int labelCount_ = 0;
+  std::string labelTag_; // "_<función>_" o "" en el encabezado
   bool inGlobal_ = false;
   bool collectingStrings_ = false;
-  string nombreFuncion = "";
-  int stackFor_ = 0;
+  Symbol nombreFuncion;
+  unsigned jobs_;
 
   // Needs to free the memory of lists
 
-  // Maps for variables
-  unordered_map<string, int> memoria;
-  std::unordered_map<std::string, int>
-      memoriaIndex_; // para los índices de los for
-  unordered_map<string, bool> memoriaGlobal;
-  std::unordered_map<std::string, std::string> memoriaTypes_;
-
-  // Maps for class declarations
-  // class -> field -> offset
-  // The offset is for the location in heap
-  std::unordered_map<std::string, std::unordered_map<std::string, int>>
-      structLayouts_;
-  // class -> field -> type
-  std::unordered_map<std::string, std::unordered_map<std::string, std::string>>
-      structFieldTypes_;
-  // class -> field -> Exp*
-  // Saves the default values for the fields
-  std::unordered_map<std::string, std::unordered_map<std::string, Exp *>>
-      structFieldInits_;
-  // class -> arguments
-  // Saves the order for the passes arguments for the constructor
-  std::unordered_map<std::string, std::vector<std::string>>
-      structFieldConstructorsOrder_;
+  Globals globals_;        // las escribe el encabezado
+  const Globals *g_;       // las que se leen: &globals_ o las del encabezado
 
   std::string newLabel(const std::string &prefix);
-
-  // para strings:
-  std::unordered_map<std::string, std::string> stringLabel_; // literal -> label
-  // para longitudes de listas:
-  std::unordered_map<std::string, int> listLength_; // varName -> n
-
-  // Mapa nuevo: nombre de lista global → su ListExp*
-  unordered_map<string, ListExp *> globalInits_;
-
-  // Mapa para booleans
-  unordered_map<std::string, int> elemSize_;
-  unordered_set<std::string> booleanArrs_;
+  // Operando de una variable resuelta: su slot en el frame o, si es global
+  // (o no se resolvió), su etiqueta en .data
+  static int slotOffset(uint32_t slot) { return -8 * (int(slot) + 1); }
+  std::string operand(const Binding &b, Symbol name) const;
+
+  std::vector<BinaryExp *> spine_; // ver visit(BinaryExp*)
+  void emitBinop(BinaryOp op);
+  // .data inicial: formatos de print y globales
+  void emitHeader(Program *prog);
+
+  // para strings: literal -> label, los que aparecen en este visitor
+  std::unordered_map<std::string, std::string> stringLabel_;
+  // label de un literal ya emitido ("" si no está)
+  std::string stringLabel(const std::string &value) const;
+
+  // Dentro del lambda de un ArrayInitExp, 'it' vive en %r12
+  int arrayInitDepth_ = 0;
 };
 
+// Bytes de una tabla hash: nodos (valor, siguiente y hash) y buckets; no
+// cuenta el texto de los strings largos
+template <typename M> size_t hashTableBytes(const M &m) {
+  return m.size() * (sizeof(typename M::value_type) + 2 * sizeof(void *)) +
+         m.bucket_count() * sizeof(void *);
+}
+
+template <typename T>
+template <typename F>
+void GenCodeVisitor<T>::forEachStructure(F &&f) const {
+  const Globals &g = globals_;
+  f("memoriaGlobal", g.memoriaGlobal.size(),
+    g.memoriaGlobal.capacity() * sizeof(Symbol));
+  f("strings", g.strings.size(), hashTableBytes(g.strings));
+  f("listLength_", g.listLength_.size(), hashTableBytes(g.listLength_));
+  f("globalInits_", g.globalInits_.size(), hashTableBytes(g.globalInits_));
+  f("globalArrayInits_", g.globalArrayInits_.size(),
+    hashTableBytes(g.globalArrayInits_));
+  f("runtimeLength_", g.runtimeLength_.size(),
+    hashTableBytes(g.runtimeLength_));
+  f("stringLabel_", stringLabel_.size(), hashTableBytes(stringLabel_));
+  // Los buffers por líneas y bytes escritos
+  for (auto *buf : {&data, &text}) {
+    std::string s = buf->str();
+    f(buf == &data ? "data" : "text",
+      size_t(std::count(s.begin(), s.end(), '\n')), s.size());
+  }
+}
+
 #endif // VISITOR_H